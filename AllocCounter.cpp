@@ -0,0 +1,98 @@
+#include "AllocCounter.h"
+
+#ifdef EGRIM_ALLOC_HOOK
+
+//! The number of allocations made by the current thread.
+static thread_local uint64_t thread_allocs = 0;
+
+//-----------------------------------------------------------------------------
+//! @brief Allocates a block of memory, counting the allocation against the
+//! calling thread.
+//! @param size The number of bytes requested.
+//! @return A pointer to the allocated block.
+//-----------------------------------------------------------------------------
+void* operator new(size_t size) {
+
+	// Declare all relevant variables.
+	void* ptr;
+
+	// Count the allocation, then satisfy it from the C runtime heap.
+	++thread_allocs;
+	ptr = malloc(size ? size : 1);
+	if (ptr == NULL) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Allocates a block of memory for an array, counting the allocation
+//! against the calling thread.
+//! @param size The number of bytes requested.
+//! @return A pointer to the allocated block.
+//-----------------------------------------------------------------------------
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Frees a block of memory allocated by the counting operators.
+//! @param ptr A pointer to the allocated block.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Frees an array allocated by the counting operators.
+//! @param ptr A pointer to the allocated block.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void operator delete[](void* ptr) noexcept {
+	free(ptr);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Frees a block of memory of known size.
+//! @param ptr A pointer to the allocated block.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Frees an array of known size.
+//! @param ptr A pointer to the allocated block.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void operator delete[](void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+//! @brief Returns whether the counting operators are installed.
+//! @return True, if allocations are being counted, false otherwise.
+//-----------------------------------------------------------------------------
+bool AllocCounter::enabled() {
+#ifdef EGRIM_ALLOC_HOOK
+	return true;
+#else
+	return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of allocations made by the calling thread.
+//! @return The allocation count, or zero if the hook is not installed.
+//-----------------------------------------------------------------------------
+uint64_t AllocCounter::count() {
+#ifdef EGRIM_ALLOC_HOOK
+	return thread_allocs;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "stdafx.h"
+#include <new>
+
+//=============================================================================
+//! @class AllocCounter
+//!
+//! @brief Counts the heap allocations made by each thread through the global
+//! operator new. The counting operators are only installed when the project
+//! is built with EGRIM_ALLOC_HOOK defined, as it is in the debug
+//! configurations.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class AllocCounter {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn enabled
+	//!
+	//! @brief Returns whether the counting operators are installed.
+	//-------------------------------------------------------------------------
+	static bool enabled();
+
+	//-------------------------------------------------------------------------
+	//! @fn count
+	//!
+	//! @brief Returns the number of allocations made by the calling thread.
+	//-------------------------------------------------------------------------
+	static uint64_t count();
+};
@@ -0,0 +1,342 @@
+#include "BatchGenerator.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+//! @brief Adds each offset to a base value, and keeps the upper bits of each
+//! sum, one lane at a time.
+//! @param base The value common to every lane.
+//! @param offsets A pointer to the offset of each lane.
+//! @param shift The number of low bits discarded from each sum.
+//! @param out A pointer to a memory location which shall be populated.
+//! @param count The number of lanes.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+static void sumShiftScalar(uint64_t base, const uint64_t* offsets, uint32_t
+	shift, uint32_t* out, uint32_t count) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	for (i = 0; i < count; ++i) {
+		out[i] = (uint32_t)((base + offsets[i]) >> shift);
+	}
+}
+
+#ifdef LAYOUT_SSE2
+
+//-----------------------------------------------------------------------------
+//! @brief Adds each offset to a base value, and keeps the upper bits of each
+//! sum, four lanes at a time.
+//! @param base The value common to every lane.
+//! @param offsets A pointer to the offset of each lane.
+//! @param shift The number of low bits discarded from each sum.
+//! @param out A pointer to a memory location which shall be populated.
+//! @param count The number of lanes.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+static void sumShiftSSE2(uint64_t base, const uint64_t* offsets, uint32_t
+	shift, uint32_t* out, uint32_t count) {
+
+	// Declare all relevant variables.
+	__m128i b;
+	__m128i s;
+	__m128i lo;
+	__m128i hi;
+	uint32_t i;
+
+	// Each register holds two 64-bit sums, and the low halves of two
+	// registers are gathered into a single store.
+	b = _mm_set1_epi64x((long long)base);
+	s = _mm_cvtsi32_si128((int)shift);
+	for (i = 0; i + 4 <= count; i += 4) {
+		lo = _mm_srl_epi64(_mm_add_epi64(b, _mm_loadu_si128((const __m128i*)(
+			offsets + i))), s);
+		hi = _mm_srl_epi64(_mm_add_epi64(b, _mm_loadu_si128((const __m128i*)(
+			offsets + i + 2))), s);
+		lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 0, 2, 0));
+		hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 0, 2, 0));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi64(lo, hi));
+	}
+	sumShiftScalar(base, offsets + i, shift, out + i, count - i);
+}
+
+#endif
+
+#ifdef BATCH_AVX2
+
+//-----------------------------------------------------------------------------
+//! @brief Adds each offset to a base value, and keeps the upper bits of each
+//! sum, eight lanes at a time.
+//! @param base The value common to every lane.
+//! @param offsets A pointer to the offset of each lane.
+//! @param shift The number of low bits discarded from each sum.
+//! @param out A pointer to a memory location which shall be populated.
+//! @param count The number of lanes.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+static void sumShiftAVX2(uint64_t base, const uint64_t* offsets, uint32_t
+	shift, uint32_t* out, uint32_t count) {
+
+	// Declare all relevant variables.
+	__m256i b;
+	__m256i lo;
+	__m256i hi;
+	__m256i gather;
+	__m128i s;
+	uint32_t i;
+
+	// Each register holds four 64-bit sums. Their low halves are gathered
+	// into the lower lane of each register, and the two lanes are joined
+	// into a single store.
+	b = _mm256_set1_epi64x((long long)base);
+	s = _mm_cvtsi32_si128((int)shift);
+	gather = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	for (i = 0; i + 8 <= count; i += 8) {
+		lo = _mm256_srl_epi64(_mm256_add_epi64(b, _mm256_loadu_si256((const
+			__m256i*)(offsets + i))), s);
+		hi = _mm256_srl_epi64(_mm256_add_epi64(b, _mm256_loadu_si256((const
+			__m256i*)(offsets + i + 4))), s);
+		lo = _mm256_permutevar8x32_epi32(lo, gather);
+		hi = _mm256_permutevar8x32_epi32(hi, gather);
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_permute2x128_si256(lo,
+			hi, 0x20));
+	}
+	sumShiftScalar(base, offsets + i, shift, out + i, count - i);
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a BatchGenerator instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+BatchGenerator::BatchGenerator() : positions(), sample_words(), phase(0),
+	phase_offsets(), kernel(KERNEL_SCALAR), program(NULL) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Prepares the generator to follow the given sample. The packet 
+//! number and IRIG time are left clear, for the transmitter stamps both as it
+//! releases each packet.
+//! @param smpl The sample preceding the first packet, with its rotation rate
+//! already set.
+//! @param program The scan program, compiled from the same sample, which 
+//! traces the antenna positions, or NULL to follow the sample's step.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void BatchGenerator::init(Packet smpl, ScanProgram* program) {
+
+	// Declare all relevant variables.
+	uint64_t step;
+	uint32_t i;
+
+	// Encode the sample once in host order, take the starting phase from it,
+	// and clear the fields set per packet from the words.
+	smpl.convert(sample_words);
+	for (i = 0; i < PACKET_WORDS; ++i) {
+		sample_words[i] = PacketLayout::fromWire(sample_words[i]);
+	}
+	phase = smpl.getAntPhase();
+	PacketLayout::clear<FIELD_PACKET_NUMBER>(sample_words);
+	PacketLayout::clear<FIELD_IRIG_TIME>(sample_words);
+	PacketLayout::clear<FIELD_ANTENNA_POSITION>(sample_words);
+
+	// Tabulate the advance of each lane, so that every lane of a batch is
+	// found by a single addition to the base phase.
+	step = smpl.getAntStep();
+	for (i = 0; i < BATCH_LANES; ++i) {
+		phase_offsets[i] = (uint64_t)(i + 1) * step;
+	}
+	kernel = detect();
+	this->program = program;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Advances the antenna positions by a number of transmission periods.
+//! @param count The number of periods, no greater than BATCH_LANES.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void BatchGenerator::advance(uint32_t count) {
+
+	// Nothing need be done for an empty batch.
+	if (count == 0) {
+		return;
+	}
+	if (count > BATCH_LANES) {
+		count = BATCH_LANES;
+	}
+
+	// A scan program traces the positions itself, one segment at a time, and
+	// a constant rotation is filled by the kernel selected at initialization.
+	if (program != NULL) {
+		program->advance(positions, count);
+	}
+#ifdef BATCH_AVX2
+	else if (kernel == KERNEL_AVX2) {
+		sumShiftAVX2(phase, phase_offsets, PHASE_SHIFT, positions, count);
+	}
+#endif
+#ifdef LAYOUT_SSE2
+	else if (kernel == KERNEL_SSE2) {
+		sumShiftSSE2(phase, phase_offsets, PHASE_SHIFT, positions, count);
+	}
+#endif
+	else {
+		sumShiftScalar(phase, phase_offsets, PHASE_SHIFT, positions, count);
+	}
+
+	// Carry the base phase past the final lane.
+	phase = program != NULL ? program->getPhase() : phase + phase_offsets[
+		count - 1];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Writes the most recently advanced packets as contiguous words, in
+//! the wire byte order.
+//! @param arr A pointer to a memory location of count * PACKET_WORDS words
+//! which shall be populated.
+//! @param count The number of packets, no greater than the number advanced.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void BatchGenerator::write(uint32_t* arr, uint32_t count) {
+
+	// Declare all relevant variables.
+	uint32_t* words;
+	uint32_t i;
+
+	// Place the position of each packet over the sample words, then order 
+	// the whole run for the wire in one pass.
+	for (i = 0; i < count; ++i) {
+		words = arr + (size_t)i * PACKET_WORDS;
+		memcpy(words, sample_words, sizeof(sample_words));
+		PacketLayout::set<FIELD_ANTENNA_POSITION>(words, positions[i]);
+	}
+	PacketLayout::toWire(arr, (size_t)count * PACKET_WORDS);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Advances and writes packets directly into free slots of a ring.
+//! @param ring The ring to be filled.
+//! @param limit The greatest number of packets to publish, no greater than
+//! BATCH_LANES, so that a batch may end at a chosen packet.
+//! @return The number of packets published, or zero if the ring has been
+//! closed.
+//-----------------------------------------------------------------------------
+uint32_t BatchGenerator::fill(PacketRing* ring, uint32_t limit) {
+
+	// Declare all relevant variables.
+	uint32_t* slot;
+	uint32_t count;
+	LARGE_INTEGER enqueued;
+
+	// Wait for a contiguous run of free slots, then fill and publish it, 
+	// noting the instant so that its residency within the ring is known.
+	slot = ring->acquire(limit, &count);
+	if (slot == NULL) {
+		return 0;
+	}
+	advance(count);
+	write(slot, count);
+	QueryPerformanceCounter(&enqueued);
+	ring->publish(count, enqueued.QuadPart);
+	return count;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Changes fields of every packet written from now on, by merging new
+//! values into the sample words.
+//! @param masks The bits of each word to be changed, in host byte order.
+//! @param values The new values of those bits, in host byte order.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void BatchGenerator::patch(const uint32_t* masks, const uint32_t* values) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	for (i = 0; i < PACKET_WORDS; ++i) {
+		sample_words[i] = (sample_words[i] & ~masks[i]) | (values[i] & 
+			masks[i]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the antenna phase of the most recently advanced packet.
+//! @return The antenna phase, in units of 2^-64 of a full rotation.
+//-----------------------------------------------------------------------------
+uint64_t BatchGenerator::getPhase() {
+	return phase;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the phase the next packet will add to the antenna.
+//! @return The step, modulo 2^64, which is negative for a counter-clockwise
+//! motion.
+//-----------------------------------------------------------------------------
+uint64_t BatchGenerator::getStep() {
+	return program != NULL ? program->getStep() : phase_offsets[0];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Selects the kernel used to advance the positions.
+//! @param kernel The requested kernel, which is narrowed to the widest the
+//! processor supports.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void BatchGenerator::setKernel(uint32_t kernel) {
+
+	// Declare all relevant variables.
+	uint32_t widest;
+
+	widest = detect();
+	this->kernel = kernel < widest ? kernel : widest;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the kernel used to advance the positions.
+//! @return The kernel (0=Scalar, 1=SSE2, 2=AVX2).
+//-----------------------------------------------------------------------------
+uint32_t BatchGenerator::getKernel() {
+	return kernel;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the widest kernel supported by the processor.
+//! @return The kernel (0=Scalar, 1=SSE2, 2=AVX2).
+//-----------------------------------------------------------------------------
+uint32_t BatchGenerator::detect() {
+
+	// Declare all relevant variables.
+	uint32_t widest;
+
+	widest = KERNEL_SCALAR;
+#ifdef LAYOUT_SSE2
+	widest = KERNEL_SSE2;
+#endif
+
+	// AVX2 requires both the instructions and the operating system's support
+	// for saving the wider registers.
+#ifdef BATCH_AVX2
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7) {
+		__cpuid(info, 1);
+		if ((info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+			(_xgetbv(0) & 6) == 6) {
+			__cpuidex(info, 7, 0);
+			if ((info[1] & (1 << 5)) != 0) {
+				widest = KERNEL_AVX2;
+			}
+		}
+	}
+#else
+	if (__builtin_cpu_supports("avx2")) {
+		widest = KERNEL_AVX2;
+	}
+#endif
+#endif
+	return widest;
+}
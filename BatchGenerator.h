@@ -0,0 +1,133 @@
+#pragma once
+
+#include "stdafx.h"
+#include <string.h>
+#include "Packet.h"
+#include "PacketRing.h"
+#include "ScanProgram.h"
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || \
+	defined(__AVX2__)
+#include <immintrin.h>
+#define BATCH_AVX2
+#endif
+
+// Establish the globally accessible macros.
+#define BATCH_LANES 64
+#define KERNEL_SCALAR 0
+#define KERNEL_SSE2 1
+#define KERNEL_AVX2 2
+
+//=============================================================================
+//! @class BatchGenerator
+//!
+//! @brief Advances up to BATCH_LANES packets per call, holding the antenna
+//! positions in an array. The array is filled by a vector kernel from a base
+//! phase and a table of per-lane offsets, so that no lane depends upon its
+//! neighbour, and the packets are then written directly into the slots of 
+//! the transmit ring. Any motion other than a constant rotation takes its 
+//! positions from a scan program. The packet number and IRIG time are left
+//! clear, for the transmitter stamps both at each packet's release.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class BatchGenerator {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn BatchGenerator
+	//!
+	//! @brief Constructs a BatchGenerator instance.
+	//-------------------------------------------------------------------------
+	BatchGenerator();
+
+	//-------------------------------------------------------------------------
+	//! @fn init
+	//!
+	//! @brief Prepares the generator to follow the given sample.
+	//-------------------------------------------------------------------------
+	void init(Packet smpl, ScanProgram* program = NULL);
+
+	//-------------------------------------------------------------------------
+	//! @fn advance
+	//!
+	//! @brief Advances the antenna positions by a number of transmission 
+	//! periods.
+	//-------------------------------------------------------------------------
+	void advance(uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn write
+	//!
+	//! @brief Writes the most recently advanced packets as contiguous words.
+	//-------------------------------------------------------------------------
+	void write(uint32_t* arr, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn fill
+	//!
+	//! @brief Advances and writes packets directly into free slots of a ring.
+	//-------------------------------------------------------------------------
+	uint32_t fill(PacketRing* ring, uint32_t limit = BATCH_LANES);
+
+	//-------------------------------------------------------------------------
+	//! @fn patch
+	//!
+	//! @brief Changes fields of every later packet.
+	//-------------------------------------------------------------------------
+	void patch(const uint32_t* masks, const uint32_t* values);
+
+	//-------------------------------------------------------------------------
+	//! @fn getPhase
+	//!
+	//! @brief Returns the antenna phase of the most recently advanced packet.
+	//-------------------------------------------------------------------------
+	uint64_t getPhase();
+
+	//-------------------------------------------------------------------------
+	//! @fn getStep
+	//!
+	//! @brief Returns the phase the next packet will add to the antenna.
+	//-------------------------------------------------------------------------
+	uint64_t getStep();
+
+	//-------------------------------------------------------------------------
+	//! @fn setKernel
+	//!
+	//! @brief Selects the kernel used to advance the positions.
+	//-------------------------------------------------------------------------
+	void setKernel(uint32_t kernel);
+
+	//-------------------------------------------------------------------------
+	//! @fn getKernel
+	//!
+	//! @brief Returns the kernel used to advance the positions.
+	//-------------------------------------------------------------------------
+	uint32_t getKernel();
+
+	//-------------------------------------------------------------------------
+	//! @fn detect
+	//!
+	//! @brief Returns the widest kernel supported by the processor.
+	//-------------------------------------------------------------------------
+	static uint32_t detect();
+
+	//! The antenna position of each advanced packet.
+	uint32_t positions[BATCH_LANES];
+private:
+
+	//! The host words of the sample, with the advancing fields cleared.
+	uint32_t sample_words[PACKET_WORDS];
+
+	//! The antenna phase of the most recent packet.
+	uint64_t phase;
+
+	//! The phase added after each lane, such that lane i holds (i + 1) steps.
+	uint64_t phase_offsets[BATCH_LANES];
+
+	//! The kernel used to advance the positions.
+	uint32_t kernel;
+
+	//! The scan program tracing the antenna positions, owned by the caller, 
+	//! or NULL for a constant rotation.
+	ScanProgram* program;
+};
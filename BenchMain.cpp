@@ -0,0 +1,35 @@
+#include "Benchmark.h"
+
+//-----------------------------------------------------------------------------
+//! @brief The entry point of the benchmark executable, which runs every 
+//! benchmark without the interface, so that successive builds may be compared
+//! from a script.
+//! @param argc The number of command line arguments.
+//! @param argv The command line arguments, as "[output.json] [packets]".
+//! @return A zero value, if successful, non-zero otherwise.
+//-----------------------------------------------------------------------------
+int wmain(int argc, wchar_t* argv[]) {
+
+	// Declare all relevant variables.
+	const wchar_t* path;
+	uint32_t count;
+	int err;
+
+	// Establish the output file and the number of packets from the command 
+	// line, falling back on the defaults of the interface's "/bench".
+	path = argc > 1 ? argv[1] : L"eGRIM_bench.json";
+	count = argc > 2 ? (uint32_t)wcstoul(argv[2], NULL, 10) : BENCH_PACKETS;
+	if (count < BENCH_QUEUE_LEN) {
+		count = BENCH_PACKETS;
+	}
+
+	// Run the benchmarks and report where the results were written.
+	Benchmark bench(count);
+	err = bench.report(path);
+	if (err != 0) {
+		fwprintf(stderr, L"eGRIM_Bench: cannot write %ls\n", path);
+		return err;
+	}
+	wprintf(L"eGRIM_Bench: results written to %ls\n", path);
+	return 0;
+}
@@ -0,0 +1,1973 @@
+#include "Benchmark.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a Benchmark instance.
+//! @param count The number of packets passed through each benchmark.
+//! @param queue_len The maximum length of the queue or ring under test.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+Benchmark::Benchmark(uint32_t count, uint32_t queue_len) :
+	packet_count(count), queue_length(queue_len), packet_queue(),
+	queue_mutex(), packet_ring(NULL), checksum(0) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Runs every benchmark and writes the results to a JSON file.
+//! @param path The location of the output file.
+//! @return A zero value, if successful, non-zero otherwise.
+//-----------------------------------------------------------------------------
+int Benchmark::report(const wchar_t* path) {
+
+	// Declare all relevant variables.
+	FILE* out;
+	ScanPattern pattern;
+	double mutex_pps;
+	double ring_pps;
+
+	// Run each of the benchmarks before opening the output file.
+	mutex_pps = queueMutex();
+	ring_pps = queueRing();
+
+	// Open the output file, failing if it cannot be created.
+	if (_wfopen_s(&out, path, L"w") != 0 || out == NULL) {
+		return 1;
+	}
+
+	// Write the results as a single JSON document.
+	fprintf(out, "{\n");
+	fprintf(out, "  \"schema\": %u,\n", BENCH_SCHEMA);
+#ifdef _DEBUG
+	fprintf(out, "  \"build\": \"debug\",\n");
+#else
+	fprintf(out, "  \"build\": \"release\",\n");
+#endif
+#if defined(_M_X64) || defined(__x86_64__)
+	fprintf(out, "  \"arch\": \"x64\",\n");
+#else
+	fprintf(out, "  \"arch\": \"x86\",\n");
+#endif
+	fprintf(out, "  \"packets\": %u,\n", packet_count);
+	fprintf(out, "  \"queue_len\": %u,\n", queue_length);
+	fprintf(out, "  \"results\": [\n");
+	fprintf(out, "    {\"name\": \"queue_mutex\", \"pps\": %.0f, "
+		"\"ns_per_packet\": %.2f},\n", mutex_pps, 1e9 / mutex_pps);
+	fprintf(out, "    {\"name\": \"queue_ring\", \"pps\": %.0f, "
+		"\"ns_per_packet\": %.2f},\n", ring_pps, 1e9 / ring_pps);
+	pacing(out, 0.001, 2000, false);
+	pacing(out, 0.0001, 10000, false);
+	pacing(out, 0.00001, 50000, false);
+	allocations(out, 0.0001, 500, false);
+	batching(out, 1, 500, BACKEND_SOCKET, false);
+	batching(out, 4, 500, BACKEND_SOCKET, false);
+	batching(out, 16, 500, BACKEND_SOCKET, false);
+	batching(out, 64, 500, BACKEND_SOCKET, false);
+	batching(out, 1, 500, BACKEND_RIO, false);
+	batching(out, 16, 500, BACKEND_RIO, false);
+	batching(out, 64, 500, BACKEND_RIO, false);
+	rotation(out, 36.0, 0.001, false);
+	rotation(out, 72.0, 0.001, false);
+	rotation(out, 60.0, 0.083, false);
+	antenna(out, BATCH_LANES, false);
+	encoding(out, 64, false);
+	generation(out, KERNEL_SCALAR, false);
+	generation(out, KERNEL_SSE2, false);
+	generation(out, KERNEL_AVX2, false);
+	memset(&pattern, 0, sizeof(pattern));
+	scanning(out, "constant", ANTENNA_FIXED_6, MODE_M_NONE, pattern, false);
+	scanning(out, "ccw", ANTENNA_MANUAL_CCW, MODE_M_NONE, pattern, false);
+	scanning(out, "stopped", ANTENNA_STOPPED, MODE_M_NONE, pattern, false);
+	scanning(out, "sector", ANTENNA_MANUAL_CW, MODE_M_SECTOR, pattern, 
+		false);
+	scanning(out, "flicker_1", ANTENNA_MANUAL_CW, MODE_M_FLICKER_1, pattern,
+		false);
+	scanning(out, "flicker_2", ANTENNA_MANUAL_CW, MODE_M_FLICKER_2, pattern,
+		false);
+	pattern.ramp_s = 0.1;
+	scanning(out, "sector_ramped", ANTENNA_MANUAL_CCW, MODE_M_SECTOR, 
+		pattern, false);
+	pattern.ramp_s = 0.5;
+	pattern.run_s = 2.0;
+	pattern.stop_s = 1.0;
+	scanning(out, "stop_start", ANTENNA_FIXED_6, MODE_M_NONE, pattern, 
+		false);
+	timestamping(out, false);
+	recording(out, false);
+	replaying(out, 0.0001, 500, false);
+	archiving(out, false);
+	offline(out, 0.001, false);
+	offline(out, 0.0001, false);
+	timeline(out, 10, 0.0001, false);
+	timeline(out, 10000, 0.0001, false);
+	timeline(out, 100000, 0.0001, false);
+	multistream(out, 10, 0.001, 1000, false);
+	multistream(out, 100, 0.001, 1000, false);
+	multistream(out, 500, 0.01, 1000, false);
+	sharding(out, 1, 400, 0.001, 1000, false);
+	sharding(out, 2, 400, 0.001, 1000, false);
+	sharding(out, 4, 400, 0.001, 1000, false);
+	reconfiguring(out, 0.001, 10, 1000, false);
+	aggregating(out, 1, 1, 1000, BACKEND_SOCKET, false);
+	aggregating(out, 1, 64, 1000, BACKEND_SOCKET, false);
+	aggregating(out, 8, 64, 1000, BACKEND_SOCKET, false);
+	aggregating(out, FRAME_PACKETS, 64, 1000, BACKEND_SOCKET, false);
+	aggregating(out, 1, 64, 1000, BACKEND_RIO, false);
+	aggregating(out, 8, 64, 1000, BACKEND_RIO, false);
+	aggregating(out, FRAME_PACKETS, 64, 1000, BACKEND_RIO, false);
+	fanout(out, 4, 0.0001, 1000, BACKEND_SOCKET, false);
+	fanout(out, 4, 0.0001, 1000, BACKEND_RIO, false);
+	calibration(out, 300, 3000, false);
+	sharedmemory(out, 1, 0.00001, 1000, false);
+	sharedmemory(out, 4, 0.00001, 1000, false);
+	sharedmemory(out, 4, 0, 1000, false);
+	loopback(out, 0.001, 1000, BACKEND_SOCKET, false);
+	loopback(out, 0.0001, 1000, BACKEND_SOCKET, false);
+	loopback(out, 0.00001, 1000, BACKEND_SOCKET, false);
+	loopback(out, 0, 1000, BACKEND_SOCKET, false);
+	loopback(out, 0.0001, 1000, BACKEND_RIO, false);
+	loopback(out, 0.00001, 1000, BACKEND_RIO, false);
+	loopback(out, 0, 1000, BACKEND_RIO, true);
+	fprintf(out, "  ]\n");
+	fprintf(out, "}\n");
+
+	// Close the output file and return successful.
+	fclose(out);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the throughput of the mutex-guarded packet queue.
+//! @return The number of packets passed through the queue per second.
+//-----------------------------------------------------------------------------
+double Benchmark::queueMutex() {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+
+	// Pass every packet from the producer to the consumer thread.
+	start = std::chrono::steady_clock::now();
+	std::thread producer(&Benchmark::mutexProducer, this);
+	std::thread consumer(&Benchmark::mutexConsumer, this);
+	producer.join();
+	consumer.join();
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	// Return the achieved packet rate.
+	return packet_count / elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the throughput of the lock-free packet ring.
+//! @return The number of packets passed through the ring per second.
+//-----------------------------------------------------------------------------
+double Benchmark::queueRing() {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+
+	// Pass every packet from the producer to the consumer thread.
+	packet_ring = new PacketRing(queue_length);
+	start = std::chrono::steady_clock::now();
+	std::thread producer(&Benchmark::ringProducer, this);
+	std::thread consumer(&Benchmark::ringConsumer, this);
+	producer.join();
+	consumer.join();
+	elapsed = std::chrono::steady_clock::now() - start;
+	delete packet_ring;
+	packet_ring = NULL;
+
+	// Return the achieved packet rate.
+	return packet_count / elapsed.count();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the lateness and drift of the transmission schedule.
+//! @param out The file to which the result is written.
+//! @param period The delay period between deadlines, in seconds.
+//! @param count The number of deadlines to wait upon.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::pacing(FILE* out, double period, uint32_t count, bool last) {
+
+	// Declare all relevant variables.
+	Pacer pacer;
+	uint32_t i;
+
+	// Wait upon every deadline of the schedule in turn.
+	pacer.start(period);
+	for (i = 0; i < count; ++i) {
+		pacer.wait();
+	}
+	pacer.stop();
+
+	// Write the lateness statistics, along with the cumulative drift of the
+	// final deadline.
+	fprintf(out, "    {\"name\": \"pacing\", \"period_us\": %.1f, "
+		"\"packets\": %u, \"late_mean_ns\": %.0f, \"late_max_ns\": %lld, "
+		"\"late_packets\": %llu, \"drift_ns\": %.0f}%s\n", period * 1e6,
+		count, (double)pacer.late_sum / count, (long long)pacer.late_max,
+		(unsigned long long)pacer.late_count, pacer.drift() * 1e9,
+		last ? "" : ",");
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Counts the steady-state heap allocations of a generator transmitting
+//! over the loopback interface.
+//! @param out The file to which the result is written.
+//! @param period The delay period between packet transmissions, in seconds.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::allocations(FILE* out, double period, uint32_t duration_ms,
+	bool last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	SampleGenerator* generator;
+
+	// Run a generator for the requested duration, then count the allocations
+	// made by its transmitting thread after the first packet. The count is
+	// only meaningful when the allocation hook is compiled in.
+	generator = new SampleGenerator(addr, BENCH_PORT);
+	generator->init(queue_length, period, 0, 6);
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	generator->uninit();
+	fprintf(out, "    {\"name\": \"transmit_allocs\", \"hook\": %s, "
+		"\"allocations\": %llu}%s\n", AllocCounter::enabled() ? "true" :
+		"false", (unsigned long long)generator->allocations(), last ? "" :
+		",");
+	delete generator;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the unpaced packet rate and processor cost of a generator
+//! transmitting over the loopback interface in batches of a given size, 
+//! through a given backend.
+//! @param out The file to which the result is written.
+//! @param batch The greatest number of packets sent in a single batch.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param backend The kind of backend through which the packets are sent.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::batching(FILE* out, uint32_t batch, uint32_t duration_ms,
+	uint32_t backend, bool last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	SampleGenerator* generator;
+	SOCKET sink;
+	sockaddr_in sink_address;
+	double cpu_start;
+	double cpu_sec;
+	uint32_t used;
+
+	// Bind a socket to the destination port, so that the datagrams are 
+	// delivered rather than refused.
+	generator = new SampleGenerator(addr, BENCH_PORT);
+	sink = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	memset((char*)&sink_address, 0, sizeof(sink_address));
+	sink_address.sin_family = AF_INET;
+	sink_address.sin_port = htons(BENCH_PORT);
+	inet_pton(AF_INET, addr, &sink_address.sin_addr.s_addr);
+	bind(sink, (SOCKADDR*)&sink_address, sizeof(sink_address));
+
+	// Transmit as fast as the generator allows for the requested duration.
+	generator->setBatch(batch, 1.0);
+	generator->setBackend(backend);
+	cpu_start = cpuTime();
+	generator->init(queue_length, 0, 0, 6);
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	used = generator->getBackend();
+	generator->uninit();
+	cpu_sec = cpuTime() - cpu_start;
+	fprintf(out, "    {\"name\": \"batching\", \"backend\": \"%s\", "
+		"\"batch\": %u, \"pps\": %.0f, \"cpu_ns_per_packet\": %.1f}%s\n",
+		TransmitBackend::name(used), batch, generator->sent() * 1000.0 / 
+		duration_ms, generator->sent() > 0 ? cpu_sec * 1e9 / generator->
+		sent() : 0.0, last ? "" : ",");
+	delete generator;
+	closesocket(sink);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the build time and footprint of a rotation table, and the 
+//! per-packet cost of copying from it against converting each packet.
+//! @param out The file to which the result is written.
+//! @param rotrate The rotation rate for the antenna, in degrees per second.
+//! @param clkrate The packet transmission rate, in seconds.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::rotation(FILE* out, double rotrate, double clkrate, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> convert_ns;
+	std::chrono::duration<double, std::nano> table_ns;
+	RotationTable table;
+	Packet smpl;
+	uint32_t trns[PACKET_WORDS];
+	uint32_t i;
+
+	// Time the per-packet path, advancing and converting every packet.
+	smpl.setAntRate(rotrate, clkrate);
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < packet_count; ++i) {
+		smpl.updateAntPos();
+		smpl.convert(trns);
+		checksum = checksum + trns[3];
+	}
+	convert_ns = std::chrono::steady_clock::now() - start;
+
+	// Build the table, then time copying the same number of packets from it.
+	smpl = Packet();
+	smpl.setAntRate(rotrate, clkrate);
+	table.build(smpl);
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < packet_count; ++i) {
+		table.next(trns);
+		checksum = checksum + trns[3];
+	}
+	table_ns = std::chrono::steady_clock::now() - start;
+	fprintf(out, "    {\"name\": \"rotation_table\", \"rate_dps\": %.1f, "
+		"\"period_us\": %.1f, \"entries\": %u, \"bytes\": %zu, "
+		"\"build_us\": %.1f, \"convert_ns_per_packet\": %.2f, "
+		"\"table_ns_per_packet\": %.2f}%s\n", rotrate, clkrate * 1e6,
+		table.length, table.footprint, table.build_us, convert_ns.count() /
+		packet_count, table_ns.count() / packet_count, last ? "" : ",");
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the per-packet cost of advancing the antenna one period at
+//! a time against advancing it several periods at once.
+//! @param out The file to which the result is written.
+//! @param batch The number of periods advanced by each call.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::antenna(FILE* out, uint32_t batch, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> single_ns;
+	std::chrono::duration<double, std::nano> batch_ns;
+	Packet smpl;
+	uint32_t* positions;
+	uint32_t rounds;
+	uint32_t single_end;
+	uint32_t i;
+
+	// Rotate at the fastest rate the interface allows, so that every period
+	// moves the antenna.
+	positions = new uint32_t[batch];
+	rounds = packet_count / batch;
+	smpl.setAntRate(72.0, 0.001);
+
+	// Time advancing a single period per call.
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < rounds * batch; ++i) {
+		smpl.updateAntPos();
+		checksum = checksum + smpl.getAntPosition();
+	}
+	single_ns = std::chrono::steady_clock::now() - start;
+	single_end = smpl.getAntPosition();
+
+	// Time advancing the same number of periods a batch at a time, from the
+	// same starting phase.
+	smpl.setAntPhase(0);
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < rounds; ++i) {
+		smpl.updateAntPos(positions, batch);
+		checksum = checksum + positions[batch - 1];
+	}
+	batch_ns = std::chrono::steady_clock::now() - start;
+	fprintf(out, "    {\"name\": \"antenna\", \"batch\": %u, "
+		"\"single_ns_per_packet\": %.2f, \"batch_ns_per_packet\": %.2f, "
+		"\"position_match\": %s}%s\n", batch, single_ns.count() / ((double)
+		rounds * batch), batch_ns.count() / ((double)rounds * batch),
+		single_end == smpl.getAntPosition() ? "true" : "false", last ? "" :
+		",");
+	delete[] positions;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the per-packet cost of converting packets one at a time 
+//! against converting them in batches, and checks that each packet survives a
+//! parse of its words.
+//! @param out The file to which the result is written.
+//! @param batch The number of packets converted by each batch.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::encoding(FILE* out, uint32_t batch, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> single_ns;
+	std::chrono::duration<double, std::nano> batch_ns;
+	Packet* packets;
+	uint32_t* words;
+	uint32_t check[PACKET_WORDS];
+	Packet parsed;
+	uint32_t rounds;
+	uint32_t mismatches;
+	uint32_t i;
+	uint32_t j;
+
+	// Populate a batch of packets with distinct values in every field.
+	packets = new Packet[batch];
+	words = new uint32_t[(size_t)batch * PACKET_WORDS];
+	for (i = 0; i < batch; ++i) {
+		packets[i] = Packet(i, i * 7, PACKET_WORDS, i * 1031, i * 977, i * 4099,
+			i & 1, (i >> 1) & 1, (i >> 2) & 1, i & 3, i & 7, i % 5, i & 3, i & 1,
+			i & 3, (i >> 3) & 1, (i >> 4) & 1, i * 3, i * 5);
+	}
+	rounds = packet_count / batch;
+
+	// Time converting each packet on its own.
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < rounds; ++i) {
+		for (j = 0; j < batch; ++j) {
+			packets[j].convert(words + (size_t)j * PACKET_WORDS);
+		}
+		checksum = checksum + words[3];
+	}
+	single_ns = std::chrono::steady_clock::now() - start;
+
+	// Time converting the same packets a batch at a time.
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < rounds; ++i) {
+		Packet::convertBatch(packets, batch, words);
+		checksum = checksum + words[3];
+	}
+	batch_ns = std::chrono::steady_clock::now() - start;
+
+	// Parse each converted packet, and count those that do not convert back 
+	// to the same words.
+	mismatches = 0;
+	for (i = 0; i < batch; ++i) {
+		parsed.parse(words + (size_t)i * PACKET_WORDS);
+		parsed.convert(check);
+		if (memcmp(check, words + (size_t)i * PACKET_WORDS, sizeof(check)) !=
+			0) {
+			++mismatches;
+		}
+	}
+	fprintf(out, "    {\"name\": \"encoding\", \"batch\": %u, "
+		"\"wire_order\": \"%s\", \"single_ns_per_packet\": %.2f, "
+		"\"batch_ns_per_packet\": %.2f, \"roundtrip_mismatches\": %u}%s\n",
+		batch, PACKET_WIRE_ORDER == WIRE_BIG_ENDIAN ? "network" : "fpga",
+		single_ns.count() / ((double)rounds * batch), batch_ns.count() /
+		((double)rounds * batch), mismatches, last ? "" : ",");
+	delete[] packets;
+	delete[] words;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the per-packet cost of advancing and encoding packets one 
+//! Packet at a time against the batch generator with a given kernel.
+//! @param out The file to which the result is written.
+//! @param kernel The requested kernel of the batch generator, narrowed to the
+//! widest the processor supports.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::generation(FILE* out, uint32_t kernel, bool last) {
+
+	// Declare all relevant variables.
+	static const char* names[] = { "scalar", "sse2", "avx2" };
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> packet_ns;
+	std::chrono::duration<double, std::nano> batch_ns;
+	BatchGenerator generator;
+	Packet smpl;
+	uint32_t* words;
+	uint32_t* check;
+	uint32_t rounds;
+	uint32_t mismatches;
+	uint32_t i;
+	uint32_t j;
+
+	// Advance a manual-mode sample, which has no rotation table.
+	words = new uint32_t[BATCH_LANES * PACKET_WORDS];
+	check = new uint32_t[BATCH_LANES * PACKET_WORDS];
+	rounds = packet_count / BATCH_LANES;
+	smpl = Packet(0, 0, PACKET_WORDS, 0, 0, 0, 1, 0, 0, 0, 0, 2);
+	smpl.setAntRate(36.0, 0.001);
+
+	// Time the per-Packet path, advancing and converting every packet.
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < rounds; ++i) {
+		for (j = 0; j < BATCH_LANES; ++j) {
+			smpl.updateAntPos();
+			smpl.convert(words + j * PACKET_WORDS);
+		}
+		checksum = checksum + words[3];
+	}
+	packet_ns = std::chrono::steady_clock::now() - start;
+
+	// Time the batch generator over the same number of packets.
+	smpl.setAntPhase(0);
+	generator.init(smpl);
+	generator.setKernel(kernel);
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < rounds; ++i) {
+		generator.advance(BATCH_LANES);
+		generator.write(words, BATCH_LANES);
+		checksum = checksum + words[3];
+	}
+	batch_ns = std::chrono::steady_clock::now() - start;
+
+	// Compare the positions of a further batch against the per-Packet path,
+	// which has advanced in step with the generator.
+	generator.advance(BATCH_LANES);
+	generator.write(words, BATCH_LANES);
+	mismatches = 0;
+	for (j = 0; j < BATCH_LANES; ++j) {
+		smpl.updateAntPos();
+		smpl.convert(check + j * PACKET_WORDS);
+		if (words[j * PACKET_WORDS + 3] != check[j * PACKET_WORDS + 3]) {
+			++mismatches;
+		}
+	}
+	fprintf(out, "    {\"name\": \"generation\", \"kernel\": \"%s\", "
+		"\"packet_ns_per_packet\": %.2f, \"batch_ns_per_packet\": %.2f, "
+		"\"position_mismatches\": %u}%s\n", names[generator.getKernel()],
+		packet_ns.count() / ((double)rounds * BATCH_LANES), batch_ns.count() /
+		((double)rounds * BATCH_LANES), mismatches, last ? "" : ",");
+	delete[] words;
+	delete[] check;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the per-packet cost of advancing and encoding the packets
+//! of a scan pattern through the batch generator, at 72 degrees per second 
+//! and a period of 100 microseconds, then runs the pattern again to check 
+//! the shape of the antenna's motion: the number of reversals, the share of
+//! packets at which the antenna stood still, and the extent of the motion 
+//! about the sector start over the second half of the run, once any lead-in
+//! has finished.
+//! @param out The file to which the result is written.
+//! @param name The name of the pattern, as reported.
+//! @param antmode The antenna mode of the packets.
+//! @param mode_m The mode M selection of the packets.
+//! @param pattern The shape of the motion.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::scanning(FILE* out, const char* name, uint8_t antmode, 
+	uint8_t mode_m, const ScanPattern& pattern, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> elapsed;
+	BatchGenerator generator;
+	ScanProgram program;
+	Packet smpl;
+	uint32_t* words;
+	uint32_t rounds;
+	uint32_t origin;
+	uint32_t prev;
+	uint64_t reversals;
+	uint64_t stationary;
+	int32_t delta;
+	int32_t offset;
+	int32_t lo;
+	int32_t hi;
+	int32_t dir;
+	bool programmed;
+	uint32_t i;
+	uint32_t j;
+
+	// Compile the pattern for the sample, which needs no program should it 
+	// rotate steadily clockwise.
+	words = new uint32_t[BATCH_LANES * PACKET_WORDS];
+	rounds = packet_count / BATCH_LANES;
+	smpl = Packet(0, 0, PACKET_WORDS, 0, 0, 0, 1, 0, 0, 0, 0, antmode, 0, 0,
+		mode_m);
+	smpl.setAntRate(72.0, 0.0001);
+	programmed = program.compile(smpl, pattern, 0.0001);
+	generator.init(smpl, programmed ? &program : NULL);
+	generator.setKernel(KERNEL_AVX2);
+
+	// Time the generator over the run.
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < rounds; ++i) {
+		generator.advance(BATCH_LANES);
+		generator.write(words, BATCH_LANES);
+		checksum = checksum + words[3];
+	}
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	// Run the pattern again from the start, following the position. Each
+	// movement is taken as the shorter way round the eighteen-bit circle.
+	program.compile(smpl, pattern, 0.0001);
+	generator.init(smpl, programmed ? &program : NULL);
+	origin = (uint32_t)(ScanProgram::angle(pattern.sector_start) >> 
+		PHASE_SHIFT);
+	prev = smpl.getAntPosition();
+	reversals = 0;
+	stationary = 0;
+	dir = 0;
+	lo = INT32_MAX;
+	hi = INT32_MIN;
+	for (i = 0; i < rounds; ++i) {
+		generator.advance(BATCH_LANES);
+		for (j = 0; j < BATCH_LANES; ++j) {
+			delta = (int32_t)((generator.positions[j] - prev) << 14) >> 14;
+			prev = generator.positions[j];
+			if (delta == 0) {
+				++stationary;
+			}
+			else if ((delta > 0 ? 1 : -1) != dir) {
+				reversals += dir != 0 ? 1 : 0;
+				dir = delta > 0 ? 1 : -1;
+			}
+			if (i >= rounds / 2) {
+				offset = (int32_t)((prev - origin) << 14) >> 14;
+				lo = offset < lo ? offset : lo;
+				hi = offset > hi ? offset : hi;
+			}
+		}
+	}
+	fprintf(out, "    {\"name\": \"scanning\", \"pattern\": \"%s\", "
+		"\"antenna_mode\": %u, \"mode_m\": %u, \"programmed\": %s, "
+		"\"segments\": %u, \"ns_per_packet\": %.2f, \"reversals\": %llu, "
+		"\"stationary_pct\": %.2f, \"min_deg\": %.3f, \"max_deg\": %.3f}"
+		"%s\n", name, antmode, mode_m, programmed ? "true" : "false", 
+		programmed ? program.used : 0, elapsed.count() / ((double)rounds * 
+		BATCH_LANES), (unsigned long long)reversals, 100.0 * stationary / 
+		((double)rounds * BATCH_LANES), lo * ROTATION_STEP, hi * 
+		ROTATION_STEP, last ? "" : ",");
+	delete[] words;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the per-packet cost of the send-time stamp, and the 
+//! disagreement of its IRIG time with the wall clock.
+//! @param out The file to which the result is written.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::timestamping(FILE* out, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> stamp_ns;
+	Timestamp timestamp;
+	Packet smpl;
+	uint32_t trns[PACKET_WORDS];
+	FILETIME wall;
+	ULARGE_INTEGER hns;
+	double wall_ms;
+	double error_ms;
+	uint32_t i;
+
+	// Stamp every packet as the transmitter does, reading the counter for 
+	// each.
+	smpl.convert(trns);
+	timestamp.anchor();
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < packet_count; ++i) {
+		timestamp.stamp(trns, timestamp.irig());
+		checksum = checksum + trns[2];
+	}
+	stamp_ns = std::chrono::steady_clock::now() - start;
+
+	// Compare the IRIG time, extended from the anchor, against a fresh read
+	// of the wall clock, allowing for the wrap at midnight.
+	error_ms = timestamp.irig();
+	GetSystemTimePreciseAsFileTime(&wall);
+	hns.LowPart = wall.dwLowDateTime;
+	hns.HighPart = wall.dwHighDateTime;
+	wall_ms = (hns.QuadPart % ((uint64_t)IRIG_DAY_MS * 10000)) / 10000.0;
+	error_ms -= wall_ms;
+	if (error_ms > IRIG_DAY_MS / 2) {
+		error_ms -= IRIG_DAY_MS;
+	}
+	else if (error_ms < -IRIG_DAY_MS / 2) {
+		error_ms += IRIG_DAY_MS;
+	}
+	fprintf(out, "    {\"name\": \"timestamping\", \"ns_per_packet\": "
+		"%.2f, \"anchor_uncertainty_us\": %.3f, \"irig_error_ms\": %.3f, "
+		"\"sequence_ok\": %s}%s\n", stamp_ns.count() / packet_count,
+		timestamp.uncertainty_ms * 1000.0, error_ms, timestamp.sequence() ==
+		(packet_count & PACKET_NUMBER_MASK) ? "true" : "false", last ? "" :
+		",");
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the per-value cost of recording into a histogram, and the 
+//! error of the quantiles it reports.
+//! @param out The file to which the result is written.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::recording(FILE* out, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> record_ns;
+	LatencyHistogram* histogram;
+	HistogramSnapshot* snap;
+	double p50_error;
+	double p99_error;
+	uint32_t i;
+
+	// Record every value from one to the packet count, spreading them across
+	// the buckets as the metrics of a running generator would be.
+	histogram = new LatencyHistogram();
+	snap = new HistogramSnapshot();
+	start = std::chrono::steady_clock::now();
+	for (i = 1; i <= packet_count; ++i) {
+		histogram->record(i);
+	}
+	record_ns = std::chrono::steady_clock::now() - start;
+
+	// The values are uniform, so each quantile should fall at its share of
+	// the count.
+	histogram->snapshot(snap);
+	p50_error = (double)snap->percentile(0.5) / (0.5 * packet_count) - 1.0;
+	p99_error = (double)snap->percentile(0.99) / (0.99 * packet_count) - 1.0;
+	fprintf(out, "    {\"name\": \"recording\", \"ns_per_record\": %.2f, "
+		"\"buckets\": %u, \"p50_error_pct\": %.2f, \"p99_error_pct\": "
+		"%.2f, \"max_ok\": %s}%s\n", record_ns.count() / packet_count,
+		HIST_BUCKETS, p50_error * 100.0, p99_error * 100.0, snap->max ==
+		packet_count ? "true" : "false", last ? "" : ",");
+	delete histogram;
+	delete snap;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the size of an archived run of generated packets, the 
+//! per-packet cost of encoding and decoding it, and the cost of seeking to an
+//! IRIG time within it. The run crosses midnight, and every decoded or sought
+//! packet is compared against the original.
+//! @param out The file to which the result is written.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::archiving(FILE* out, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> encode_ns;
+	std::chrono::duration<double, std::nano> decode_ns;
+	std::chrono::duration<double, std::nano> seek_ns;
+	BatchGenerator generator;
+	Timestamp timestamp;
+	PacketArchive* archive;
+	Packet smpl;
+	uint32_t* original;
+	uint32_t* decoded;
+	uint32_t first_ms;
+	uint32_t total;
+	uint32_t mismatches;
+	uint32_t seek_mismatches;
+	uint64_t bytes;
+	uint32_t target;
+	uint32_t i;
+	int err;
+
+	// Generate a manual-mode run one millisecond apart, stamped as the 
+	// transmitter would, beginning half the run before midnight.
+	total = packet_count / BATCH_LANES * BATCH_LANES;
+	original = new uint32_t[(size_t)total * PACKET_WORDS];
+	decoded = new uint32_t[(size_t)total * PACKET_WORDS];
+	smpl = Packet(0, 0, PACKET_WORDS, 0, 0, 0, 1, 0, 0, 0, 0, 2);
+	smpl.setAntRate(36.0, 0.001);
+	generator.init(smpl);
+	first_ms = IRIG_DAY_MS - total / 2;
+	for (i = 0; i < total; i += BATCH_LANES) {
+		generator.advance(BATCH_LANES);
+		generator.write(original + (size_t)i * PACKET_WORDS, BATCH_LANES);
+	}
+	for (i = 0; i < total; ++i) {
+		timestamp.stamp(original + (size_t)i * PACKET_WORDS, (first_ms + i) %
+			IRIG_DAY_MS);
+	}
+
+	// Time appending the run a batch at a time, as a generator would.
+	archive = new PacketArchive();
+	err = archive->create(BENCH_ARCHIVE);
+	if (err != 0) {
+		fprintf(out, "    {\"name\": \"archiving\", \"error\": %d}%s\n", 
+			err, last ? "" : ",");
+		delete archive;
+		delete[] original;
+		delete[] decoded;
+		return;
+	}
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < total; i += BATCH_LANES) {
+		archive->append(original + (size_t)i * PACKET_WORDS, BATCH_LANES);
+	}
+	archive->close();
+	encode_ns = std::chrono::steady_clock::now() - start;
+	bytes = archive->bytes();
+
+	// Time decoding the whole run back, and compare it packet by packet.
+	archive->load(BENCH_ARCHIVE);
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < total; i += BATCH_LANES) {
+		archive->read(decoded + (size_t)i * PACKET_WORDS, BATCH_LANES);
+	}
+	decode_ns = std::chrono::steady_clock::now() - start;
+	mismatches = 0;
+	for (i = 0; i < total; ++i) {
+		if (memcmp(original + (size_t)i * PACKET_WORDS, decoded + (size_t)i *
+			PACKET_WORDS, PACKET_BYTES) != 0) {
+			++mismatches;
+		}
+	}
+
+	// Time seeking to scattered times on both sides of midnight, checking
+	// that each lands on the packet stamped with that time.
+	seek_mismatches = 0;
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < BENCH_SEEKS; ++i) {
+		target = (uint32_t)(((uint64_t)i * 7919 * 7919) % total);
+		if (!archive->seek((first_ms + target) % IRIG_DAY_MS) || archive->
+			read(decoded, 1) != 1 || memcmp(decoded, original + (size_t)
+			target * PACKET_WORDS, PACKET_BYTES) != 0) {
+			++seek_mismatches;
+		}
+	}
+	seek_ns = std::chrono::steady_clock::now() - start;
+	archive->close();
+	_wremove(BENCH_ARCHIVE);
+
+	fprintf(out, "    {\"name\": \"archiving\", \"packets\": %u, "
+		"\"bytes_per_packet\": %.3f, \"raw_bytes_per_packet\": %u, "
+		"\"encode_ns_per_packet\": %.2f, \"decode_ns_per_packet\": %.2f, "
+		"\"seek_us\": %.2f, \"roundtrip_mismatches\": %u, "
+		"\"seek_mismatches\": %u}%s\n", total, (double)bytes / total,
+		PACKET_BYTES, encode_ns.count() / total, decode_ns.count() / total,
+		seek_ns.count() / BENCH_SEEKS / 1000.0, mismatches, seek_mismatches,
+		last ? "" : ",");
+	delete archive;
+	delete[] original;
+	delete[] decoded;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the rate of unpaced generation on a simulated clock, into 
+//! memory and into an archive. The run begins half its length before 
+//! midnight, and every packet is checked against the IRIG time and sequence
+//! number its deadline, t0 + n * period, would carry.
+//! @param out The file to which the result is written.
+//! @param period The delay period between packets, in seconds, which must be
+//! a whole number of tenths of a millisecond.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::offline(FILE* out, double period, bool last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> memory_ns;
+	std::chrono::duration<double, std::nano> archive_ns;
+	SampleGenerator* generator;
+	PacketArchive* archive;
+	uint32_t* words;
+	uint64_t tenths;
+	uint64_t first_tenths;
+	uint64_t expected;
+	uint64_t bytes;
+	uint32_t irig_mismatches;
+	uint32_t sequence_mismatches;
+	uint32_t i;
+	int err;
+
+	// Render the run into memory, one period of whole tenths of a
+	// millisecond apart, so that each IRIG time may be computed exactly.
+	tenths = (uint64_t)(period * 10000.0 + 0.5);
+	first_tenths = (uint64_t)IRIG_DAY_MS * 10 - tenths * (packet_count / 2);
+	words = new uint32_t[(size_t)packet_count * PACKET_WORDS];
+	generator = new SampleGenerator(addr, BENCH_PORT);
+	start = std::chrono::steady_clock::now();
+	generator->render(words, packet_count, period, 0, 36, first_tenths / 
+		10.0);
+	memory_ns = std::chrono::steady_clock::now() - start;
+	irig_mismatches = 0;
+	sequence_mismatches = 0;
+	for (i = 0; i < packet_count; ++i) {
+		expected = (first_tenths + i * tenths) / 10 % IRIG_DAY_MS;
+		if (PacketLayout::get<FIELD_IRIG_TIME>(words + (size_t)i * 
+			PACKET_WORDS) != expected) {
+			++irig_mismatches;
+		}
+		if (PacketLayout::get<FIELD_PACKET_NUMBER>(words + (size_t)i * 
+			PACKET_WORDS) != (i & PACKET_NUMBER_MASK)) {
+			++sequence_mismatches;
+		}
+	}
+
+	// Render the same run into an archive, and compare it to the first.
+	start = std::chrono::steady_clock::now();
+	err = generator->render(BENCH_OFFLINE, packet_count, period, 0, 36, 
+		first_tenths / 10.0);
+	archive_ns = std::chrono::steady_clock::now() - start;
+	bytes = 0;
+	if (err == 0) {
+		archive = new PacketArchive();
+		if (archive->load(BENCH_OFFLINE) == 0) {
+			bytes = archive->bytes();
+			for (i = 0; i < packet_count; ++i) {
+				if (archive->read(words, 1) != 1 || PacketLayout::get<
+					FIELD_IRIG_TIME>(words) != (first_tenths + i * tenths) /
+					10 % IRIG_DAY_MS) {
+					++irig_mismatches;
+				}
+			}
+			archive->close();
+		}
+		delete archive;
+		_wremove(BENCH_OFFLINE);
+	}
+
+	fprintf(out, "    {\"name\": \"offline\", \"period_us\": %.1f, "
+		"\"packets\": %u, \"memory_pps\": %.0f, \"memory_ns_per_packet\": "
+		"%.2f, \"archive_pps\": %.0f, \"archive_bytes\": %llu, "
+		"\"archive_error\": %d, \"irig_mismatches\": %u, "
+		"\"sequence_mismatches\": %u}%s\n", period * 1e6, packet_count, 
+		packet_count / memory_ns.count() * 1e9, memory_ns.count() / 
+		packet_count, packet_count / archive_ns.count() * 1e9, 
+		(unsigned long long)bytes, err, irig_mismatches, sequence_mismatches,
+		last ? "" : ",");
+	delete generator;
+	delete[] words;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the per-packet cost of applying a scripted timeline of 
+//! field changes, against the same run without one. The script changes the 
+//! channel at irregular packets, and the transmitter at every other change, 
+//! and every packet rendered is checked against the values scripted for it.
+//! @param out The file to which the result is written.
+//! @param events The number of changes in the script, well below the number
+//! of packets.
+//! @param period The delay period between packets, in seconds, which must be
+//! a whole number of tenths of a millisecond.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::timeline(FILE* out, uint32_t events, double period, bool 
+	last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> plain_ns;
+	std::chrono::duration<double, std::nano> scripted_ns;
+	std::chrono::duration<double, std::micro> load_us;
+	SampleGenerator* generator;
+	ScanPattern pattern;
+	FILE* script;
+	uint32_t* words;
+	uint64_t* at;
+	uint64_t tenths;
+	uint32_t mismatches;
+	uint32_t channel;
+	uint32_t transmitter;
+	uint32_t i;
+	uint32_t k;
+	int err;
+
+	// Script each change on a packet spread evenly over the run, but offset
+	// irregularly, giving its time in whole tenths of a millisecond.
+	tenths = (uint64_t)(period * 10000.0 + 0.5);
+	at = new uint64_t[events];
+	err = _wfopen_s(&script, BENCH_TIMELINE, L"w");
+	if (err != 0 || script == NULL) {
+		fprintf(out, "    {\"name\": \"timeline\", \"error\": %d}%s\n", 
+			err != 0 ? err : 1, last ? "" : ",");
+		delete[] at;
+		return;
+	}
+	fprintf(script, "# time_s field value\n");
+	for (k = 0; k < events; ++k) {
+		at[k] = (uint64_t)(k + 1) * packet_count / (events + 1) + k % 7;
+		fprintf(script, "%llu.%04llu channel %u\n", (unsigned long long)(
+			at[k] * tenths / 10000), (unsigned long long)(at[k] * tenths % 
+			10000), (k + 1) % 8);
+		if (k % 2 == 1) {
+			fprintf(script, "%llu.%04llu transmitter %u\n", (unsigned long 
+				long)(at[k] * tenths / 10000), (unsigned long long)(at[k] * 
+				tenths % 10000), (k / 2) % 2);
+		}
+	}
+	fclose(script);
+
+	// Render the run in a manual mode, which is generated in batches with or
+	// without a script, first plainly and then following the script.
+	words = new uint32_t[(size_t)packet_count * PACKET_WORDS];
+	generator = new SampleGenerator(addr, BENCH_PORT);
+	memset(&pattern, 0, sizeof(pattern));
+	generator->setScan(Packet(0, 0, PACKET_WORDS, 0, 0, 0, 1, 0, 0, 0, 0, 
+		ANTENNA_MANUAL_CW, 0, 0, MODE_M_NONE), pattern);
+	start = std::chrono::steady_clock::now();
+	generator->render(words, packet_count, period, 0, 36, 0);
+	plain_ns = std::chrono::steady_clock::now() - start;
+	start = std::chrono::steady_clock::now();
+	err = generator->setTimeline(BENCH_TIMELINE);
+	load_us = std::chrono::steady_clock::now() - start;
+	start = std::chrono::steady_clock::now();
+	generator->render(words, packet_count, period, 0, 36, 0);
+	scripted_ns = std::chrono::steady_clock::now() - start;
+
+	// Check every packet against the channel and transmitter scripted for 
+	// it, each change taking effect exactly at its packet.
+	mismatches = 0;
+	channel = 0;
+	transmitter = 1;
+	for (i = 0, k = 0; i < packet_count; ++i) {
+		while (k < events && at[k] <= i) {
+			channel = (k + 1) % 8;
+			transmitter = k % 2 == 1 ? (k / 2) % 2 : transmitter;
+			++k;
+		}
+		if (PacketLayout::get<FIELD_CHANNEL_SELECT>(words + (size_t)i * 
+			PACKET_WORDS) != channel || PacketLayout::get<
+			FIELD_TRANSMITTER_ONOFF>(words + (size_t)i * PACKET_WORDS) != 
+			transmitter) {
+			++mismatches;
+		}
+	}
+	_wremove(BENCH_TIMELINE);
+
+	fprintf(out, "    {\"name\": \"timeline\", \"events\": %u, \"scripted\": "
+		"%u, \"packets\": %u, \"period_us\": %.1f, \"load_us\": %.1f, "
+		"\"plain_ns_per_packet\": %.2f, \"scripted_ns_per_packet\": %.2f, "
+		"\"load_error\": %d, \"field_mismatches\": %u}%s\n", events, 
+		generator->script().count(), packet_count, period * 1e6, 
+		load_us.count(), plain_ns.count() / packet_count, 
+		scripted_ns.count() / packet_count, err, mismatches, last ? "" : ",");
+	delete generator;
+	delete[] words;
+	delete[] at;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the pacing and processor cost of many streams driven by a
+//! single scheduling thread, each a distinct radar with its own system ID, 
+//! destination port and start angle, sending over the loopback interface.
+//! @param out The file to which the result is written.
+//! @param streams The number of streams.
+//! @param period The delay period between the packets of each stream.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::multistream(FILE* out, uint32_t streams, double period, 
+	uint32_t duration_ms, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	StreamScheduler* scheduler;
+	HistogramSnapshot* snap;
+	Packet smpl;
+	double cpu_start;
+	double cpu_sec;
+	uint64_t sent;
+	uint32_t i;
+	int err;
+
+	// Add one manual-mode radar per stream, spread across the start angles.
+	scheduler = new StreamScheduler();
+	for (i = 0; i < streams; ++i) {
+		smpl = Packet((uint16_t)i, 0, PACKET_WORDS, 0, 0, 0, 1, 0, 0, 0, 0, 
+			2);
+		scheduler->add(smpl, BENCH_ADDRESS, BENCH_PORT + 3 + (i & 63), period,
+			i * 360.0 / streams, 36.0);
+	}
+
+	// Run the streams for the requested duration.
+	cpu_start = cpuTime();
+	start = std::chrono::steady_clock::now();
+	err = scheduler->init();
+	if (err != 0) {
+		fprintf(out, "    {\"name\": \"multistream\", \"error\": %d}%s\n",
+			err, last ? "" : ",");
+		delete scheduler;
+		return;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	scheduler->uninit();
+	elapsed = std::chrono::steady_clock::now() - start;
+	cpu_sec = cpuTime() - cpu_start;
+	sent = scheduler->sent();
+
+	// Report the aggregate rate against the schedule, and the lateness of 
+	// every packet.
+	snap = new HistogramSnapshot();
+	scheduler->lateness(snap);
+	fprintf(out, "    {\"name\": \"multistream\", \"streams\": %u, "
+		"\"period_us\": %.1f, \"pps\": %.0f, \"scheduled_pps\": %.0f, "
+		"\"cpu_ns_per_packet\": %.1f, \"errors\": %llu, \"first_sent\": "
+		"%llu, \"last_sent\": %llu, \"lateness\": ", streams, period * 1e6, 
+		sent / elapsed.count(), streams / period, sent > 0 ? cpu_sec * 1e9 / 
+		sent : 0.0, (unsigned long long)scheduler->errors(), (unsigned long 
+		long)scheduler->sent(0), (unsigned long long)scheduler->sent(streams -
+		1));
+	snap->write(out, "lateness_ns");
+	fprintf(out, "}%s\n", last ? "" : ",");
+	delete snap;
+	delete scheduler;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the aggregate rate and deadline misses of many streams 
+//! split across pinned shards. The first half of the streams run four times 
+//! faster than the rest, so that the shards holding them fall behind first 
+//! and the others take streams from them.
+//! @param out The file to which the result is written.
+//! @param shards The number of shards.
+//! @param streams The number of streams.
+//! @param period The delay period between the packets of the faster streams.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::sharding(FILE* out, uint32_t shards, uint32_t streams, double
+	period, uint32_t duration_ms, bool last) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	StreamScheduler* scheduler;
+	HistogramSnapshot* snap;
+	Packet smpl;
+	uint64_t cores;
+	double scheduled;
+	double cpu_start;
+	double cpu_sec;
+	uint64_t sent;
+	uint32_t i;
+	int err;
+
+	// Pin one shard per core while there are enough of them, and otherwise
+	// leave the scheduling to the system.
+	cores = 0;
+	if (shards <= std::thread::hardware_concurrency() && shards < 64) {
+		cores = ((uint64_t)1 << shards) - 1;
+	}
+	scheduler = new StreamScheduler(shards, cores);
+	scheduled = 0;
+	for (i = 0; i < streams; ++i) {
+		smpl = Packet((uint16_t)i, 0, PACKET_WORDS, 0, 0, 0, 1, 0, 0, 0, 0, 
+			2);
+		scheduler->add(smpl, BENCH_ADDRESS, BENCH_PORT + 3 + (i & 63), i < 
+			streams / 2 ? period : period * 4, i * 360.0 / streams, 36.0);
+		scheduled += 1.0 / (i < streams / 2 ? period : period * 4);
+	}
+
+	// Run the streams for the requested duration.
+	cpu_start = cpuTime();
+	start = std::chrono::steady_clock::now();
+	err = scheduler->init();
+	if (err != 0) {
+		fprintf(out, "    {\"name\": \"sharding\", \"error\": %d}%s\n",
+			err, last ? "" : ",");
+		delete scheduler;
+		return;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	scheduler->uninit();
+	elapsed = std::chrono::steady_clock::now() - start;
+	cpu_sec = cpuTime() - cpu_start;
+	sent = scheduler->sent();
+
+	// Report the aggregate rate against the schedule, the share of packets
+	// missing their deadline by more than BENCH_MISS_NS, the streams moved,
+	// and the final split of the streams across the shards.
+	snap = new HistogramSnapshot();
+	scheduler->lateness(snap);
+	fprintf(out, "    {\"name\": \"sharding\", \"shards\": %u, "
+		"\"streams\": %u, \"pps\": %.0f, \"scheduled_pps\": %.0f, "
+		"\"cpu_ns_per_packet\": %.1f, \"miss_rate\": %.6f, "
+		"\"migrations\": %llu, \"owned\": [", shards, streams, sent / 
+		elapsed.count(), scheduled, sent > 0 ? cpu_sec * 1e9 / sent : 0.0, 
+		snap->total > 0 ? (double)snap->above(BENCH_MISS_NS) / snap->total : 
+		0.0, (unsigned long long)scheduler->migrations());
+	for (i = 0; i < scheduler->shards(); ++i) {
+		fprintf(out, "%s%u", i > 0 ? ", " : "", scheduler->owned(i));
+	}
+	fprintf(out, "], \"lateness\": ");
+	snap->write(out, "lateness_ns");
+	fprintf(out, "}%s\n", last ? "" : ",");
+	delete snap;
+	delete scheduler;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Measures the per-packet cost of recording, and replays the recording
+//! of a paced generator over the loopback interface, once at its recorded 
+//! timing and once as fast as possible.
+//! @param out The file to which the result is written.
+//! @param period The delay period between packet transmissions, in seconds.
+//! @param duration_ms The duration of the recorded transmission, in 
+//! milliseconds.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::replaying(FILE* out, double period, uint32_t duration_ms,
+	bool last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::nano> record_ns;
+	std::chrono::duration<double> fast_sec;
+	PacketRecorder* recorder;
+	SampleGenerator* generator;
+	PacketReceiver* receiver;
+	HistogramSnapshot* snap;
+	uint32_t words[PACKET_WORDS];
+	uint64_t recorded;
+	uint64_t timed_received;
+	uint64_t timed_late_p99;
+	double timed_sec;
+	uint64_t fast_received;
+	uint64_t fast_sent;
+	uint32_t i;
+	int err;
+
+	// Time appending to a mapped recording alone, then discard it.
+	recorder = new PacketRecorder();
+	err = recorder->create(BENCH_RECORDING, packet_count);
+	if (err != 0) {
+		fprintf(out, "    {\"name\": \"replay\", \"error\": %d}%s\n", err,
+			last ? "" : ",");
+		delete recorder;
+		return;
+	}
+	memset(words, 0, sizeof(words));
+	start = std::chrono::steady_clock::now();
+	for (i = 0; i < packet_count; ++i) {
+		words[1] = i;
+		recorder->record(words, i);
+	}
+	record_ns = std::chrono::steady_clock::now() - start;
+	recorder->close();
+	delete recorder;
+
+	// Record a paced generator for the requested duration.
+	generator = new SampleGenerator(addr, BENCH_PORT + 2);
+	generator->setRecording(BENCH_RECORDING, packet_count);
+	generator->init(queue_length, period, 0, 6);
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	generator->uninit();
+	recorded = generator->recording().count();
+	delete generator;
+
+	// Replay the recording at its original timing to a receiver, which 
+	// should find the stream unbroken.
+	receiver = new PacketReceiver(addr, BENCH_PORT + 2);
+	receiver->init();
+	generator = new SampleGenerator(addr, BENCH_PORT + 2);
+	start = std::chrono::steady_clock::now();
+	generator->replay(BENCH_RECORDING, true);
+	while (generator->sent() < recorded && std::chrono::steady_clock::now() -
+		start < std::chrono::milliseconds(duration_ms * 4)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	timed_sec = std::chrono::duration<double>(std::chrono::steady_clock::now()
+		- start).count();
+	generator->uninit();
+	snap = new HistogramSnapshot();
+	generator->metric(METRIC_LATENESS).snapshot(snap);
+	timed_late_p99 = snap->percentile(0.99);
+	delete generator;
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	receiver->uninit();
+	timed_received = receiver->received.load();
+	delete receiver;
+
+	// Replay the same recording as fast as possible.
+	receiver = new PacketReceiver(addr, BENCH_PORT + 2);
+	receiver->init();
+	generator = new SampleGenerator(addr, BENCH_PORT + 2);
+	start = std::chrono::steady_clock::now();
+	generator->replay(BENCH_RECORDING, false);
+	while (generator->sent() < recorded && std::chrono::steady_clock::now() -
+		start < std::chrono::milliseconds(duration_ms * 4)) {
+		std::this_thread::yield();
+	}
+	fast_sec = std::chrono::steady_clock::now() - start;
+	generator->uninit();
+	fast_sent = generator->sent();
+	delete generator;
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	receiver->uninit();
+	fast_received = receiver->received.load();
+	fprintf(out, "    {\"name\": \"replay\", \"record_ns_per_packet\": "
+		"%.2f, \"recorded\": %llu, \"timed_received\": %llu, "
+		"\"timed_lost\": %llu, \"timed_duration_ms\": %.1f, "
+		"\"timed_late_p99_ns\": %llu, \"fast_pps\": %.0f, "
+		"\"fast_received\": %llu}%s\n", record_ns.count() / packet_count,
+		(unsigned long long)recorded, (unsigned long long)timed_received,
+		(unsigned long long)(recorded - (timed_received < recorded ? 
+		timed_received : recorded)), timed_sec * 1000.0, (unsigned long long)
+		timed_late_p99, fast_sent / fast_sec.count(), (unsigned long long)
+		fast_received, last ? "" : ",");
+	delete snap;
+	delete receiver;
+	_wremove(BENCH_RECORDING);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Runs the full generate, transmit and receive path over the loopback 
+//! interface, measuring its rate, processor time and pacing, and validating 
+//! the packets received.
+//! @param out The file to which the result is written.
+//! @param period The delay period between packet transmissions, in seconds,
+//! or zero to transmit unpaced.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param backend The kind of backend through which the packets are sent.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::loopback(FILE* out, double period, uint32_t duration_ms, 
+	uint32_t backend, bool last) {
+
+	// Declare all relevant variables.
+	static const char* names[METRIC_COUNT] = { "residency_ns", "lateness_ns", 
+		"send_ns", "queue_depth", "skew_ns" };
+	char addr[] = BENCH_ADDRESS;
+	SampleGenerator* generator;
+	PacketReceiver* receiver;
+	HistogramSnapshot* snap;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	double cpu_start;
+	double cpu_sec;
+	uint64_t sent;
+	double late_mean;
+	int64_t late_max;
+	uint32_t used;
+	int err;
+	uint32_t i;
+
+	// Start the receiver before the generator, so that the first packet
+	// establishes the sequence. An entry is still written should the port be
+	// unavailable, keeping the document well formed.
+	receiver = new PacketReceiver(addr, BENCH_PORT + 1);
+	err = receiver->init();
+	if (err != 0) {
+		fprintf(out, "    {\"name\": \"loopback\", \"backend\": \"%s\", "
+			"\"period_us\": %.1f, \"error\": %d}%s\n", TransmitBackend::name(
+			backend), period * 1e6, err, last ? "" : ",");
+		delete receiver;
+		return;
+	}
+
+	// Run the generator for the requested duration. The processor time is 
+	// that of the whole process, so it covers generating, transmitting and
+	// receiving every packet. The backend actually used is noted before the
+	// generator stops, since it may have fallen back to plain sockets.
+	generator = new SampleGenerator(addr, BENCH_PORT + 1);
+	generator->setBackend(backend);
+	cpu_start = cpuTime();
+	start = std::chrono::steady_clock::now();
+	generator->init(queue_length, period, 0, 6);
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	used = generator->getBackend();
+	generator->uninit();
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	// Allow the final packets to arrive before stopping the receiver.
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	receiver->uninit();
+	cpu_sec = cpuTime() - cpu_start;
+	sent = generator->sent();
+
+	// An unpaced generator has no deadlines, so its lateness is not reported.
+	late_mean = 0;
+	late_max = 0;
+	if (period > 0 && sent > 0) {
+		late_mean = (double)generator->schedule().late_sum / sent;
+		late_max = generator->schedule().late_max;
+	}
+	fprintf(out, "    {\"name\": \"loopback\", \"backend\": \"%s\", "
+		"\"period_us\": %.1f, \"pps\": %.0f, \"cpu_ns_per_packet\": %.1f, "
+		"\"late_mean_ns\": %.0f, \"late_max_ns\": %lld, \"sent\": %llu, "
+		"\"received\": %llu, \"lost\": %llu, \"reordered\": %llu, "
+		"\"malformed\": %llu, \"position_jumps\": %llu, \"jitter_ns\": "
+		"%lld, \"latency_max_ms\": %lld, \"interarrival_log2_us\": [", 
+		TransmitBackend::name(used), period * 1e6, sent / elapsed.count(), 
+		sent > 0 ? cpu_sec * 1e9 / sent : 0.0, 
+		late_mean, (long long)late_max, (unsigned long long)sent,
+		(unsigned long long)receiver->received.load(), (unsigned long long)
+		receiver->lost.load(), (unsigned long long)receiver->reordered.load(),
+		(unsigned long long)receiver->malformed.load(), (unsigned long long)
+		receiver->position_jumps.load(), (long long)receiver->jitter_ns.load(),
+		(long long)receiver->latency_max_ms.load());
+	for (i = 0; i < RECV_BUCKETS; ++i) {
+		fprintf(out, "%llu%s", (unsigned long long)receiver->histogram(i),
+			i + 1 < RECV_BUCKETS ? ", " : "");
+	}
+	fprintf(out, "], \"metrics\": [");
+	snap = new HistogramSnapshot();
+	for (i = 0; i < METRIC_COUNT; ++i) {
+		generator->metric(i).snapshot(snap);
+		snap->write(out, names[i]);
+		fprintf(out, "%s", i + 1 < METRIC_COUNT ? ", " : "");
+	}
+	fprintf(out, "]}%s\n", last ? "" : ",");
+	delete snap;
+	delete generator;
+	delete receiver;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Changes the rate and rotation of a running generator at regular 
+//! intervals over the loopback interface, alternating between the given 
+//! period and half of it, and checks that the receiver sees no gap in the 
+//! packet numbers. Each change of rate alters the antenna step once, which
+//! the receiver counts as a single position jump.
+//! @param out The file to which the result is written.
+//! @param period The slower of the two periods, in seconds.
+//! @param changes The number of changes made during the run.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::reconfiguring(FILE* out, double period, uint32_t changes, 
+	uint32_t duration_ms, bool last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	SampleGenerator* generator;
+	PacketReceiver* receiver;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	uint64_t sent;
+	uint32_t i;
+	int err;
+
+	// Start the receiver before the generator, so that the first packet
+	// establishes the sequence.
+	receiver = new PacketReceiver(addr, BENCH_PORT + 1);
+	err = receiver->init();
+	if (err != 0) {
+		fprintf(out, "    {\"name\": \"reconfiguring\", \"error\": %d}%s\n",
+			err, last ? "" : ",");
+		delete receiver;
+		return;
+	}
+
+	// Alternate the period and the rotation at even intervals while the 
+	// generator runs.
+	generator = new SampleGenerator(addr, BENCH_PORT + 1);
+	start = std::chrono::steady_clock::now();
+	generator->init(queue_length, period, 0, 6);
+	for (i = 0; i < changes; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms /
+			(changes + 1)));
+		generator->reconfigure(i % 2 == 0 ? period / 2 : period, i % 2 == 0 ?
+			36 : 6);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms / 
+		(changes + 1)));
+	generator->uninit();
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	// Allow the final packets to arrive before stopping the receiver.
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	receiver->uninit();
+	sent = generator->sent();
+	fprintf(out, "    {\"name\": \"reconfiguring\", \"period_us\": %.1f, "
+		"\"changes\": %u, \"pps\": %.0f, \"late_max_ns\": %lld, "
+		"\"drift_us\": %.1f, \"sent\": %llu, \"received\": %llu, "
+		"\"lost\": %llu, \"reordered\": %llu, \"position_jumps\": %llu}%s\n",
+		period * 1e6, changes, sent / elapsed.count(), (long long)generator->
+		schedule().late_max, generator->schedule().drift() * 1e6, 
+		(unsigned long long)sent, (unsigned long long)receiver->received.
+		load(), (unsigned long long)receiver->lost.load(), (unsigned long 
+		long)receiver->reordered.load(), (unsigned long long)receiver->
+		position_jumps.load(), last ? "" : ",");
+	delete generator;
+	delete receiver;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Transmits as fast as the generator allows over the loopback 
+//! interface, packing up to a given number of packets into each datagram,
+//! and checks that the receiver unpacks every packet in sequence. The 
+//! processor time is that of the whole process, so it covers generating, 
+//! transmitting and receiving every packet.
+//! @param out The file to which the result is written.
+//! @param packets The greatest number of packets in each datagram.
+//! @param batch The greatest number of packets sent in a single batch.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param backend The kind of backend through which the packets are sent.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::aggregating(FILE* out, uint32_t packets, uint32_t batch, 
+	uint32_t duration_ms, uint32_t backend, bool last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	SampleGenerator* generator;
+	PacketReceiver* receiver;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	double cpu_start;
+	double cpu_sec;
+	uint64_t sent;
+	uint32_t used;
+	int err;
+
+	// Start the receiver before the generator, so that the first packet
+	// establishes the sequence.
+	receiver = new PacketReceiver(addr, BENCH_PORT + 1);
+	err = receiver->init();
+	if (err != 0) {
+		fprintf(out, "    {\"name\": \"aggregating\", \"backend\": \"%s\", "
+			"\"packets\": %u, \"error\": %d}%s\n", TransmitBackend::name(
+			backend), packets, err, last ? "" : ",");
+		delete receiver;
+		return;
+	}
+
+	// Run the unpaced generator for the requested duration.
+	generator = new SampleGenerator(addr, BENCH_PORT + 1);
+	generator->setBatch(batch, 1.0);
+	generator->setAggregation(packets);
+	generator->setBackend(backend);
+	cpu_start = cpuTime();
+	start = std::chrono::steady_clock::now();
+	generator->init(queue_length, 0, 0, 6);
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	used = generator->getBackend();
+	generator->uninit();
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	// Allow the final packets to arrive before stopping the receiver.
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	receiver->uninit();
+	cpu_sec = cpuTime() - cpu_start;
+	sent = generator->sent();
+	fprintf(out, "    {\"name\": \"aggregating\", \"backend\": \"%s\", "
+		"\"packets\": %u, \"batch\": %u, \"pps\": %.0f, "
+		"\"cpu_ns_per_packet\": %.1f, \"sent\": %llu, \"errors\": %llu, "
+		"\"received\": %llu, \"lost\": %llu, \"reordered\": %llu, "
+		"\"malformed\": %llu, \"position_jumps\": %llu}%s\n", 
+		TransmitBackend::name(used), packets, batch, sent / elapsed.count(),
+		sent > 0 ? cpu_sec * 1e9 / sent : 0.0, (unsigned long long)sent, 
+		(unsigned long long)generator->destination(0).errors.load(), 
+		(unsigned long long)receiver->received.load(), (unsigned long long)
+		receiver->lost.load(), (unsigned long long)receiver->reordered.load(),
+		(unsigned long long)receiver->malformed.load(), (unsigned long long)
+		receiver->position_jumps.load(), last ? "" : ",");
+	delete generator;
+	delete receiver;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Sends one stream to several receivers on the loopback interface,
+//! each on its own port, and checks that every receiver sees the whole 
+//! stream. The skew is the time between the sends of a packet to the first
+//! and last receivers, or, for a backend committing a batch at once, the 
+//! time taken to queue and commit the batch to every receiver.
+//! @param out The file to which the result is written.
+//! @param destinations The number of receivers, from 1 to DEST_MAX.
+//! @param period The transmission period, in seconds.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param backend The kind of backend through which the packets are sent.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::fanout(FILE* out, uint32_t destinations, double period, 
+	uint32_t duration_ms, uint32_t backend, bool last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	SampleGenerator* generator;
+	PacketReceiver* receivers[DEST_MAX];
+	HistogramSnapshot* snap;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	uint64_t sent;
+	uint32_t used;
+	uint32_t d;
+	int err;
+
+	// Start every receiver before the generator, so that the first packet
+	// establishes each sequence.
+	destinations = destinations < 1 ? 1 : destinations > DEST_MAX ? DEST_MAX :
+		destinations;
+	err = 0;
+	for (d = 0; d < destinations; ++d) {
+		receivers[d] = new PacketReceiver(addr, BENCH_PORT + 67 + d);
+		if (err == 0) {
+			err = receivers[d]->init();
+		}
+	}
+	if (err != 0) {
+		fprintf(out, "    {\"name\": \"fanout\", \"backend\": \"%s\", "
+			"\"destinations\": %u, \"error\": %d}%s\n", TransmitBackend::
+			name(backend), destinations, err, last ? "" : ",");
+		for (d = 0; d < destinations; ++d) {
+			delete receivers[d];
+		}
+		return;
+	}
+
+	// Run the generator to every receiver for the requested duration.
+	generator = new SampleGenerator(addr, BENCH_PORT + 67);
+	generator->setBackend(backend);
+	for (d = 1; d < destinations; ++d) {
+		generator->addDestination(addr, BENCH_PORT + 67 + d);
+	}
+	start = std::chrono::steady_clock::now();
+	generator->init(queue_length, period, 0, 6);
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	used = generator->getBackend();
+	generator->uninit();
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	// Allow the final packets to arrive before stopping the receivers.
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	for (d = 0; d < destinations; ++d) {
+		receivers[d]->uninit();
+	}
+	sent = generator->sent();
+	fprintf(out, "    {\"name\": \"fanout\", \"backend\": \"%s\", "
+		"\"destinations\": %u, \"period_us\": %.1f, \"pps\": %.0f, "
+		"\"sent\": %llu, \"receivers\": [", TransmitBackend::name(used), 
+		destinations, period * 1e6, sent / elapsed.count(), 
+		(unsigned long long)sent);
+	for (d = 0; d < destinations; ++d) {
+		fprintf(out, "{\"sent\": %llu, \"errors\": %llu, \"received\": "
+			"%llu, \"lost\": %llu, \"reordered\": %llu}%s", 
+			(unsigned long long)generator->destination(d).sent.load(), 
+			(unsigned long long)generator->destination(d).errors.load(), 
+			(unsigned long long)receivers[d]->received.load(), 
+			(unsigned long long)receivers[d]->lost.load(), 
+			(unsigned long long)receivers[d]->reordered.load(), 
+			d + 1 < destinations ? ", " : "");
+	}
+	fprintf(out, "], \"metrics\": [");
+	snap = new HistogramSnapshot();
+	generator->metric(METRIC_SKEW).snapshot(snap);
+	snap->write(out, "skew_ns");
+	fprintf(out, "]}%s\n", last ? "" : ",");
+	delete snap;
+	delete generator;
+	for (d = 0; d < destinations; ++d) {
+		delete receivers[d];
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Searches for the highest rate the loopback interface carries to a
+//! receiver without loss and within a jitter bound, writing every probe of 
+//! the search as a point of the curve.
+//! @param out The file to which the result is written.
+//! @param probe_ms The duration of each probe, in milliseconds.
+//! @param max_jitter_ns The greatest receiver jitter with which a probe 
+//! passes, in nanoseconds.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::calibration(FILE* out, uint32_t probe_ms, int64_t 
+	max_jitter_ns, bool last) {
+
+	// Declare all relevant variables.
+	RateCalibrator* calibrator;
+
+	calibrator = new RateCalibrator(BENCH_ADDRESS, BENCH_PORT + 1, 
+		BENCH_PORT + 1);
+	calibrator->setProbe(probe_ms, max_jitter_ns);
+	calibrator->run(queue_length);
+	fprintf(out, "    ");
+	calibrator->write(out, "calibration");
+	fprintf(out, "%s\n", last ? "" : ",");
+	delete calibrator;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Publishes the stream into a shared-memory ring read in place by 
+//! several consumers, each on its own thread as a stand-in for another 
+//! process, and checks that each sees an unbroken run of packet numbers from
+//! the point at which it attached. Every packet published after a consumer
+//! attached should be either received or counted as dropped.
+//! @param out The file to which the result is written.
+//! @param consumers The number of consumers, from 1 to SHARED_CONSUMERS.
+//! @param period The transmission period, in seconds, or zero to run 
+//! unpaced.
+//! @param duration_ms The duration of the transmission, in milliseconds.
+//! @param last A flag signifying the final entry of the results array.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::sharedmemory(FILE* out, uint32_t consumers, double period,
+	uint32_t duration_ms, bool last) {
+
+	// Declare all relevant variables.
+	char addr[] = BENCH_ADDRESS;
+	wchar_t name[SHARED_NAME_LEN];
+	SampleGenerator* generator;
+	SharedTally tallies[SHARED_CONSUMERS];
+	std::thread* readers[SHARED_CONSUMERS];
+	std::atomic<bool> running;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	double cpu_start;
+	double cpu_sec;
+	uint64_t published;
+	uint64_t sent;
+	uint32_t used;
+	uint32_t c;
+
+	// Start the generator into the ring, then attach the consumers, which
+	// retry until the transmitter has created it.
+	consumers = consumers < 1 ? 1 : consumers > SHARED_CONSUMERS ? 
+		SHARED_CONSUMERS : consumers;
+	generator = new SampleGenerator(addr, BENCH_PORT + 131);
+	generator->setBackend(BACKEND_SHARED);
+	SharedRing::name(generator->destination(0).address, name, 
+		SHARED_NAME_LEN);
+	running = true;
+	cpu_start = cpuTime();
+	start = std::chrono::steady_clock::now();
+	generator->init(queue_length, period, 0, 6);
+	for (c = 0; c < consumers; ++c) {
+		memset(&tallies[c], 0, sizeof(tallies[c]));
+		readers[c] = new std::thread(&Benchmark::sharedConsumer, this, name,
+			&running, &tallies[c]);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+	used = generator->getBackend();
+	generator->uninit();
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	// Stop the consumers, each of which first drains the ring, so that the
+	// furthest any reached is the final head.
+	running = false;
+	published = 0;
+	for (c = 0; c < consumers; ++c) {
+		readers[c]->join();
+		delete readers[c];
+		published = tallies[c].end > published ? tallies[c].end : published;
+	}
+	cpu_sec = cpuTime() - cpu_start;
+	sent = generator->sent();
+	fprintf(out, "    {\"name\": \"sharedmemory\", \"backend\": \"%s\", "
+		"\"consumers\": %u, \"period_us\": %.1f, \"pps\": %.0f, "
+		"\"cpu_ns_per_packet\": %.1f, \"sent\": %llu, \"published\": "
+		"%llu, \"readers\": [", TransmitBackend::name(used), consumers, 
+		period * 1e6, sent / elapsed.count(), sent > 0 ? cpu_sec * 1e9 / 
+		sent : 0.0, (unsigned long long)sent, (unsigned long long)published);
+	for (c = 0; c < consumers; ++c) {
+		fprintf(out, "{\"error\": %d, \"expected\": %llu, \"received\": "
+			"%llu, \"dropped\": %llu, \"gaps\": %llu}%s", tallies[c].err, 
+			(unsigned long long)(tallies[c].end - tallies[c].start), 
+			(unsigned long long)tallies[c].received, (unsigned long long)
+			tallies[c].dropped, (unsigned long long)tallies[c].gaps, 
+			c + 1 < consumers ? ", " : "");
+	}
+	fprintf(out, "]}%s\n", last ? "" : ",");
+	delete generator;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Pushes packets onto the mutex-guarded queue, polling while full.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::mutexProducer() {
+
+	// Declare all relevant variables.
+	Packet smpl;
+	uint32_t i;
+
+	// Mirror the original generator loop, including its polling delay.
+	smpl.setAntRate(6.0, 0.001);
+	i = 0;
+	while (i < packet_count) {
+		if (packet_queue.size() > queue_length - 1) {
+			std::chrono::microseconds delay(50);
+			std::this_thread::sleep_for(delay);
+			continue;
+		}
+		smpl.updateAntPos();
+		queue_mutex.lock();
+		packet_queue.push(smpl);
+		queue_mutex.unlock();
+		++i;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Pops packets from the mutex-guarded queue, polling while empty.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::mutexConsumer() {
+
+	// Declare all relevant variables.
+	Packet smpl;
+	uint32_t trns[PACKET_WORDS];
+	uint32_t i;
+
+	// Mirror the original transmitter loop, omitting the socket and delay.
+	i = 0;
+	while (i < packet_count) {
+		if (packet_queue.empty()) {
+			std::chrono::microseconds delay(50);
+			std::this_thread::sleep_for(delay);
+			continue;
+		}
+		queue_mutex.lock();
+		smpl = packet_queue.front();
+		packet_queue.pop();
+		smpl.convert(trns);
+		queue_mutex.unlock();
+		checksum = checksum + trns[3];
+		++i;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Encodes packets into the lock-free ring.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::ringProducer() {
+
+	// Declare all relevant variables.
+	Packet smpl;
+	uint32_t* slot;
+	uint32_t i;
+
+	// Mirror the current generator loop.
+	smpl.setAntRate(6.0, 0.001);
+	for (i = 0; i < packet_count; ++i) {
+		slot = packet_ring->acquire();
+		smpl.updateAntPos();
+		smpl.convert(slot);
+		packet_ring->publish();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Drains encoded packets from the lock-free ring.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::ringConsumer() {
+
+	// Declare all relevant variables.
+	const uint32_t* trns;
+	uint32_t i;
+
+	// Mirror the current transmitter loop, omitting the socket and delay.
+	for (i = 0; i < packet_count; ++i) {
+		trns = packet_ring->front();
+		checksum = checksum + trns[3];
+		packet_ring->release();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Reads packets in place from a shared ring until it is stopped and
+//! drained, sleeping on the ring's event whenever it is empty, and counts 
+//! the breaks in the packet numbers. A break following packets the consumer
+//! knows it missed is not counted.
+//! @param name The name of the ring.
+//! @param running A flag which is cleared to stop the consumer.
+//! @param tally Receives what the consumer read.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Benchmark::sharedConsumer(const wchar_t* name, std::atomic<bool>* 
+	running, SharedTally* tally) {
+
+	// Declare all relevant variables.
+	SharedRing ring;
+	Packet pckt;
+	const uint32_t* slot;
+	uint64_t dropped;
+	uint32_t granted;
+	uint32_t breaks;
+	uint32_t number;
+	uint32_t expected;
+	uint32_t i;
+	bool have;
+
+	// Attach once the producer has created the ring.
+	tally->err = ring.open(name);
+	while (tally->err != 0 && *running) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		tally->err = ring.open(name);
+	}
+	if (tally->err != 0) {
+		return;
+	}
+	tally->start = ring.position();
+
+	// Read each run of slots in place, discarding any overwritten meanwhile,
+	// whose numbers are not to be trusted.
+	have = false;
+	expected = 0;
+	for (;;) {
+		dropped = ring.dropped;
+		slot = ring.acquire(BATCH_LANES, &granted);
+		if (slot == NULL) {
+			if (!*running) {
+				break;
+			}
+			ring.wait(BENCH_SHARED_WAIT_MS);
+			continue;
+		}
+		breaks = 0;
+		for (i = 0; i < granted; ++i) {
+			pckt.parse(slot + i * PACKET_WORDS);
+			number = pckt.getPacketNumber();
+			if (have && number != expected && ring.dropped == dropped) {
+				++breaks;
+			}
+			expected = (number + 1) & PACKET_NUMBER_MASK;
+			have = true;
+		}
+		if (ring.release(granted)) {
+			tally->received += granted;
+			tally->gaps += breaks;
+		}
+		else {
+			have = false;
+		}
+	}
+	tally->end = ring.position();
+	tally->dropped = ring.dropped;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the processor time consumed by the process so far.
+//! @return The user and kernel time of every thread, in seconds.
+//-----------------------------------------------------------------------------
+double Benchmark::cpuTime() {
+
+	// Declare all relevant variables.
+	FILETIME creation;
+	FILETIME exit;
+	FILETIME kernel;
+	FILETIME user;
+	ULARGE_INTEGER kernel_hns;
+	ULARGE_INTEGER user_hns;
+
+	// Sum the kernel and user times, each counted in 100 ns units.
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel,
+		&user)) {
+		return 0;
+	}
+	kernel_hns.LowPart = kernel.dwLowDateTime;
+	kernel_hns.HighPart = kernel.dwHighDateTime;
+	user_hns.LowPart = user.dwLowDateTime;
+	user_hns.HighPart = user.dwHighDateTime;
+	return (kernel_hns.QuadPart + user_hns.QuadPart) / 1e7;
+}
\ No newline at end of file
@@ -0,0 +1,355 @@
+#pragma once
+
+#include "stdafx.h"
+#include <stdio.h>
+#include <queue>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include "Packet.h"
+#include "PacketRing.h"
+#include "Pacer.h"
+#include "SampleGenerator.h"
+#include "BatchGenerator.h"
+#include "Timestamp.h"
+#include "PacketReceiver.h"
+#include "PacketArchive.h"
+#include "StreamScheduler.h"
+#include "RateCalibrator.h"
+#include "SharedRing.h"
+
+// Establish the globally accessible macros.
+#define BENCH_PACKETS 1000000
+#define BENCH_QUEUE_LEN 100
+#define BENCH_ADDRESS "127.0.0.1"
+#define BENCH_PORT 45000
+#define BENCH_SCHEMA 1
+#define BENCH_RECORDING L"eGRIM_bench.egr"
+#define BENCH_ARCHIVE L"eGRIM_bench.ega"
+#define BENCH_SEEKS 1000
+#define BENCH_OFFLINE L"eGRIM_offline.ega"
+#define BENCH_MISS_NS 100000
+#define BENCH_SHARED_WAIT_MS 10
+#define BENCH_TIMELINE L"eGRIM_bench.timeline"
+
+//=============================================================================
+//! @struct SharedTally
+//!
+//! @brief What one consumer of a shared ring read during a benchmark.
+//=============================================================================
+struct SharedTally {
+
+	//! The index of the slot at which the consumer attached.
+	uint64_t start;
+
+	//! The index of the slot at which the consumer stopped.
+	uint64_t end;
+
+	//! The number of packets read intact.
+	uint64_t received;
+
+	//! The number of breaks in the packet numbers not accounted for by 
+	//! dropped packets.
+	uint64_t gaps;
+
+	//! The number of packets the consumer missed.
+	uint64_t dropped;
+
+	//! A zero value, if the consumer attached, or the error otherwise.
+	int err;
+};
+
+//=============================================================================
+//! @class Benchmark
+//!
+//! @brief Measures the cost of the packet generation stages, and reports the
+//! results as a JSON document.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class Benchmark {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn Benchmark
+	//!
+	//! @brief Constructs a Benchmark instance.
+	//-------------------------------------------------------------------------
+	Benchmark(uint32_t count = BENCH_PACKETS, uint32_t queue_len =
+		BENCH_QUEUE_LEN);
+
+	//-------------------------------------------------------------------------
+	//! @fn report
+	//!
+	//! @brief Runs every benchmark and writes the results to a JSON file.
+	//-------------------------------------------------------------------------
+	int report(const wchar_t* path);
+
+	//-------------------------------------------------------------------------
+	//! @fn queueMutex
+	//!
+	//! @brief Measures the throughput of the mutex-guarded packet queue.
+	//-------------------------------------------------------------------------
+	double queueMutex();
+
+	//-------------------------------------------------------------------------
+	//! @fn queueRing
+	//!
+	//! @brief Measures the throughput of the lock-free packet ring.
+	//-------------------------------------------------------------------------
+	double queueRing();
+
+	//-------------------------------------------------------------------------
+	//! @fn pacing
+	//!
+	//! @brief Measures the lateness and drift of the transmission schedule.
+	//-------------------------------------------------------------------------
+	void pacing(FILE* out, double period, uint32_t count, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn allocations
+	//!
+	//! @brief Counts the steady-state heap allocations of a generator
+	//! transmitting over the loopback interface.
+	//-------------------------------------------------------------------------
+	void allocations(FILE* out, double period, uint32_t duration_ms, bool
+		last);
+
+	//-------------------------------------------------------------------------
+	//! @fn batching
+	//!
+	//! @brief Measures the unpaced packet rate of a generator transmitting
+	//! over the loopback interface in batches of a given size, through a
+	//! given backend.
+	//-------------------------------------------------------------------------
+	void batching(FILE* out, uint32_t batch, uint32_t duration_ms, uint32_t 
+		backend, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn rotation
+	//!
+	//! @brief Measures the build time and footprint of a rotation table, and
+	//! the per-packet cost of copying from it against converting each packet.
+	//-------------------------------------------------------------------------
+	void rotation(FILE* out, double rotrate, double clkrate, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn antenna
+	//!
+	//! @brief Measures the per-packet cost of advancing the antenna one period
+	//! at a time against advancing it several periods at once.
+	//-------------------------------------------------------------------------
+	void antenna(FILE* out, uint32_t batch, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn encoding
+	//!
+	//! @brief Measures the per-packet cost of converting packets one at a
+	//! time against converting them in batches, and checks that each packet
+	//! survives a parse of its words.
+	//-------------------------------------------------------------------------
+	void encoding(FILE* out, uint32_t batch, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn generation
+	//!
+	//! @brief Measures the per-packet cost of advancing and encoding packets
+	//! one Packet at a time against the batch generator with a given kernel.
+	//-------------------------------------------------------------------------
+	void generation(FILE* out, uint32_t kernel, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn scanning
+	//!
+	//! @brief Measures the per-packet cost of generating the packets of a 
+	//! scan pattern, and checks the shape of the antenna's motion.
+	//-------------------------------------------------------------------------
+	void scanning(FILE* out, const char* name, uint8_t antmode, uint8_t 
+		mode_m, const ScanPattern& pattern, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn timestamping
+	//!
+	//! @brief Measures the per-packet cost of the send-time stamp, and the 
+	//! disagreement of its IRIG time with the wall clock.
+	//-------------------------------------------------------------------------
+	void timestamping(FILE* out, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn recording
+	//!
+	//! @brief Measures the per-value cost of recording into a histogram, and
+	//! the error of the quantiles it reports.
+	//-------------------------------------------------------------------------
+	void recording(FILE* out, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn replaying
+	//!
+	//! @brief Measures the per-packet cost of recording, and replays the
+	//! recording of a paced generator over the loopback interface.
+	//-------------------------------------------------------------------------
+	void replaying(FILE* out, double period, uint32_t duration_ms, bool 
+		last);
+
+	//-------------------------------------------------------------------------
+	//! @fn archiving
+	//!
+	//! @brief Measures the size of an archived run, the per-packet cost of
+	//! encoding and decoding it, and the cost of seeking within it.
+	//-------------------------------------------------------------------------
+	void archiving(FILE* out, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn offline
+	//!
+	//! @brief Measures the rate of unpaced generation on a simulated clock,
+	//! and checks the IRIG time and sequence number of every packet.
+	//-------------------------------------------------------------------------
+	void offline(FILE* out, double period, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn timeline
+	//!
+	//! @brief Measures the per-packet cost of applying a scripted timeline of
+	//! field changes, and checks that each lands on its packet.
+	//-------------------------------------------------------------------------
+	void timeline(FILE* out, uint32_t events, double period, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn multistream
+	//!
+	//! @brief Measures the pacing and processor cost of many streams driven
+	//! by a single scheduling thread.
+	//-------------------------------------------------------------------------
+	void multistream(FILE* out, uint32_t streams, double period, uint32_t 
+		duration_ms, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn sharding
+	//!
+	//! @brief Measures the aggregate rate and deadline misses of many streams
+	//! split across pinned shards, which rebalance by stealing streams.
+	//-------------------------------------------------------------------------
+	void sharding(FILE* out, uint32_t shards, uint32_t streams, double 
+		period, uint32_t duration_ms, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn reconfiguring
+	//!
+	//! @brief Changes the rate and rotation of a running generator, checking
+	//! that its packets continue without a gap.
+	//-------------------------------------------------------------------------
+	void reconfiguring(FILE* out, double period, uint32_t changes, uint32_t
+		duration_ms, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn aggregating
+	//!
+	//! @brief Measures the unpaced rate and processor cost of packing several
+	//! packets into each datagram, validating every packet received.
+	//-------------------------------------------------------------------------
+	void aggregating(FILE* out, uint32_t packets, uint32_t batch, uint32_t 
+		duration_ms, uint32_t backend, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn fanout
+	//!
+	//! @brief Sends one stream to several receivers through a given backend,
+	//! measuring the skew between the sends to each and validating every 
+	//! receiver's packets.
+	//-------------------------------------------------------------------------
+	void fanout(FILE* out, uint32_t destinations, double period, uint32_t 
+		duration_ms, uint32_t backend, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn calibration
+	//!
+	//! @brief Searches for the highest loss-free rate over the loopback 
+	//! interface, reporting the throughput and latency curve.
+	//-------------------------------------------------------------------------
+	void calibration(FILE* out, uint32_t probe_ms, int64_t max_jitter_ns, 
+		bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn sharedmemory
+	//!
+	//! @brief Publishes the stream into a shared-memory ring read by several
+	//! local consumers, measuring its rate and processor cost and validating
+	//! every consumer's packets.
+	//-------------------------------------------------------------------------
+	void sharedmemory(FILE* out, uint32_t consumers, double period, uint32_t
+		duration_ms, bool last);
+
+	//-------------------------------------------------------------------------
+	//! @fn loopback
+	//!
+	//! @brief Runs the full generate, transmit and receive path over the
+	//! loopback interface through a given backend, measuring its rate, 
+	//! processor time and pacing, and validating the packets received.
+	//-------------------------------------------------------------------------
+	void loopback(FILE* out, double period, uint32_t duration_ms, uint32_t
+		backend, bool last);
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn mutexProducer
+	//!
+	//! @brief Pushes packets onto the mutex-guarded queue, polling while full.
+	//-------------------------------------------------------------------------
+	void mutexProducer();
+
+	//-------------------------------------------------------------------------
+	//! @fn mutexConsumer
+	//!
+	//! @brief Pops packets from the mutex-guarded queue, polling while empty.
+	//-------------------------------------------------------------------------
+	void mutexConsumer();
+
+	//-------------------------------------------------------------------------
+	//! @fn ringProducer
+	//!
+	//! @brief Encodes packets into the lock-free ring.
+	//-------------------------------------------------------------------------
+	void ringProducer();
+
+	//-------------------------------------------------------------------------
+	//! @fn ringConsumer
+	//!
+	//! @brief Drains encoded packets from the lock-free ring.
+	//-------------------------------------------------------------------------
+	void ringConsumer();
+
+	//-------------------------------------------------------------------------
+	//! @fn sharedConsumer
+	//!
+	//! @brief Reads packets in place from a shared ring until it is stopped.
+	//-------------------------------------------------------------------------
+	void sharedConsumer(const wchar_t* name, std::atomic<bool>* running, 
+		SharedTally* tally);
+
+	//-------------------------------------------------------------------------
+	//! @fn cpuTime
+	//!
+	//! @brief Returns the processor time consumed by the process so far.
+	//-------------------------------------------------------------------------
+	double cpuTime();
+
+	//! The number of packets passed through each benchmark.
+	uint32_t packet_count;
+
+	//! The maximum length of the queue or ring under test.
+	uint32_t queue_length;
+
+	//! The mutex-guarded queue, mirroring the original generator design.
+	std::queue<Packet> packet_queue;
+
+	//! A mutex guarding the packet queue.
+	std::mutex queue_mutex;
+
+	//! The lock-free ring under test.
+	PacketRing* packet_ring;
+
+	//! A running sum of consumed words, preventing the work being elided.
+	volatile uint32_t checksum;
+};
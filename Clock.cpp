@@ -0,0 +1,92 @@
+#include "Clock.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a Clock instance reading the performance counter.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+Clock::Clock() : sim(false), ticks(0), counter_frequency(0), origin_ms(0) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER freq;
+
+	// Retrieve the fixed frequency of the performance counter.
+	QueryPerformanceFrequency(&freq);
+	counter_frequency = freq.QuadPart;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Switches to a simulated counter, beginning at an IRIG time. The 
+//! counter starts at zero, and only moves when advanced.
+//! @param irig_ms The IRIG time of the first tick, in milliseconds of the day.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Clock::simulate(double irig_ms) {
+	sim = true;
+	ticks = 0;
+	origin_ms = irig_ms;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns to the performance counter.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Clock::release() {
+	sim = false;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns whether the clock is simulated.
+//! @return Whether the simulated counter is read in place of the performance
+//! counter.
+//-----------------------------------------------------------------------------
+bool Clock::simulated() {
+	return sim;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Reads the current instant.
+//! @return The simulated counter, or the performance counter otherwise.
+//-----------------------------------------------------------------------------
+int64_t Clock::now() {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER counter;
+
+	if (sim) {
+		return ticks;
+	}
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Moves the simulated counter forward to an instant, which takes the
+//! place of waiting for it. The counter never moves backward.
+//! @param target The counter reading to reach.
+//! @return The counter reading afterward, which is at or after target.
+//-----------------------------------------------------------------------------
+int64_t Clock::advance(int64_t target) {
+	if (target > ticks) {
+		ticks = target;
+	}
+	return ticks;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the frequency of the counter.
+//! @return The ticks per second, which is that of the performance counter
+//! whether or not the clock is simulated.
+//-----------------------------------------------------------------------------
+int64_t Clock::frequency() {
+	return counter_frequency;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the IRIG time of a simulated counter reading.
+//! @param reading A simulated counter reading.
+//! @return The milliseconds of the day, unwrapped, so that a reading beyond
+//! midnight exceeds a day.
+//-----------------------------------------------------------------------------
+double Clock::wall(int64_t reading) {
+	return origin_ms + reading * 1000.0 / counter_frequency;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "stdafx.h"
+
+//=============================================================================
+//! @class Clock
+//!
+//! @brief Supplies the instants by which packets are paced and stamped. By
+//! default, the clock reads the performance counter. Once simulated, it holds
+//! a counter of its own which advances only when a wait asks it to, and an 
+//! IRIG time for its first tick, so that a run is generated without waiting
+//! while every deadline and stamp falls exactly where a real-time run would
+//! place it.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class Clock {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn Clock
+	//!
+	//! @brief Constructs a Clock instance reading the performance counter.
+	//-------------------------------------------------------------------------
+	Clock();
+
+	//-------------------------------------------------------------------------
+	//! @fn simulate
+	//!
+	//! @brief Switches to a simulated counter, beginning at an IRIG time.
+	//-------------------------------------------------------------------------
+	void simulate(double irig_ms);
+
+	//-------------------------------------------------------------------------
+	//! @fn release
+	//!
+	//! @brief Returns to the performance counter.
+	//-------------------------------------------------------------------------
+	void release();
+
+	//-------------------------------------------------------------------------
+	//! @fn simulated
+	//!
+	//! @brief Returns whether the clock is simulated.
+	//-------------------------------------------------------------------------
+	bool simulated();
+
+	//-------------------------------------------------------------------------
+	//! @fn now
+	//!
+	//! @brief Reads the current instant.
+	//-------------------------------------------------------------------------
+	int64_t now();
+
+	//-------------------------------------------------------------------------
+	//! @fn advance
+	//!
+	//! @brief Moves the simulated counter forward to an instant.
+	//-------------------------------------------------------------------------
+	int64_t advance(int64_t target);
+
+	//-------------------------------------------------------------------------
+	//! @fn frequency
+	//!
+	//! @brief Returns the frequency of the counter.
+	//-------------------------------------------------------------------------
+	int64_t frequency();
+
+	//-------------------------------------------------------------------------
+	//! @fn wall
+	//!
+	//! @brief Returns the IRIG time of a simulated counter reading.
+	//-------------------------------------------------------------------------
+	double wall(int64_t ticks);
+private:
+
+	//! A flag signifying that the clock is simulated.
+	bool sim;
+
+	//! The simulated counter, in ticks since the clock was simulated.
+	int64_t ticks;
+
+	//! The frequency of the performance counter, which the simulated counter
+	//! shares so that tick arithmetic matches a real-time run.
+	int64_t counter_frequency;
+
+	//! The IRIG time of the first simulated tick, in milliseconds.
+	double origin_ms;
+};
@@ -0,0 +1,317 @@
+#include "EventTimeline.h"
+
+//! The name by which a script refers to each field it may change, in the
+//! order of PacketField. The fields which the generator advances, and the
+//! antenna and mode M selections which shape its motion, may not be changed
+//! by a script.
+static const char* TIMELINE_NAMES[FIELD_COUNT] = { NULL, NULL, NULL, NULL,
+	NULL, NULL, "transmitter", "phasing", "integration", "range", "channel",
+	NULL, "mode_switch", "pri", NULL, "afc", "agc", "mgc", "adj_range" };
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs an EventTimeline instance, holding no event.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+EventTimeline::EventTimeline() : masks(), values(), error_line(0),
+	events(NULL), used(0), capacity(0), cursor(0), upcoming(TIMELINE_NONE),
+	origin_s(0), origin_packet(0), period(0) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys an EventTimeline instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+EventTimeline::~EventTimeline() {
+	delete[] events;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Reads the events of a script, replacing any held. Each line holds
+//! the time of a change in seconds from the first packet, the name of the
+//! field, and its new value, separated by spaces, as in "12.5 channel 3".
+//! The names are those of TIMELINE_NAMES, and the values may be given in
+//! decimal or, prefixed by 0x, in hexadecimal. Blank lines, and anything
+//! following a #, are ignored. The lines need not be in time order.
+//! @param path The location of the script.
+//! @return A zero value, if successful, ERROR_BAD_FORMAT should a line not be
+//! understood, with error_line naming it, or the error code otherwise.
+//-----------------------------------------------------------------------------
+int EventTimeline::load(const wchar_t* path) {
+
+	// Declare all relevant variables.
+	FILE* file;
+	char line[TIMELINE_LINE];
+	char name[32];
+	char* at;
+	char* end;
+	double time_s;
+	unsigned long value;
+	uint32_t number;
+	uint32_t len;
+	int which;
+	int err;
+	bool valid;
+
+	clear();
+	error_line = 0;
+	err = _wfopen_s(&file, path, L"r");
+	if (err != 0 || file == NULL) {
+		return err != 0 ? err : ERROR_OPEN_FAILED;
+	}
+
+	for (number = 1; fgets(line, sizeof(line), file) != NULL; ++number) {
+
+		// Cut the line at any comment, and skip it should nothing remain.
+		at = strchr(line, '#');
+		if (at != NULL) {
+			*at = '\0';
+		}
+		at = line;
+		while (*at == ' ' || *at == '\t') {
+			++at;
+		}
+		if (*at == '\0' || *at == '\r' || *at == '\n') {
+			continue;
+		}
+
+		// Read the time, the name and the value in turn, refusing the line
+		// should any be missing or anything follow them.
+		time_s = strtod(at, &end);
+		valid = end != at && _finite(time_s) && time_s >= 0;
+		which = -1;
+		value = 0;
+		if (valid) {
+			at = end;
+			while (*at == ' ' || *at == '\t') {
+				++at;
+			}
+			for (len = 0; at[len] != '\0' && at[len] != ' ' && at[len] !=
+				'\t' && len + 1 < sizeof(name); ++len) {
+				name[len] = at[len];
+			}
+			name[len] = '\0';
+			which = field(name);
+			valid = which >= 0;
+			at += len;
+		}
+		if (valid) {
+			value = strtoul(at, &end, 0);
+			valid = end != at;
+			at = end;
+			while (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n') {
+				++at;
+			}
+			valid = valid && *at == '\0';
+		}
+		if (!valid || !add(time_s, (uint32_t)which, (uint32_t)value)) {
+			error_line = number;
+			fclose(file);
+			clear();
+			return ERROR_BAD_FORMAT;
+		}
+	}
+	fclose(file);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Inserts a change of one field, keeping the events in time order.
+//! An event at the same time as others follows them, so that the script's
+//! own order decides between changes of the same field. The search runs from
+//! the end, so that a script already in order loads in linear time.
+//! @param time_s The time of the change, in seconds from the first packet.
+//! @param field The field, one of the PacketField values.
+//! @param value The new value of the field.
+//! @return A true value, if the event was added, or false should the time
+//! be negative or not finite, the field be one a script may not change, or
+//! the value not fit it.
+//-----------------------------------------------------------------------------
+bool EventTimeline::add(double time_s, uint32_t field, uint32_t value) {
+
+	// Declare all relevant variables.
+	TimelineEvent* grown;
+	uint32_t i;
+
+	if (!_finite(time_s) || time_s < 0 || field >= FIELD_COUNT ||
+		TIMELINE_NAMES[field] == NULL || ((uint64_t)value << PACKET_LAYOUT[
+		field].shift & ~(uint64_t)PacketLayout::mask(field)) != 0) {
+		return false;
+	}
+
+	// Double the space for the events, as the archive grows its index.
+	if (used == capacity) {
+		capacity = capacity == 0 ? TIMELINE_GROWTH : capacity * 2;
+		grown = new TimelineEvent[capacity];
+		if (used > 0) {
+			memcpy(grown, events, used * sizeof(TimelineEvent));
+		}
+		delete[] events;
+		events = grown;
+	}
+
+	// Shift any later events up, and place the new one after them.
+	for (i = used; i > 0 && events[i - 1].time_s > time_s; --i) {
+		events[i] = events[i - 1];
+	}
+	events[i].time_s = time_s;
+	events[i].packet = TIMELINE_NONE;
+	events[i].word = PACKET_LAYOUT[field].word;
+	events[i].mask = PacketLayout::mask(field);
+	events[i].bits = value << PACKET_LAYOUT[field].shift;
+	++used;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Discards every event, and any changes they applied.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void EventTimeline::clear() {
+	delete[] events;
+	events = NULL;
+	used = 0;
+	capacity = 0;
+	compile(0);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Keys every event to the first packet at or after its time, the
+//! first packet falling at time zero, and rewinds the timeline to its start,
+//! undoing any changes applied. An unpaced run has no timing, and applies no
+//! event.
+//! @param clkrate The packet transmission rate, in seconds.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void EventTimeline::compile(double clkrate) {
+	memset(masks, 0, sizeof(masks));
+	memset(values, 0, sizeof(values));
+	cursor = 0;
+	origin_s = 0;
+	origin_packet = 0;
+	retime(0, clkrate);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Keys the events yet to apply to a new period, from the packet at
+//! which it takes effect, so that each still applies at its scripted time.
+//! @param packet The first packet sent at the new period.
+//! @param clkrate The packet transmission rate, in seconds.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void EventTimeline::retime(uint64_t packet, double clkrate) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	origin_s += (double)(packet - origin_packet) * period;
+	origin_packet = packet;
+	period = clkrate;
+	for (i = cursor; i < used; ++i) {
+		events[i].packet = key(events[i].time_s);
+	}
+	upcoming = cursor < used ? events[cursor].packet : TIMELINE_NONE;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Applies every event due by the given packet, gathering its change
+//! into the masks and values.
+//! @param packet The index of the next packet to be generated.
+//! @return The number of events applied.
+//-----------------------------------------------------------------------------
+uint32_t EventTimeline::step(uint64_t packet) {
+
+	// Declare all relevant variables.
+	const TimelineEvent* ev;
+	uint32_t first;
+
+	first = cursor;
+	while (cursor < used && events[cursor].packet <= packet) {
+		ev = &events[cursor++];
+		masks[ev->word] |= ev->mask;
+		values[ev->word] = (values[ev->word] & ~ev->mask) | ev->bits;
+	}
+	upcoming = cursor < used ? events[cursor].packet : TIMELINE_NONE;
+	return cursor - first;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the packet at which the next event applies.
+//! @return The index of the packet, or TIMELINE_NONE once every event has
+//! applied.
+//-----------------------------------------------------------------------------
+uint64_t EventTimeline::next() {
+	return upcoming;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns whether the timeline holds any event.
+//! @return A true value, if an event is held, or false otherwise.
+//-----------------------------------------------------------------------------
+bool EventTimeline::active() {
+	return used > 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of events held.
+//! @return The event count.
+//-----------------------------------------------------------------------------
+uint32_t EventTimeline::count() {
+	return used;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns one of the events, in time order.
+//! @param which The index of the event, below count.
+//! @return A reference to the event.
+//-----------------------------------------------------------------------------
+const TimelineEvent& EventTimeline::event(uint32_t which) {
+	return events[which];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the field a script names.
+//! @param name The name, as given in TIMELINE_NAMES.
+//! @return The field, one of the PacketField values, or -1 should no field
+//! a script may change go by the name.
+//-----------------------------------------------------------------------------
+int EventTimeline::field(const char* name) {
+
+	// Declare all relevant variables.
+	int i;
+
+	for (i = 0; i < FIELD_COUNT; ++i) {
+		if (TIMELINE_NAMES[i] != NULL && strcmp(TIMELINE_NAMES[i], name) ==
+			0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the first packet at or after a time, at the present period.
+//! A time within TIMELINE_TOLERANCE of a period of a packet falls on it, so
+//! that the rounding of the division cannot move a change by a packet. A
+//! time lying TIMELINE_REACH packets or more beyond the origin is never 
+//! reached, and is refused rather than converted out of range.
+//! @param time_s The time, in seconds from the first packet.
+//! @return The index of the packet, or TIMELINE_NONE for an unpaced run or a
+//! time beyond reach.
+//-----------------------------------------------------------------------------
+uint64_t EventTimeline::key(double time_s) {
+
+	// Declare all relevant variables.
+	double packets;
+
+	if (period <= 0) {
+		return TIMELINE_NONE;
+	}
+	if (time_s <= origin_s) {
+		return origin_packet;
+	}
+	packets = ceil((time_s - origin_s) / period - TIMELINE_TOLERANCE);
+	if (!(packets < TIMELINE_REACH - (double)origin_packet)) {
+		return TIMELINE_NONE;
+	}
+	return origin_packet + (uint64_t)packets;
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "stdafx.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "PacketLayout.h"
+
+// Establish the globally accessible macros.
+#define TIMELINE_NONE UINT64_MAX
+#define TIMELINE_LINE 256
+#define TIMELINE_GROWTH 64
+#define TIMELINE_TOLERANCE 1e-6
+#define TIMELINE_REACH 9223372036854775808.0
+
+//=============================================================================
+//! @struct TimelineEvent
+//!
+//! @brief A change of one packet field at a scripted time, held as the bits
+//! it places within its word, so that applying it is a single mask and merge.
+//=============================================================================
+struct TimelineEvent {
+
+	//! The time of the change, in seconds from the first packet.
+	double time_s;
+
+	//! The index of the first packet to carry the change, counting from the
+	//! first packet generated.
+	uint64_t packet;
+
+	//! The index of the word holding the field.
+	uint32_t word;
+
+	//! The bits occupied by the field within its word.
+	uint32_t mask;
+
+	//! The new value of the field, in place within its word.
+	uint32_t bits;
+};
+
+//=============================================================================
+//! @class EventTimeline
+//!
+//! @brief A scenario of field changes, loaded from a script and kept sorted
+//! by time. Once the transmission period is known, each change is keyed to
+//! the index of the first packet at or after its time, so that it applies on
+//! an exact packet boundary. The generator compares its packet count with
+//! the next key once per batch, and ends the batch at that key, so that a
+//! script of any length costs the same per packet. The changes applied so
+//! far are gathered into a mask and value per word, which the generator
+//! merges into the words of its sample.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class EventTimeline {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn EventTimeline
+	//!
+	//! @brief Constructs an EventTimeline instance.
+	//-------------------------------------------------------------------------
+	EventTimeline();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~EventTimeline
+	//!
+	//! @brief Destroys an EventTimeline instance.
+	//-------------------------------------------------------------------------
+	~EventTimeline();
+
+	//-------------------------------------------------------------------------
+	//! @fn load
+	//!
+	//! @brief Reads the events of a script, replacing any held.
+	//-------------------------------------------------------------------------
+	int load(const wchar_t* path);
+
+	//-------------------------------------------------------------------------
+	//! @fn add
+	//!
+	//! @brief Inserts a change of one field, keeping the events in time order.
+	//-------------------------------------------------------------------------
+	bool add(double time_s, uint32_t field, uint32_t value);
+
+	//-------------------------------------------------------------------------
+	//! @fn clear
+	//!
+	//! @brief Discards every event.
+	//-------------------------------------------------------------------------
+	void clear();
+
+	//-------------------------------------------------------------------------
+	//! @fn compile
+	//!
+	//! @brief Keys every event to its packet at the given period, and rewinds
+	//! the timeline to its start.
+	//-------------------------------------------------------------------------
+	void compile(double clkrate);
+
+	//-------------------------------------------------------------------------
+	//! @fn retime
+	//!
+	//! @brief Keys the events yet to apply to a new period, from a given
+	//! packet onward.
+	//-------------------------------------------------------------------------
+	void retime(uint64_t packet, double clkrate);
+
+	//-------------------------------------------------------------------------
+	//! @fn step
+	//!
+	//! @brief Applies every event due by the given packet.
+	//-------------------------------------------------------------------------
+	uint32_t step(uint64_t packet);
+
+	//-------------------------------------------------------------------------
+	//! @fn next
+	//!
+	//! @brief Returns the packet at which the next event applies.
+	//-------------------------------------------------------------------------
+	uint64_t next();
+
+	//-------------------------------------------------------------------------
+	//! @fn active
+	//!
+	//! @brief Returns whether the timeline holds any event.
+	//-------------------------------------------------------------------------
+	bool active();
+
+	//-------------------------------------------------------------------------
+	//! @fn count
+	//!
+	//! @brief Returns the number of events held.
+	//-------------------------------------------------------------------------
+	uint32_t count();
+
+	//-------------------------------------------------------------------------
+	//! @fn event
+	//!
+	//! @brief Returns one of the events, in time order.
+	//-------------------------------------------------------------------------
+	const TimelineEvent& event(uint32_t which);
+
+	//-------------------------------------------------------------------------
+	//! @fn field
+	//!
+	//! @brief Returns the field a script names.
+	//-------------------------------------------------------------------------
+	static int field(const char* name);
+
+	//! The bits of each word changed by the events applied so far.
+	uint32_t masks[PACKET_WORDS];
+
+	//! The values, in place, of the fields changed by the events applied so
+	//! far.
+	uint32_t values[PACKET_WORDS];
+
+	//! The line of the script at which loading failed, or zero.
+	uint32_t error_line;
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn key
+	//!
+	//! @brief Returns the first packet at or after a time.
+	//-------------------------------------------------------------------------
+	uint64_t key(double time_s);
+
+	//! The events, in time order, with those at equal times in script order.
+	TimelineEvent* events;
+
+	//! The number of events held.
+	uint32_t used;
+
+	//! The number of events for which space is allocated.
+	uint32_t capacity;
+
+	//! The index of the next event to apply.
+	uint32_t cursor;
+
+	//! The packet at which the next event applies, or TIMELINE_NONE.
+	uint64_t upcoming;
+
+	//! The time of the packet from which the events are keyed, in seconds.
+	double origin_s;
+
+	//! The packet from which the events are keyed.
+	uint64_t origin_packet;
+
+	//! The transmission period to which the events are keyed, in seconds.
+	double period;
+};
@@ -0,0 +1,258 @@
+#include "LatencyHistogram.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs an empty HistogramSnapshot instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+HistogramSnapshot::HistogramSnapshot() : counts(), total(0), sum(0), max(0) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Removes the counts of an earlier snapshot of the same histogram, 
+//! leaving those recorded in the interval between the two.
+//! @param earlier A snapshot of the same histogram taken before this one.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void HistogramSnapshot::subtract(const HistogramSnapshot& earlier) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	// Subtract the counts bucket by bucket. The greatest value cannot be 
+	// subtracted, so it is taken as the top of the highest occupied bucket.
+	max = 0;
+	for (i = 0; i < HIST_BUCKETS; ++i) {
+		counts[i] -= earlier.counts[i];
+		if (counts[i] != 0) {
+			max = i + 1 < HIST_BUCKETS ? LatencyHistogram::lowest(i + 1) - 1 :
+				UINT64_MAX;
+		}
+	}
+	total -= earlier.total;
+	sum -= earlier.sum;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Adds the counts of a snapshot of another histogram, so that 
+//! histograms recorded by several threads may be read as one.
+//! @param other The snapshot to add.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void HistogramSnapshot::add(const HistogramSnapshot& other) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	for (i = 0; i < HIST_BUCKETS; ++i) {
+		counts[i] += other.counts[i];
+	}
+	total += other.total;
+	sum += other.sum;
+	if (other.max > max) {
+		max = other.max;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of recorded values which exceed a value.
+//! @param value The value to exceed.
+//! @return The count of every bucket lying wholly above the value. A bucket
+//! straddling the value is not counted, so the result errs low by at most the
+//! bucket's width.
+//-----------------------------------------------------------------------------
+uint64_t HistogramSnapshot::above(uint64_t value) const {
+
+	// Declare all relevant variables.
+	uint64_t held;
+	uint32_t i;
+
+	held = 0;
+	for (i = LatencyHistogram::bucket(value) + 1; i < HIST_BUCKETS; ++i) {
+		held += counts[i];
+	}
+	return held;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the value beneath which a given share of the recorded values
+//! fall.
+//! @param share The share of the values, between zero and one.
+//! @return The least value of the bucket reaching the share, or zero if the
+//! snapshot is empty.
+//-----------------------------------------------------------------------------
+uint64_t HistogramSnapshot::percentile(double share) const {
+
+	// Declare all relevant variables.
+	uint64_t held;
+	uint64_t target;
+	uint64_t seen;
+	uint32_t i;
+
+	// The counts are copied one at a time while the writer runs, so the total
+	// is summed from them rather than taken from the separate counter.
+	held = 0;
+	for (i = 0; i < HIST_BUCKETS; ++i) {
+		held += counts[i];
+	}
+	if (held == 0) {
+		return 0;
+	}
+
+	// Walk the buckets until the share of the values is reached.
+	target = (uint64_t)(share * held + 0.5);
+	if (target < 1) {
+		target = 1;
+	}
+	seen = 0;
+	for (i = 0; i < HIST_BUCKETS; ++i) {
+		seen += counts[i];
+		if (seen >= target) {
+			return LatencyHistogram::lowest(i);
+		}
+	}
+	return max;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the mean of the recorded values.
+//! @return The mean, or zero if the snapshot is empty.
+//-----------------------------------------------------------------------------
+double HistogramSnapshot::mean() const {
+	return total > 0 ? (double)sum / total : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Writes the count, mean and quantiles as a JSON object.
+//! @param out The file to which the object is written.
+//! @param name The name given to the histogram.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void HistogramSnapshot::write(FILE* out, const char* name) const {
+	fprintf(out, "{\"name\": \"%s\", \"count\": %llu, \"mean\": %.1f, "
+		"\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, "
+		"\"max\": %llu}", name, (unsigned long long)total, mean(), 
+		(unsigned long long)percentile(0.5), (unsigned long long)percentile(
+		0.9), (unsigned long long)percentile(0.99), (unsigned long long)
+		percentile(0.999), (unsigned long long)max);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs an empty LatencyHistogram instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram() : total(0), sum(0), max(0) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	// Clear every bucket.
+	for (i = 0; i < HIST_BUCKETS; ++i) {
+		counts[i] = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Records a single value. Only the writing thread may call this, so
+//! each counter is advanced with a relaxed load and store, which compile to
+//! plain moves, and a reader sees every counter either before or after.
+//! @param value The value to record.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void LatencyHistogram::record(uint64_t value) {
+
+	// Declare all relevant variables.
+	uint32_t idx;
+
+	// Count the value within its bucket and the running totals.
+	idx = bucket(value);
+	counts[idx].store(counts[idx].load(std::memory_order_relaxed) + 1,
+		std::memory_order_relaxed);
+	total.store(total.load(std::memory_order_relaxed) + 1,
+		std::memory_order_relaxed);
+	sum.store(sum.load(std::memory_order_relaxed) + value,
+		std::memory_order_relaxed);
+	if (value > max.load(std::memory_order_relaxed)) {
+		max.store(value, std::memory_order_relaxed);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Copies the present counts into a snapshot, without pausing the 
+//! writing thread.
+//! @param snap A pointer to the snapshot to populate.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void LatencyHistogram::snapshot(HistogramSnapshot* snap) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	// Copy the totals, then each bucket. Values recorded during the copy may
+	// appear in one and not the other, which the quantiles tolerate.
+	snap->total = total.load(std::memory_order_relaxed);
+	snap->sum = sum.load(std::memory_order_relaxed);
+	snap->max = max.load(std::memory_order_relaxed);
+	for (i = 0; i < HIST_BUCKETS; ++i) {
+		snap->counts[i] = counts[i].load(std::memory_order_relaxed);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the bucket holding a value. Values below 2^HIST_SUB_BITS 
+//! each have their own bucket, and every later power of two is split into 
+//! HIST_HALF buckets by the bits following its highest.
+//! @param value The value to place.
+//! @return The index of the bucket.
+//-----------------------------------------------------------------------------
+uint32_t LatencyHistogram::bucket(uint64_t value) {
+
+	// Declare all relevant variables.
+	uint32_t octave;
+#ifdef _MSC_VER
+	unsigned long msb;
+#else
+	uint32_t msb;
+#endif
+
+	// Small values are held exactly.
+	if (value < (1u << HIST_SUB_BITS)) {
+		return (uint32_t)value;
+	}
+
+	// Find the highest set bit, which the 32-bit target must seek in halves.
+#if defined(_MSC_VER) && defined(_M_X64)
+	_BitScanReverse64(&msb, value);
+#elif defined(_MSC_VER)
+	if (_BitScanReverse(&msb, (unsigned long)(value >> 32))) {
+		msb += 32;
+	}
+	else {
+		_BitScanReverse(&msb, (unsigned long)value);
+	}
+#else
+	msb = 63 - __builtin_clzll(value);
+#endif
+
+	// Shift the value so that its highest HIST_SUB_BITS bits remain, and
+	// place it within the buckets of its octave.
+	octave = msb - HIST_SUB_BITS + 1;
+	return (octave + 1) * HIST_HALF + (uint32_t)(value >> octave) - HIST_HALF;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the least value held by a bucket.
+//! @param bucket The index of the bucket.
+//! @return The least value placed within the bucket.
+//-----------------------------------------------------------------------------
+uint64_t LatencyHistogram::lowest(uint32_t bucket) {
+
+	// Declare all relevant variables.
+	uint32_t octave;
+
+	// Reverse the placement of the value.
+	if (bucket < (1u << HIST_SUB_BITS)) {
+		return bucket;
+	}
+	octave = bucket / HIST_HALF - 1;
+	return (uint64_t)(bucket % HIST_HALF + HIST_HALF) << octave;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "stdafx.h"
+#include <stdio.h>
+#include <atomic>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Establish the globally accessible macros.
+#define HIST_SUB_BITS 5
+#define HIST_HALF (1u << (HIST_SUB_BITS - 1))
+#define HIST_BUCKETS ((66 - HIST_SUB_BITS) * HIST_HALF)
+
+//=============================================================================
+//! @class HistogramSnapshot
+//!
+//! @brief Holds a copy of the counts of a LatencyHistogram, taken at a single
+//! instant, from which the quantiles are read.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class HistogramSnapshot {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn HistogramSnapshot
+	//!
+	//! @brief Constructs an empty HistogramSnapshot instance.
+	//-------------------------------------------------------------------------
+	HistogramSnapshot();
+
+	//-------------------------------------------------------------------------
+	//! @fn subtract
+	//!
+	//! @brief Removes the counts of an earlier snapshot of the same histogram,
+	//! leaving those recorded in the interval between the two.
+	//-------------------------------------------------------------------------
+	void subtract(const HistogramSnapshot& earlier);
+
+	//-------------------------------------------------------------------------
+	//! @fn add
+	//!
+	//! @brief Adds the counts of a snapshot of another histogram, so that
+	//! histograms recorded by several threads may be read as one.
+	//-------------------------------------------------------------------------
+	void add(const HistogramSnapshot& other);
+
+	//-------------------------------------------------------------------------
+	//! @fn above
+	//!
+	//! @brief Returns the number of recorded values which exceed a value.
+	//-------------------------------------------------------------------------
+	uint64_t above(uint64_t value) const;
+
+	//-------------------------------------------------------------------------
+	//! @fn percentile
+	//!
+	//! @brief Returns the value beneath which a given share of the recorded
+	//! values fall.
+	//-------------------------------------------------------------------------
+	uint64_t percentile(double share) const;
+
+	//-------------------------------------------------------------------------
+	//! @fn mean
+	//!
+	//! @brief Returns the mean of the recorded values.
+	//-------------------------------------------------------------------------
+	double mean() const;
+
+	//-------------------------------------------------------------------------
+	//! @fn write
+	//!
+	//! @brief Writes the count, mean and quantiles as a JSON object.
+	//-------------------------------------------------------------------------
+	void write(FILE* out, const char* name) const;
+
+	//! The number of values recorded in each bucket.
+	uint64_t counts[HIST_BUCKETS];
+
+	//! The number of values recorded.
+	uint64_t total;
+
+	//! The sum of the values recorded.
+	uint64_t sum;
+
+	//! The greatest value recorded.
+	uint64_t max;
+};
+
+//=============================================================================
+//! @class LatencyHistogram
+//!
+//! @brief Records values into log-linear buckets in the manner of an HDR
+//! histogram, each power of two split into HIST_HALF buckets, so that every
+//! value is held to within about three percent across the full 64-bit range.
+//! A histogram has a single writing thread, which updates its counters with 
+//! plain relaxed stores rather than locked instructions, while any thread may
+//! take a snapshot without pausing it.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class LatencyHistogram {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn LatencyHistogram
+	//!
+	//! @brief Constructs an empty LatencyHistogram instance.
+	//-------------------------------------------------------------------------
+	LatencyHistogram();
+
+	//-------------------------------------------------------------------------
+	//! @fn record
+	//!
+	//! @brief Records a single value. Only the writing thread may call this.
+	//-------------------------------------------------------------------------
+	void record(uint64_t value);
+
+	//-------------------------------------------------------------------------
+	//! @fn snapshot
+	//!
+	//! @brief Copies the present counts into a snapshot.
+	//-------------------------------------------------------------------------
+	void snapshot(HistogramSnapshot* snap);
+
+	//-------------------------------------------------------------------------
+	//! @fn bucket
+	//!
+	//! @brief Returns the bucket holding a value.
+	//-------------------------------------------------------------------------
+	static uint32_t bucket(uint64_t value);
+
+	//-------------------------------------------------------------------------
+	//! @fn lowest
+	//!
+	//! @brief Returns the least value held by a bucket.
+	//-------------------------------------------------------------------------
+	static uint64_t lowest(uint32_t bucket);
+private:
+
+	//! The number of values recorded in each bucket.
+	std::atomic<uint64_t> counts[HIST_BUCKETS];
+
+	//! The number of values recorded.
+	std::atomic<uint64_t> total;
+
+	//! The sum of the values recorded.
+	std::atomic<uint64_t> sum;
+
+	//! The greatest value recorded.
+	std::atomic<uint64_t> max;
+};
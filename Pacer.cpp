@@ -0,0 +1,352 @@
+#include "Pacer.h"
+
+// Link the library providing the system timer resolution functions.
+#pragma comment(lib, "winmm.lib")
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a Pacer instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+Pacer::Pacer() : count(0), late_count(0), late_max(0), late_sum(0),
+	frequency(0), origin(0), origin_count(0), deadline(0), deadline_frac(0), 
+	released(0), period_ticks(0), period_frac(0), period_sec(0), spin_ticks(0),
+	oversleep_ticks(0), timer_raised(false), sleep_timer(NULL), 
+	lateness_log(NULL), clock(NULL) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER freq;
+
+	// Retrieve the fixed frequency of the performance counter.
+	QueryPerformanceFrequency(&freq);
+	frequency = freq.QuadPart;
+
+	// Allocate the lateness log up front, keeping the heap off the hot path.
+	lateness_log = new int64_t[PACE_LOG_LEN]();
+
+	// Create the timer on which to sleep, which is absent on older systems.
+	sleep_timer = CreateWaitableTimerExW(NULL, NULL, 
+		CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a Pacer instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+Pacer::~Pacer() {
+
+	// Release the timer resolution and the timer, and free the lateness log.
+	stop();
+	if (sleep_timer != NULL) {
+		CloseHandle(sleep_timer);
+	}
+	delete[] lateness_log;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Paces by a clock in place of the performance counter. A simulated 
+//! clock is advanced to each deadline rather than waited upon. This must 
+//! precede start.
+//! @param source The clock, or NULL to read the performance counter.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Pacer::setClock(Clock* source) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER freq;
+
+	// Adopt the frequency of whichever counter is read.
+	clock = source;
+	if (clock != NULL) {
+		frequency = clock->frequency();
+	}
+	else {
+		QueryPerformanceFrequency(&freq);
+		frequency = freq.QuadPart;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Anchors the schedule at the current instant.
+//! @param period The delay period between deadlines, in seconds.
+//! @param spin_us The margin, in microseconds, spun beyond the measured 
+//! oversleep of the coarse sleep.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Pacer::start(double period, uint32_t spin_us) {
+
+	// Declare all relevant variables.
+	double ticks;
+
+	// Raise the system timer resolution to one millisecond, so that the
+	// coarse sleep oversleeps by as little as the system allows. A simulated
+	// clock never sleeps.
+	if (!timer_raised && (clock == NULL || !clock->simulated()) && 
+		timeBeginPeriod(1) == TIMERR_NOERROR) {
+		timer_raised = true;
+	}
+
+	// Split the period into whole and 32-bit fractional counter ticks, so
+	// that the deadline accumulates exactly rather than being rounded once
+	// per packet.
+	ticks = period * frequency;
+	period_sec = period;
+	period_ticks = (int64_t)ticks;
+	period_frac = (uint32_t)((ticks - period_ticks) * 4294967296.0);
+	spin_ticks = (int64_t)spin_us * frequency / 1000000;
+
+	// Clear the statistics, and anchor the first deadline at the present.
+	count = 0;
+	late_count = 0;
+	late_max = 0;
+	late_sum = 0;
+	origin = now();
+	origin_count = 0;
+	deadline = origin;
+	deadline_frac = 0;
+	released = origin;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Changes the period of a running schedule. The next deadline is 
+//! placed one new period after the most recent deadline, which becomes the
+//! origin of the ideal instants, so that the schedule continues without a 
+//! gap or a burst, and the statistics are kept.
+//! @param period The delay period between deadlines, in seconds.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Pacer::retime(double period) {
+
+	// Declare all relevant variables.
+	double ticks;
+	uint32_t frac;
+
+	// Step the deadline back to the most recent one, borrowing from the 
+	// whole ticks should the fraction underflow. An unpaced schedule never
+	// moved its deadline, so it continues from its most recent release.
+	if (count > 0 && period_sec == 0) {
+		deadline = released;
+		deadline_frac = 0;
+	}
+	else if (count > 0) {
+		frac = deadline_frac - period_frac;
+		deadline -= period_ticks + (frac > deadline_frac ? 1 : 0);
+		deadline_frac = frac;
+	}
+
+	// Split the new period as start does, and anchor the ideal instants at
+	// the most recent deadline.
+	ticks = period * frequency;
+	period_sec = period;
+	period_ticks = (int64_t)ticks;
+	period_frac = (uint32_t)((ticks - period_ticks) * 4294967296.0);
+	origin = deadline;
+	origin_count = count > 0 ? count - 1 : 0;
+	if (count > 0) {
+		advance();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Releases the system timer resolution requested by start.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Pacer::stop() {
+
+	// Restore the timer resolution, if it was raised.
+	if (timer_raised) {
+		timeEndPeriod(1);
+		timer_raised = false;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Waits for the next deadline, or the last of a batch of deadlines, 
+//! and records the lateness with which each was reached.
+//! @param batch The number of deadlines released together. The release is
+//! made at the final deadline, so that no packet of the batch leaves early.
+//! @return The lateness of the first deadline of the batch, in nanoseconds.
+//-----------------------------------------------------------------------------
+int64_t Pacer::wait(uint32_t batch) {
+
+	// Declare all relevant variables.
+	int64_t first;
+	uint32_t first_frac;
+	int64_t current;
+	int64_t late;
+	int64_t first_late;
+	uint32_t i;
+
+	// Locate the final deadline of the batch, retaining the first so that
+	// every deadline may be recorded once the batch is released.
+	first = deadline;
+	first_frac = deadline_frac;
+	for (i = 1; i < batch; ++i) {
+		advance();
+	}
+
+	// Wait for the final deadline.
+	current = until(deadline);
+
+	// Record the lateness of every deadline in the batch. A deadline which
+	// has already passed is released immediately, so that a stalled
+	// transmitter catches up rather than shifting every later deadline.
+	deadline = first;
+	deadline_frac = first_frac;
+	first_late = 0;
+	for (i = 0; i < batch; ++i) {
+		late = (int64_t)((current - deadline) * 1e9 / frequency);
+		lateness_log[count & (PACE_LOG_LEN - 1)] = late;
+		late_sum += late;
+		if (late > late_max) {
+			late_max = late;
+		}
+		if (late > 0) {
+			++late_count;
+		}
+		if (i == 0) {
+			first_late = late;
+		}
+		++count;
+		advance();
+	}
+	released = current;
+
+	// Return the lateness of the first deadline.
+	return first_late;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Waits for an absolute performance counter reading, sleeping away the
+//! coarse part of the wait and spinning the remainder.
+//! @param target The counter reading at which to return.
+//! @return The counter reading at the release, which is at or after target.
+//-----------------------------------------------------------------------------
+int64_t Pacer::until(int64_t target) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER due;
+	int64_t current;
+	int64_t wait;
+	int64_t requested;
+	int64_t overran;
+	DWORD sleep_ms;
+
+	// A simulated clock is simply moved to the target.
+	if (clock != NULL && clock->simulated()) {
+		return clock->advance(target);
+	}
+
+	// Sleep away the coarse part of the wait, leaving the measured oversleep
+	// and the spin margin to be spun. The timer is set in units of 100 ns, 
+	// and without it the sleep is rounded down to whole milliseconds.
+	current = now();
+	wait = target - current - oversleep_ticks - spin_ticks;
+	requested = 0;
+	if (wait > 0 && sleep_timer != NULL) {
+		due.QuadPart = -(wait * 10000000 / frequency);
+		requested = -due.QuadPart * frequency / 10000000;
+		if (requested > 0 && SetWaitableTimer(sleep_timer, &due, 0, NULL, 
+			NULL, FALSE)) {
+			WaitForSingleObject(sleep_timer, INFINITE);
+		}
+		else {
+			requested = 0;
+		}
+	}
+	else if (wait > 0) {
+		sleep_ms = (DWORD)(wait * 1000 / frequency);
+		requested = (int64_t)sleep_ms * frequency / 1000;
+		if (sleep_ms > 0) {
+			Sleep(sleep_ms);
+		}
+	}
+
+	// Follow a longer overrun at once, so that the next wait is not late, 
+	// and a shorter one gradually, so that one quiet sleep does not shrink
+	// the margin.
+	if (requested > 0) {
+		overran = now() - current - requested;
+		current += requested + overran;
+		if (overran > oversleep_ticks) {
+			oversleep_ticks = overran;
+		}
+		else {
+			oversleep_ticks -= (oversleep_ticks - (overran > 0 ? overran : 0)) /
+				PACE_OVERSLEEP_DECAY;
+		}
+	}
+
+	// Spin for the remainder of the wait.
+	while (current < target) {
+		YieldProcessor();
+		current = now();
+	}
+	return current;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Reads the monotonic performance counter, or the clock paced by.
+//! @return The current instant, in counter ticks.
+//-----------------------------------------------------------------------------
+int64_t Pacer::now() {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER counter;
+
+	// Return the current counter value.
+	if (clock != NULL) {
+		return clock->now();
+	}
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the recorded lateness of a recent deadline.
+//! @param n The index of the deadline, counted from the anchor.
+//! @return The lateness of the deadline, in nanoseconds, or zero if it has
+//! fallen out of the log.
+//-----------------------------------------------------------------------------
+int64_t Pacer::lateness(uint64_t n) {
+
+	// Only the most recent deadlines are retained.
+	if (n >= count || count - n > PACE_LOG_LEN) {
+		return 0;
+	}
+	return lateness_log[n & (PACE_LOG_LEN - 1)];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the offset of the most recent release from its ideal
+//! instant, t0 + n * period.
+//! @return The offset, in seconds. This remains bounded by the lateness of a
+//! single release however long the schedule runs.
+//-----------------------------------------------------------------------------
+double Pacer::drift() {
+
+	// No release has been made since the schedule was anchored.
+	if (count == 0) {
+		return 0;
+	}
+
+	// Compare the release against the ideal instant, computed independently
+	// of the accumulated deadline.
+	return (double)(released - origin) / frequency - (double)(count - 1 - 
+		origin_count) * period_sec;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Steps the deadline forward by exactly one period.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Pacer::advance() {
+
+	// Declare all relevant variables.
+	uint32_t frac;
+
+	// Add the period to the deadline, carrying the fractional overflow into
+	// the whole ticks.
+	frac = deadline_frac + period_frac;
+	deadline += period_ticks + (frac < deadline_frac ? 1 : 0);
+	deadline_frac = frac;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "stdafx.h"
+#include <mmsystem.h>
+#include "Clock.h"
+
+// Establish the globally accessible macros.
+#define PACE_SPIN_US 50
+#define PACE_OVERSLEEP_DECAY 16
+#define PACE_LOG_LEN 4096
+
+// The flag requesting a waitable timer of sub-millisecond resolution, which
+// older SDKs do not define. Systems before Windows 10 version 1803 refuse it,
+// and the pacer then sleeps in whole milliseconds.
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+//=============================================================================
+//! @class Pacer
+//!
+//! @brief Releases the transmitter at absolute deadlines, t0 + n * period, on
+//! the monotonic performance counter. The coarse part of each wait is slept,
+//! and the remainder is spun, so that neither oversleep nor the work between
+//! deadlines accumulates into drift. The sleep is taken on a high-resolution
+//! waitable timer where the system offers one, and the spun remainder is a 
+//! few tens of microseconds beyond the oversleep measured of recent sleeps, 
+//! so that even a millisecond period leaves the processor idle for most of
+//! its wait.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class Pacer {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn Pacer
+	//!
+	//! @brief Constructs a Pacer instance.
+	//-------------------------------------------------------------------------
+	Pacer();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~Pacer
+	//!
+	//! @brief Destroys a Pacer instance.
+	//-------------------------------------------------------------------------
+	~Pacer();
+
+	//-------------------------------------------------------------------------
+	//! @fn setClock
+	//!
+	//! @brief Paces by a clock in place of the performance counter.
+	//-------------------------------------------------------------------------
+	void setClock(Clock* source);
+
+	//-------------------------------------------------------------------------
+	//! @fn start
+	//!
+	//! @brief Anchors the schedule at the current instant.
+	//-------------------------------------------------------------------------
+	void start(double period, uint32_t spin_us = PACE_SPIN_US);
+
+	//-------------------------------------------------------------------------
+	//! @fn retime
+	//!
+	//! @brief Changes the period of a running schedule from the next deadline
+	//! on, without disturbing those already reached.
+	//-------------------------------------------------------------------------
+	void retime(double period);
+
+	//-------------------------------------------------------------------------
+	//! @fn stop
+	//!
+	//! @brief Releases the system timer resolution requested by start.
+	//-------------------------------------------------------------------------
+	void stop();
+
+	//-------------------------------------------------------------------------
+	//! @fn wait
+	//!
+	//! @brief Waits for the next deadline, or the last of a batch of
+	//! deadlines, and records the lateness with which each was reached.
+	//-------------------------------------------------------------------------
+	int64_t wait(uint32_t batch = 1);
+
+	//-------------------------------------------------------------------------
+	//! @fn until
+	//!
+	//! @brief Waits for an absolute performance counter reading.
+	//-------------------------------------------------------------------------
+	int64_t until(int64_t target);
+
+	//-------------------------------------------------------------------------
+	//! @fn now
+	//!
+	//! @brief Reads the monotonic performance counter, or the clock paced by.
+	//-------------------------------------------------------------------------
+	int64_t now();
+
+	//-------------------------------------------------------------------------
+	//! @fn lateness
+	//!
+	//! @brief Returns the recorded lateness of a recent deadline.
+	//-------------------------------------------------------------------------
+	int64_t lateness(uint64_t n);
+
+	//-------------------------------------------------------------------------
+	//! @fn drift
+	//!
+	//! @brief Returns the offset of the most recent release from its ideal
+	//! instant, t0 + n * period.
+	//-------------------------------------------------------------------------
+	double drift();
+
+	//! The number of deadlines reached since the schedule was anchored.
+	uint64_t count;
+
+	//! The number of deadlines reached after their scheduled instant.
+	uint64_t late_count;
+
+	//! The greatest lateness recorded, in nanoseconds.
+	int64_t late_max;
+
+	//! The sum of every recorded lateness, in nanoseconds.
+	int64_t late_sum;
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn advance
+	//!
+	//! @brief Steps the deadline forward by exactly one period.
+	//-------------------------------------------------------------------------
+	void advance();
+
+	//! The frequency of the performance counter, in ticks per second.
+	int64_t frequency;
+
+	//! The instant at which the schedule was anchored, in counter ticks.
+	int64_t origin;
+
+	//! The number of deadlines reached before the schedule was last anchored
+	//! or retimed.
+	uint64_t origin_count;
+
+	//! The whole ticks of the next deadline.
+	int64_t deadline;
+
+	//! The fractional ticks of the next deadline, in units of 2^-32.
+	uint32_t deadline_frac;
+
+	//! The instant of the most recent release, in counter ticks.
+	int64_t released;
+
+	//! The whole ticks of the period.
+	int64_t period_ticks;
+
+	//! The fractional ticks of the period, in units of 2^-32.
+	uint32_t period_frac;
+
+	//! The period, in seconds, as requested by the user.
+	double period_sec;
+
+	//! The margin spun beyond the measured oversleep.
+	int64_t spin_ticks;
+
+	//! The time by which recent sleeps overran their request, in counter 
+	//! ticks, rising at once to a longer overrun and decaying slowly.
+	int64_t oversleep_ticks;
+
+	//! A flag signifying that the timer resolution has been raised.
+	bool timer_raised;
+
+	//! The high-resolution timer on which the coarse part of each wait is 
+	//! slept, or NULL to sleep in whole milliseconds.
+	HANDLE sleep_timer;
+
+	//! A circular log of the most recent deadline latenesses.
+	int64_t* lateness_log;
+
+	//! The clock paced by, or NULL to read the performance counter directly.
+	Clock* clock;
+};
@@ -1,4 +1,5 @@
 #include "Packet.h"
+#include <math.h>
 
 //-----------------------------------------------------------------------------
 //! @brief Constructs a Packet instance.
@@ -17,7 +18,9 @@ Packet::Packet(uint16_t sysid, uint16_t mode, uint8_t length, uint32_t number,
 	packet_length = length;
 	packet_number = number;
 	IRIG_time = IRIG;
-	antenna_position = position;
+	antenna_position = position % ROTATION_FULL;
+	antenna_phase = (uint64_t)antenna_position << PHASE_SHIFT;
+	antenna_step = 0;
 	transmitter_onoff = transmitter;
 	antenna_phasing = phasing;
 	integration_FP = integration;
@@ -25,7 +28,7 @@ Packet::Packet(uint16_t sysid, uint16_t mode, uint8_t length, uint32_t number,
 	channel_select = channel;
 	antenna_mode = antmode;
 	mode_switch = mswitch;
-	PRI_select = PRI_select;
+	PRI_select = PRI;
 	mode_m_select = mode_m;
 	AFC_onoff = AFC;
 	AGC_onoff = AGC;
@@ -33,72 +36,280 @@ Packet::Packet(uint16_t sysid, uint16_t mode, uint8_t length, uint32_t number,
 	adj_range_scale = adj_range;
 }
 
-//-------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
 //! @brief Sets the antenna position to the requested value.
-//! @param rotstart The initial antenna position.
+//! @param rotstart The initial antenna position, in degrees.
 //! @return Nothing.
-//-------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
 void Packet::setAntPos(double rotstart) {
 
-	antenna_position %= ROTATION_FULL;
+	// Round the angle to the nearest eighteen bit position, and place it in 
+	// the upper bits of the phase accumulator.
+	rotstart = fmod(rotstart, 360.0);
+	if (rotstart < 0) {
+		rotstart += 360.0;
+	}
+	antenna_position = (uint32_t)(rotstart / ROTATION_STEP + 0.5) % 
+		ROTATION_FULL;
+	antenna_phase = (uint64_t)antenna_position << PHASE_SHIFT;
 }
 
 //-----------------------------------------------------------------------------
-//! @brief Updates the antenna position for the requested rotation rate, at the 
-//! specified transmission period.
+//! @brief Sets the phase increment of the antenna for the requested rotation
+//! rate, at the specified transmission period.
 //! @param rotrate The rotation rate for the antenna, in degrees, at a constant
 //! duration of one second.
 //! @param clkrate The packet transmission rate, in seconds.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Packet::setAntRate(double rotrate, double clkrate) {
+
+	// Declare all relevant variables.
+	double rev;
+	double upper;
+	uint64_t high;
+
+	// Express the rotation per period as a fraction of a full rotation. Whole
+	// rotations vanish in the modular phase, and a negative rate wraps to its
+	// clockwise equivalent.
+	rev = fmod(rotrate * clkrate / 360.0, 1.0);
+	if (rev < 0) {
+		rev += 1.0;
+	}
+
+	// Scale the fraction to 2^64 in two 32-bit halves, retaining every bit of
+	// precision the double carries. The increment is computed once, so that
+	// each update is a single integer addition.
+	upper = rev * 4294967296.0;
+	high = (uint64_t)upper;
+	antenna_step = (high << 32) + (uint64_t)((upper - high) * 4294967296.0);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Advances the antenna position by one transmission period.
+//! @return Nothing
+//-----------------------------------------------------------------------------
+void Packet::updateAntPos() {
+
+	// Accumulate the phase exactly, wrapping at a full rotation, and take the
+	// upper eighteen bits as the antenna position.
+	antenna_phase += antenna_step;
+	antenna_position = (uint32_t)(antenna_phase >> PHASE_SHIFT);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Advances the antenna position by several transmission periods, 
+//! writing the position reached at each.
+//! @param positions A pointer to a memory location which shall be populated
+//! with one position per period.
+//! @param count The number of periods to advance.
 //! @return Nothing
 //-----------------------------------------------------------------------------
-void Packet::updateAntPos(double rotrate, double clkrate) {
+void Packet::updateAntPos(uint32_t* positions, uint32_t count) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	// Each position depends only on the starting phase and its own index, so
+	// the loop carries no dependency and may be vectorized.
+	for (i = 0; i < count; ++i) {
+		positions[i] = (uint32_t)((antenna_phase + (uint64_t)(i + 1) * 
+			antenna_step) >> PHASE_SHIFT);
+	}
+
+	// Advance the accumulator past the final period.
+	if (count > 0) {
+		antenna_phase += (uint64_t)count * antenna_step;
+		antenna_position = positions[count - 1];
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the phase accumulator of the antenna.
+//! @return The antenna phase, in units of 2^-64 of a full rotation.
+//-----------------------------------------------------------------------------
+uint64_t Packet::getAntPhase() {
+	return antenna_phase;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Sets the phase accumulator of the antenna.
+//! @param phase The antenna phase, in units of 2^-64 of a full rotation.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Packet::setAntPhase(uint64_t phase) {
+	antenna_phase = phase;
+	antenna_position = (uint32_t)(antenna_phase >> PHASE_SHIFT);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the phase increment of the antenna.
+//! @return The phase added for each transmission period.
+//-----------------------------------------------------------------------------
+uint64_t Packet::getAntStep() {
+	return antenna_step;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the antenna position of the packet.
+//! @return The antenna position (LSB=360/2^18 Degree).
+//-----------------------------------------------------------------------------
+uint32_t Packet::getAntPosition() {
+	return antenna_position;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the sequence number of the packet.
+//! @return The packet number, wrapping at 24 bits.
+//-----------------------------------------------------------------------------
+uint32_t Packet::getPacketNumber() {
+	return packet_number;
+}
 
-	// Calculate the rotation of the antenna for the specified rate and period, 
-	// converting the value to an eighteen bit representation.
-	antenna_position += (uint32_t)(clkrate * rotrate / ROTATION_STEP);
-	antenna_position %= ROTATION_FULL;
+//-----------------------------------------------------------------------------
+//! @brief Returns the IRIG time of the packet.
+//! @return The IRIG time (LSB=1 millisecond).
+//-----------------------------------------------------------------------------
+uint32_t Packet::getIRIGTime() {
+	return IRIG_time;
 }
 
 //-----------------------------------------------------------------------------
-//! @brief Converts the object instance into a contiguous array of words.
+//! @brief Returns the antenna mode of the packet.
+//! @return The antenna mode (0=Fixed 6 RPM, 1=Fixed 12RPM, 2=Manual CW, 
+//! 3=Manual CCW, 4=Stopped).
+//-----------------------------------------------------------------------------
+uint8_t Packet::getAntMode() {
+	return antenna_mode;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the mode M selection of the packet.
+//! @return The mode M selection (0=Sector, 1=Flicker 1, 2=Flicker 2, 3=Not 
+//! Selected).
+//-----------------------------------------------------------------------------
+uint8_t Packet::getModeM() {
+	return mode_m_select;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Converts the object instance into a contiguous array of words, in 
+//! the wire byte order.
 //! @param arr A pointer to a memory location which shall be populated.
 //! @return Nothing.
 //-----------------------------------------------------------------------------
 void Packet::convert(uint32_t* arr) {
 
-	// Create an empty array of six words, and set an initial value.
-	for (int i = 0; i < 6; ++i) {
+	// Declare all relevant variables.
+	int i;
+
+	// Encode the fields, then order the bytes of each word for the wire.
+	encode(arr);
+	for (i = 0; i < PACKET_WORDS; ++i) {
+		arr[i] = PacketLayout::toWire(arr[i]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Converts several packets into one contiguous array of words, in the
+//! wire byte order.
+//! @param packets A pointer to the packets to be converted.
+//! @param count The number of packets to be converted.
+//! @param arr A pointer to a memory location of count * PACKET_WORDS words
+//! which shall be populated.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Packet::convertBatch(Packet* packets, uint32_t count, uint32_t* arr) {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	// Encode every packet in host order, then order the whole buffer for the
+	// wire in a single vectorized pass.
+	for (i = 0; i < count; ++i) {
+		packets[i].encode(arr + (size_t)i * PACKET_WORDS);
+	}
+	PacketLayout::toWire(arr, (size_t)count * PACKET_WORDS);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Populates the object instance from an array of words in the wire 
+//! byte order.
+//! @param arr A pointer to the words of a single packet.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Packet::parse(const uint32_t* arr) {
+
+	// Declare all relevant variables.
+	uint32_t words[PACKET_WORDS];
+	int i;
+
+	// Restore the host byte order of each word.
+	for (i = 0; i < PACKET_WORDS; ++i) {
+		words[i] = PacketLayout::fromWire(arr[i]);
+	}
+
+	// Extract every field through the layout.
+	system_id = (uint16_t)PacketLayout::get<FIELD_SYSTEM_ID>(words);
+	mode_setting = (uint16_t)PacketLayout::get<FIELD_MODE_SETTING>(words);
+	packet_length = (uint8_t)PacketLayout::get<FIELD_PACKET_LENGTH>(words);
+	packet_number = PacketLayout::get<FIELD_PACKET_NUMBER>(words);
+	IRIG_time = PacketLayout::get<FIELD_IRIG_TIME>(words);
+	antenna_position = PacketLayout::get<FIELD_ANTENNA_POSITION>(words);
+	transmitter_onoff = (uint8_t)PacketLayout::get<FIELD_TRANSMITTER_ONOFF>(
+		words);
+	antenna_phasing = (uint8_t)PacketLayout::get<FIELD_ANTENNA_PHASING>(words);
+	integration_FP = (uint8_t)PacketLayout::get<FIELD_INTEGRATION_FP>(words);
+	range_scale = (uint8_t)PacketLayout::get<FIELD_RANGE_SCALE>(words);
+	channel_select = (uint8_t)PacketLayout::get<FIELD_CHANNEL_SELECT>(words);
+	antenna_mode = (uint8_t)PacketLayout::get<FIELD_ANTENNA_MODE>(words);
+	mode_switch = (uint8_t)PacketLayout::get<FIELD_MODE_SWITCH>(words);
+	PRI_select = (uint8_t)PacketLayout::get<FIELD_PRI_SELECT>(words);
+	mode_m_select = (uint8_t)PacketLayout::get<FIELD_MODE_M_SELECT>(words);
+	AFC_onoff = (uint8_t)PacketLayout::get<FIELD_AFC_ONOFF>(words);
+	AGC_onoff = (uint8_t)PacketLayout::get<FIELD_AGC_ONOFF>(words);
+	MGC_voltage = (uint8_t)PacketLayout::get<FIELD_MGC_VOLTAGE>(words);
+	adj_range_scale = (uint8_t)PacketLayout::get<FIELD_ADJ_RANGE_SCALE>(words);
+
+	// Restore the phase accumulator from the received position.
+	antenna_phase = (uint64_t)(antenna_position % ROTATION_FULL) << 
+		PHASE_SHIFT;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Places every field into an array of words in host byte order.
+//! @param arr A pointer to a memory location which shall be populated.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Packet::encode(uint32_t* arr) {
+
+	// Declare all relevant variables.
+	int i;
+
+	// Clear the words, as each field is merged into its word.
+	for (i = 0; i < PACKET_WORDS; ++i) {
 		arr[i] = 0;
 	}
 
-	// Establish the first word of the array.
-	arr[0] += system_id;
-	arr[0] += mode_setting << 16;
-
-	// Establish the second word of the array.
-	arr[1] += packet_length;
-	arr[1] += packet_number << 8;
-
-	// Establish the third word of the array.
-	arr[2] += IRIG_time;
-
-	// Establish the fourth word of the array.
-	arr[3] += antenna_position;
-
-	// Establish the fifth word of the array.
-	arr[4] += transmitter_onoff << 1;
-	arr[4] += antenna_phasing << 2;
-	arr[4] += integration_FP << 3;
-	arr[4] += range_scale << 4;
-	arr[4] += channel_select << 6;
-	arr[4] += antenna_mode << 9;
-	arr[4] += mode_switch << 12;
-	arr[4] += PRI_select << 14;
-	arr[4] += mode_m_select << 16;
-	arr[4] += AFC_onoff << 18;
-	arr[4] += AGC_onoff << 19;
-
-	// Establish the sixth word of the array.
-	arr[5] += MGC_voltage;
-	arr[5] += adj_range_scale << 8;
-}
\ No newline at end of file
+	// Place every field through the layout. Each placement reduces to a
+	// constant shift and mask, with no branch on the field values.
+	PacketLayout::set<FIELD_SYSTEM_ID>(arr, system_id);
+	PacketLayout::set<FIELD_MODE_SETTING>(arr, mode_setting);
+	PacketLayout::set<FIELD_PACKET_LENGTH>(arr, packet_length);
+	PacketLayout::set<FIELD_PACKET_NUMBER>(arr, packet_number);
+	PacketLayout::set<FIELD_IRIG_TIME>(arr, IRIG_time);
+	PacketLayout::set<FIELD_ANTENNA_POSITION>(arr, antenna_position);
+	PacketLayout::set<FIELD_TRANSMITTER_ONOFF>(arr, transmitter_onoff);
+	PacketLayout::set<FIELD_ANTENNA_PHASING>(arr, antenna_phasing);
+	PacketLayout::set<FIELD_INTEGRATION_FP>(arr, integration_FP);
+	PacketLayout::set<FIELD_RANGE_SCALE>(arr, range_scale);
+	PacketLayout::set<FIELD_CHANNEL_SELECT>(arr, channel_select);
+	PacketLayout::set<FIELD_ANTENNA_MODE>(arr, antenna_mode);
+	PacketLayout::set<FIELD_MODE_SWITCH>(arr, mode_switch);
+	PacketLayout::set<FIELD_PRI_SELECT>(arr, PRI_select);
+	PacketLayout::set<FIELD_MODE_M_SELECT>(arr, mode_m_select);
+	PacketLayout::set<FIELD_AFC_ONOFF>(arr, AFC_onoff);
+	PacketLayout::set<FIELD_AGC_ONOFF>(arr, AGC_onoff);
+	PacketLayout::set<FIELD_MGC_VOLTAGE>(arr, MGC_voltage);
+	PacketLayout::set<FIELD_ADJ_RANGE_SCALE>(arr, adj_range_scale);
+}
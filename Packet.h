@@ -1,8 +1,12 @@
+#pragma once
+
 #include <stdint.h>
+#include "PacketLayout.h"
 
 // Establish the globally accessible macros.
 #define ROTATION_STEP 0.001373291015625
 #define ROTATION_FULL 262144
+#define PHASE_SHIFT 46
 
 //=============================================================================
 //! @class Packet
@@ -25,28 +29,123 @@ public:
 		uint8_t MGC = 0, uint8_t adj_range = 0);
 
 	//-------------------------------------------------------------------------
-	//! @fn updateAntPos
+	//! @fn setAntPos
 	//!
 	//! @brief Sets the antenna position to the requested value.
 	//-------------------------------------------------------------------------
 	void setAntPos(double rotstart);
 
+	//-------------------------------------------------------------------------
+	//! @fn setAntRate
+	//!
+	//! @brief Sets the phase increment of the antenna for the requested 
+	//! rotation rate, at the specified transmission period.
+	//-------------------------------------------------------------------------
+	void setAntRate(double rotrate, double clkrate);
+
 	//-------------------------------------------------------------------------
 	//! @fn updateAntPos
 	//!
-	//! @brief Updates the antenna position for the requested rotation rate, at 
-	//! the specified transmission period.
+	//! @brief Advances the antenna position by one transmission period.
+	//-------------------------------------------------------------------------
+	void updateAntPos();
+
+	//-------------------------------------------------------------------------
+	//! @fn updateAntPos
+	//!
+	//! @brief Advances the antenna position by several transmission periods,
+	//! writing the position reached at each.
+	//-------------------------------------------------------------------------
+	void updateAntPos(uint32_t* positions, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn getAntPhase
+	//!
+	//! @brief Returns the phase accumulator of the antenna.
 	//-------------------------------------------------------------------------
-	void updateAntPos(double rotrate, double clkrate);
+	uint64_t getAntPhase();
+
+	//-------------------------------------------------------------------------
+	//! @fn setAntPhase
+	//!
+	//! @brief Sets the phase accumulator of the antenna.
+	//-------------------------------------------------------------------------
+	void setAntPhase(uint64_t phase);
+
+	//-------------------------------------------------------------------------
+	//! @fn getAntStep
+	//!
+	//! @brief Returns the phase increment of the antenna.
+	//-------------------------------------------------------------------------
+	uint64_t getAntStep();
+
+	//-------------------------------------------------------------------------
+	//! @fn getAntPosition
+	//!
+	//! @brief Returns the antenna position of the packet.
+	//-------------------------------------------------------------------------
+	uint32_t getAntPosition();
+
+	//-------------------------------------------------------------------------
+	//! @fn getPacketNumber
+	//!
+	//! @brief Returns the sequence number of the packet.
+	//-------------------------------------------------------------------------
+	uint32_t getPacketNumber();
+
+	//-------------------------------------------------------------------------
+	//! @fn getIRIGTime
+	//!
+	//! @brief Returns the IRIG time of the packet.
+	//-------------------------------------------------------------------------
+	uint32_t getIRIGTime();
+
+	//-------------------------------------------------------------------------
+	//! @fn getAntMode
+	//!
+	//! @brief Returns the antenna mode of the packet.
+	//-------------------------------------------------------------------------
+	uint8_t getAntMode();
+
+	//-------------------------------------------------------------------------
+	//! @fn getModeM
+	//!
+	//! @brief Returns the mode M selection of the packet.
+	//-------------------------------------------------------------------------
+	uint8_t getModeM();
 
 	//-------------------------------------------------------------------------
 	//! @fn convert
 	//!
-	//! @brief Converts the object instance into a contiguous array of words.
+	//! @brief Converts the object instance into a contiguous array of words,
+	//! in the wire byte order.
 	//-------------------------------------------------------------------------
 	void convert(uint32_t* arr);
+
+	//-------------------------------------------------------------------------
+	//! @fn convertBatch
+	//!
+	//! @brief Converts several packets into one contiguous array of words, in
+	//! the wire byte order.
+	//-------------------------------------------------------------------------
+	static void convertBatch(Packet* packets, uint32_t count, uint32_t* arr);
+
+	//-------------------------------------------------------------------------
+	//! @fn parse
+	//!
+	//! @brief Populates the object instance from an array of words in the 
+	//! wire byte order.
+	//-------------------------------------------------------------------------
+	void parse(const uint32_t* arr);
 private:
 
+	//-------------------------------------------------------------------------
+	//! @fn encode
+	//!
+	//! @brief Places every field into an array of words in host byte order.
+	//-------------------------------------------------------------------------
+	void encode(uint32_t* arr);
+
 	//! (WORD: 0, 16 bits) Binary System ID (See SYSTEM_ID.IN)
 	uint16_t system_id;
 
@@ -65,6 +164,13 @@ private:
 	//! (WORD: 3, 32 bits) Antenna Position (LSB=360/2^18  Degree)
 	uint32_t antenna_position;
 
+	//! The antenna phase, as a fraction of a full rotation in units of 2^-64.
+	//! The antenna position holds its upper eighteen bits.
+	uint64_t antenna_phase;
+
+	//! The phase added to the antenna for each transmission period.
+	uint64_t antenna_step;
+
 	//! (WORD: 4,  1 bits) Transmitter On/Off (0=Off, 1=On) 
 	uint8_t transmitter_onoff;
 
@@ -0,0 +1,601 @@
+#include "PacketArchive.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Writes a value as a varint, seven bits per byte with the high bit
+//! flagging a following byte.
+//! @param out The position to which the value is written.
+//! @param value The value to write.
+//! @return The position following the value.
+//-----------------------------------------------------------------------------
+static uint8_t* putVarint(uint8_t* out, uint32_t value) {
+	while (value >= 0x80) {
+		*out++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (uint8_t)value;
+	return out;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Reads a varint written by putVarint.
+//! @param in The position from which the value is read.
+//! @param end The position beyond the last readable byte.
+//! @param value A pointer to a value which shall be populated with the result.
+//! @return The position following the value, or NULL if the value runs past
+//! the end.
+//-----------------------------------------------------------------------------
+static const uint8_t* getVarint(const uint8_t* in, const uint8_t* end,
+	uint32_t* value) {
+
+	// Declare all relevant variables.
+	uint32_t result;
+	uint32_t shift;
+
+	// Gather seven bits per byte until a byte without the high bit.
+	result = 0;
+	for (shift = 0; shift < 35 && in < end; shift += 7) {
+		result |= (uint32_t)(*in & 0x7F) << shift;
+		if ((*in++ & 0x80) == 0) {
+			*value = result;
+			return in;
+		}
+	}
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the delta between successive values of a column, wrapped by
+//! its range and folded so that small steps of either sign take few bits.
+//! @param from The preceding value.
+//! @param to The following value.
+//! @param range The greatest value of the column.
+//! @return The folded delta.
+//-----------------------------------------------------------------------------
+static uint32_t foldDelta(uint32_t from, uint32_t to, uint32_t range) {
+
+	// Declare all relevant variables.
+	uint32_t delta;
+	int64_t step;
+
+	// Take the delta modulo the range, reading its upper half as negative, so
+	// that a wrap of the field is a small step rather than a large one.
+	delta = (to - from) & range;
+	step = delta > (range >> 1) ? (int64_t)delta - range - 1 : delta;
+
+	// Interleave the signs, counting 0, -1, 1, -2, 2 and so on.
+	return (uint32_t)((step << 1) ^ (step >> 63));
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Applies a delta folded by foldDelta.
+//! @param from The preceding value.
+//! @param folded The folded delta.
+//! @param range The greatest value of the column.
+//! @return The following value.
+//-----------------------------------------------------------------------------
+static uint32_t unfoldDelta(uint32_t from, uint32_t folded, uint32_t range) {
+	return (from + ((folded >> 1) ^ (0 - (folded & 1)))) & range;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a PacketArchive instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+PacketArchive::PacketArchive() : file(NULL), writable(false), header(),
+	column_word(), column_shift(), column_mask(), column_range(), columns(),
+	block_fill(0), block_pos(0), block_next(0), block_constant(0), 
+	block_base(), buffer(NULL), index(NULL), index_capacity(0), 
+	file_bytes(0), last_irig(0), day_offset(0) {
+
+	// Declare all relevant variables.
+	uint32_t col;
+
+	// Locate every column once, and allocate the columns and the block 
+	// buffer up front, so that neither appending nor reading touches the 
+	// heap. A folded delta takes at most ARCHIVE_VARINT_MAX bytes, followed by
+	// a run of no more.
+	for (col = 0; col < ARCHIVE_COLUMNS; ++col) {
+		column_word[col] = wordOf(col);
+		column_shift[col] = shiftOf(col);
+		column_mask[col] = maskOf(col);
+		column_range[col] = rangeOf(col);
+		columns[col] = new uint32_t[ARCHIVE_BLOCK];
+	}
+	buffer = new uint8_t[ARCHIVE_BUFFER];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a PacketArchive instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+PacketArchive::~PacketArchive() {
+
+	// Declare all relevant variables.
+	uint32_t col;
+
+	// Close the archive, should it still be open, and free the buffers.
+	if (file != NULL) {
+		close();
+	}
+	for (col = 0; col < ARCHIVE_COLUMNS; ++col) {
+		delete[] columns[col];
+	}
+	delete[] buffer;
+	delete[] index;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Creates an archive to which packets may be appended. The header is
+//! completed, and the block index written, once the archive is closed.
+//! @param path The location of the archive, which is replaced if it exists.
+//! @return A zero value, if successful, or the error code otherwise.
+//-----------------------------------------------------------------------------
+int PacketArchive::create(const wchar_t* path) {
+
+	// Declare all relevant variables.
+	int err;
+
+	// Open the file, and reserve the space of the header.
+	err = _wfopen_s(&file, path, L"wb");
+	if (err != 0 || file == NULL) {
+		file = NULL;
+		return err != 0 ? err : ERROR_OPEN_FAILED;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+	header.version = ARCHIVE_VERSION;
+	header.block_packets = ARCHIVE_BLOCK;
+	fwrite(&header, sizeof(header), 1, file);
+	file_bytes = sizeof(header);
+
+	// Begin with an empty block and index.
+	writable = true;
+	block_fill = 0;
+	last_irig = 0;
+	day_offset = 0;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Opens an existing archive, and reads its block index.
+//! @param path The location of the archive.
+//! @return A zero value, if successful, ERROR_BAD_FORMAT should the header or
+//! index not describe a file of this size, or the error code otherwise.
+//-----------------------------------------------------------------------------
+int PacketArchive::load(const wchar_t* path) {
+
+	// Declare all relevant variables.
+	int64_t size;
+	uint64_t block;
+	int err;
+
+	// Open the file and check the header against this build. An archive
+	// without an index was never closed, and cannot be sought.
+	err = _wfopen_s(&file, path, L"rb");
+	if (err != 0 || file == NULL) {
+		file = NULL;
+		return err != 0 ? err : ERROR_OPEN_FAILED;
+	}
+	writable = false;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic,
+		ARCHIVE_MAGIC, sizeof(header.magic)) != 0 || header.version !=
+		ARCHIVE_VERSION || header.block_packets != ARCHIVE_BLOCK ||
+		header.index_offset == 0) {
+		close();
+		return ERROR_BAD_FORMAT;
+	}
+
+	// Check that the index lies within the file, before allocating for it.
+	size = _fseeki64(file, 0, SEEK_END) == 0 ? _ftelli64(file) : -1;
+	if (size < (int64_t)sizeof(header) || header.index_offset < sizeof(
+		header) || header.index_offset > (uint64_t)size || header.blocks > 
+		((uint64_t)size - header.index_offset) / sizeof(ArchiveBlock)) {
+		close();
+		return ERROR_BAD_FORMAT;
+	}
+
+	// Read the whole block index, which trails the final block.
+	delete[] index;
+	index = new ArchiveBlock[header.blocks + 1];
+	index_capacity = header.blocks + 1;
+	if (_fseeki64(file, (int64_t)header.index_offset, SEEK_SET) != 0 ||
+		fread(index, sizeof(ArchiveBlock), (size_t)header.blocks, file) !=
+		header.blocks) {
+		close();
+		return ERROR_BAD_FORMAT;
+	}
+
+	// Refuse any block which would overrun the buffer it is decoded from, or
+	// the index which follows the final block.
+	for (block = 0; block < header.blocks; ++block) {
+		if (index[block].bytes > ARCHIVE_BUFFER || index[block].offset < 
+			sizeof(header) || index[block].offset > header.index_offset ||
+			index[block].bytes > header.index_offset - index[block].offset) {
+			close();
+			return ERROR_BAD_FORMAT;
+		}
+	}
+	file_bytes = header.index_offset + header.blocks * sizeof(ArchiveBlock);
+	rewind();
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Writes any partial block and the block index, completes the header,
+//! and closes the archive.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketArchive::close() {
+
+	// Finish a created archive with the index and the completed header.
+	if (writable) {
+		if (block_fill > 0) {
+			encodeBlock();
+		}
+		header.index_offset = file_bytes;
+		fwrite(index, sizeof(ArchiveBlock), (size_t)header.blocks, file);
+		file_bytes += header.blocks * sizeof(ArchiveBlock);
+		_fseeki64(file, 0, SEEK_SET);
+		fwrite(&header, sizeof(header), 1, file);
+		writable = false;
+	}
+
+	// Close the file.
+	fclose(file);
+	file = NULL;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Appends packets to a created archive, splitting each into its
+//! columns and writing out every block that fills.
+//! @param arr The wire words of the packets, PACKET_WORDS per packet.
+//! @param count The number of packets.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketArchive::append(const uint32_t* arr, uint32_t count) {
+
+	// Declare all relevant variables.
+	uint32_t words[PACKET_WORDS];
+	ArchiveBlock* grown;
+	uint32_t irig;
+	uint32_t col;
+	uint32_t i;
+	uint32_t j;
+
+	for (i = 0; i < count; ++i, arr += PACKET_WORDS) {
+
+		// Return the words to the host order, and split them into columns.
+		for (j = 0; j < PACKET_WORDS; ++j) {
+			words[j] = PacketLayout::fromWire(arr[j]);
+		}
+		for (col = 0; col < ARCHIVE_COLUMNS; ++col) {
+			columns[col][block_fill] = (words[column_word[col]] & 
+				column_mask[col]) >> column_shift[col];
+		}
+
+		// Count a midnight whenever the IRIG time falls back by more than
+		// half a day, so that the index keys continue to increase.
+		irig = columns[FIELD_IRIG_TIME][block_fill];
+		if (header.packets > 0 && irig + IRIG_DAY_MS / 2 < last_irig) {
+			day_offset += IRIG_DAY_MS;
+		}
+		last_irig = irig;
+
+		// Grow the index, doubling it, at the first packet of a block.
+		if (block_fill == 0) {
+			if (header.blocks == index_capacity) {
+				index_capacity = index_capacity == 0 ? 64 : index_capacity * 2;
+				grown = new ArchiveBlock[index_capacity];
+				if (header.blocks > 0) {
+					memcpy(grown, index, (size_t)header.blocks * sizeof(
+						ArchiveBlock));
+				}
+				delete[] index;
+				index = grown;
+			}
+			index[header.blocks].offset = file_bytes;
+			index[header.blocks].first_packet = header.packets;
+			index[header.blocks].first_time = day_offset + irig;
+		}
+		++header.packets;
+
+		// Write out the block once it fills.
+		if (++block_fill == ARCHIVE_BLOCK) {
+			encodeBlock();
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Encodes the buffered columns as a block and writes it out. Each
+//! column flagged constant holds its single value; any other holds its first
+//! value, followed by pairs of a folded delta and the number of successive
+//! values advancing by it.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketArchive::encodeBlock() {
+
+	// Declare all relevant variables.
+	uint8_t* out;
+	uint8_t* first;
+	uint32_t* values;
+	uint32_t constant;
+	uint32_t range;
+	uint32_t delta;
+	uint32_t next;
+	uint32_t run;
+	uint32_t col;
+	uint32_t i;
+
+	// Leave room for the packet count and the constant flags.
+	out = buffer + sizeof(block_fill) + sizeof(constant);
+	constant = 0;
+	for (col = 0; col < ARCHIVE_COLUMNS; ++col) {
+
+		// Write the first value, then gather the deltas into runs.
+		values = columns[col];
+		out = putVarint(out, values[0]);
+		first = out;
+		range = column_range[col];
+		delta = 0;
+		run = 0;
+		for (i = 1; i < block_fill; ++i) {
+			next = foldDelta(values[i - 1], values[i], range);
+			if (run > 0 && next != delta) {
+				out = putVarint(out, delta);
+				out = putVarint(out, run);
+				run = 0;
+			}
+			delta = next;
+			++run;
+		}
+
+		// A column which never changed is a single run without a step, and
+		// is flagged constant in place of holding the run.
+		if (delta == 0 && out == first) {
+			constant |= 1u << col;
+			continue;
+		}
+		out = putVarint(out, delta);
+		out = putVarint(out, run);
+	}
+	memcpy(buffer, &block_fill, sizeof(block_fill));
+	memcpy(buffer + sizeof(block_fill), &constant, sizeof(constant));
+
+	// Write the block, and complete its index entry.
+	fwrite(buffer, 1, out - buffer, file);
+	index[header.blocks].bytes = (uint32_t)(out - buffer);
+	index[header.blocks].count = block_fill;
+	file_bytes += out - buffer;
+	++header.blocks;
+	block_fill = 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Reads a block and decodes it into the columns.
+//! @param block The index of the block.
+//! @return Whether the block was decoded.
+//-----------------------------------------------------------------------------
+bool PacketArchive::decodeBlock(uint64_t block) {
+
+	// Declare all relevant variables.
+	const uint8_t* in;
+	const uint8_t* end;
+	uint32_t* values;
+	uint32_t constant;
+	uint32_t range;
+	uint32_t delta;
+	uint32_t step;
+	uint32_t base;
+	uint32_t run;
+	uint32_t col;
+	uint32_t i;
+	uint32_t j;
+
+	// Read the whole block into the buffer.
+	block_fill = 0;
+	block_pos = 0;
+	if (block >= header.blocks || _fseeki64(file, (int64_t)index[block].
+		offset, SEEK_SET) != 0 || fread(buffer, 1, index[block].bytes, file)
+		!= index[block].bytes) {
+		return false;
+	}
+	in = buffer;
+	end = buffer + index[block].bytes;
+	memcpy(&block_fill, in, sizeof(block_fill));
+	memcpy(&constant, in + sizeof(block_fill), sizeof(constant));
+	in += sizeof(block_fill) + sizeof(constant);
+	if (block_fill != index[block].count || block_fill > ARCHIVE_BLOCK) {
+		block_fill = 0;
+		return false;
+	}
+
+	// Compose the constant columns into the words shared by every packet of
+	// the block, and expand each other column by replaying its runs, where 
+	// each run advances from its base by a multiple of its step.
+	memset(block_base, 0, sizeof(block_base));
+	block_constant = constant;
+	for (col = 0; col < ARCHIVE_COLUMNS; ++col) {
+		values = columns[col];
+		in = getVarint(in, end, &values[0]);
+		if (in == NULL) {
+			block_fill = 0;
+			return false;
+		}
+		if ((constant >> col) & 1) {
+			block_base[column_word[col]] |= values[0] << column_shift[col];
+			continue;
+		}
+		range = column_range[col];
+		for (i = 1; i < block_fill; i += run) {
+			in = getVarint(in, end, &delta);
+			if (in != NULL) {
+				in = getVarint(in, end, &run);
+			}
+			if (in == NULL || run == 0 || run > block_fill - i) {
+				block_fill = 0;
+				return false;
+			}
+			step = unfoldDelta(0, delta, 0xFFFFFFFF);
+			base = values[i - 1];
+			for (j = 0; j < run; ++j) {
+				values[i + j] = (base + (j + 1) * step) & range;
+			}
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Decodes the next packets of a loaded archive into wire words,
+//! decoding each block as the reading position enters it.
+//! @param arr The destination of the wire words, PACKET_WORDS per packet.
+//! @param count The greatest number of packets to decode.
+//! @return The number of packets decoded, which is zero once the archive is
+//! exhausted.
+//-----------------------------------------------------------------------------
+uint32_t PacketArchive::read(uint32_t* arr, uint32_t count) {
+
+	// Declare all relevant variables.
+	uint32_t* words;
+	uint32_t* values;
+	uint32_t* target;
+	uint32_t shift;
+	uint32_t done;
+	uint32_t take;
+	uint32_t col;
+	uint32_t i;
+
+	done = 0;
+	while (done < count) {
+
+		// Decode the following block once the current one is exhausted.
+		if (block_pos == block_fill) {
+			if (!decodeBlock(block_next)) {
+				break;
+			}
+			++block_next;
+		}
+
+		// Compose the packets from the constant words, then merge in the 
+		// other columns a column at a time, so that each pass is a simple 
+		// shift and merge over consecutive values.
+		take = block_fill - block_pos;
+		if (take > count - done) {
+			take = count - done;
+		}
+		words = arr + (size_t)done * PACKET_WORDS;
+		for (i = 0; i < take; ++i) {
+			memcpy(words + i * PACKET_WORDS, block_base, PACKET_BYTES);
+		}
+		for (col = 0; col < ARCHIVE_COLUMNS; ++col) {
+			if ((block_constant >> col) & 1) {
+				continue;
+			}
+			values = columns[col] + block_pos;
+			target = words + column_word[col];
+			shift = column_shift[col];
+			for (i = 0; i < take; ++i) {
+				target[i * PACKET_WORDS] |= values[i] << shift;
+			}
+		}
+		PacketLayout::toWire(words, (size_t)take * PACKET_WORDS);
+		block_pos += take;
+		done += take;
+	}
+	return done;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Moves the reading position to the first packet at or after an IRIG
+//! time, by a binary search of the block index and a scan of one block.
+//! @param irig_ms The IRIG time, in milliseconds since midnight. A time
+//! earlier than the first packet is taken to fall on the following day.
+//! @return Whether any packet lies at or after the time.
+//-----------------------------------------------------------------------------
+bool PacketArchive::seek(uint32_t irig_ms) {
+
+	// Declare all relevant variables.
+	uint64_t target;
+	uint64_t low;
+	uint64_t high;
+	uint64_t mid;
+	uint64_t first;
+	uint32_t* irig;
+
+	if (header.blocks == 0) {
+		return false;
+	}
+
+	// Place the time on the same count of days as the index keys.
+	target = irig_ms;
+	if (target < index[0].first_time) {
+		target += IRIG_DAY_MS;
+	}
+
+	// Find the last block beginning at or before the time.
+	low = 0;
+	high = header.blocks;
+	while (high - low > 1) {
+		mid = low + (high - low) / 2;
+		if (index[mid].first_time <= target) {
+			low = mid;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	// Decode the block, and skip the packets which precede the time,
+	// measuring each from the start of the block across any midnight. Should
+	// every packet precede it, the position rests at the end of the block,
+	// and reading continues from the next.
+	if (!decodeBlock(low)) {
+		return false;
+	}
+	block_next = low + 1;
+	irig = columns[FIELD_IRIG_TIME];
+	first = index[low].first_time;
+	if ((block_constant >> FIELD_IRIG_TIME) & 1) {
+		block_pos = first < target ? block_fill : 0;
+	}
+	while (block_pos < block_fill && first + ((uint64_t)irig[block_pos] +
+		IRIG_DAY_MS - irig[0]) % IRIG_DAY_MS < target) {
+		++block_pos;
+	}
+	return block_pos < block_fill || block_next < header.blocks;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Moves the reading position to the first packet.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketArchive::rewind() {
+	block_fill = 0;
+	block_pos = 0;
+	block_next = 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns whether an archive is open.
+//! @return Whether an archive has been created or loaded, and not closed.
+//-----------------------------------------------------------------------------
+bool PacketArchive::active() {
+	return file != NULL;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of packets held.
+//! @return The number of packets appended to, or held by, the archive.
+//-----------------------------------------------------------------------------
+uint64_t PacketArchive::count() {
+	return header.packets;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of bytes written to, or held by, the file.
+//! @return The size of the archive, including the index once closed.
+//-----------------------------------------------------------------------------
+uint64_t PacketArchive::bytes() {
+	return file_bytes;
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+#include "stdafx.h"
+#include <stdio.h>
+#include "PacketLayout.h"
+
+// Establish the globally accessible macros.
+#define ARCHIVE_MAGIC "eGRIMARC"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_BLOCK 4096
+#define ARCHIVE_COLUMNS (FIELD_COUNT + PACKET_WORDS)
+#define ARCHIVE_VARINT_MAX 10
+#define ARCHIVE_BUFFER (2 * sizeof(uint32_t) + ARCHIVE_COLUMNS * \
+	(ARCHIVE_VARINT_MAX + ARCHIVE_BLOCK * (ARCHIVE_VARINT_MAX + \
+	ARCHIVE_VARINT_MAX)))
+
+//=============================================================================
+//! @struct ArchiveHeader
+//!
+//! @brief The header opening an archive, locating the block index which
+//! follows the final block.
+//=============================================================================
+struct ArchiveHeader {
+
+	//! The characters identifying an archive, ARCHIVE_MAGIC.
+	char magic[8];
+
+	//! The version of the archive format.
+	uint32_t version;
+
+	//! The greatest number of packets held by each block.
+	uint32_t block_packets;
+
+	//! The number of packets held by the archive.
+	uint64_t packets;
+
+	//! The number of blocks, and so of index entries.
+	uint64_t blocks;
+
+	//! The offset of the block index from the start of the file, or zero if
+	//! the archive was never closed.
+	uint64_t index_offset;
+};
+
+//=============================================================================
+//! @struct ArchiveBlock
+//!
+//! @brief An entry of the block index, locating a block within the file and
+//! the IRIG time at which it begins.
+//=============================================================================
+struct ArchiveBlock {
+
+	//! The offset of the block from the start of the file.
+	uint64_t offset;
+
+	//! The index of the first packet of the block within the archive.
+	uint64_t first_packet;
+
+	//! The IRIG time of the first packet, in milliseconds, counted from the
+	//! midnight before the first packet of the archive so that it increases
+	//! across later midnights.
+	uint64_t first_time;
+
+	//! The number of bytes taken by the block.
+	uint32_t bytes;
+
+	//! The number of packets held by the block.
+	uint32_t count;
+};
+
+//=============================================================================
+//! @class PacketArchive
+//!
+//! @brief Stores long runs of packets in columns, one per field along with 
+//! one per word for any bits outside the fields. Within each block, a column
+//! which never changes is stored once, and any other is stored as its first 
+//! value followed by runs of equal deltas, so that the constant fields cost 
+//! nothing and the advancing fields cost a few bytes per change of step. A 
+//! block index keyed by IRIG time allows a seek by binary search, and blocks
+//! are decoded whole into the columns, from which packets are streamed.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class PacketArchive {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn PacketArchive
+	//!
+	//! @brief Constructs a PacketArchive instance.
+	//-------------------------------------------------------------------------
+	PacketArchive();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~PacketArchive
+	//!
+	//! @brief Destroys a PacketArchive instance.
+	//-------------------------------------------------------------------------
+	~PacketArchive();
+
+	//-------------------------------------------------------------------------
+	//! @fn create
+	//!
+	//! @brief Creates an archive to which packets may be appended.
+	//-------------------------------------------------------------------------
+	int create(const wchar_t* path);
+
+	//-------------------------------------------------------------------------
+	//! @fn load
+	//!
+	//! @brief Opens an existing archive, and reads its block index.
+	//-------------------------------------------------------------------------
+	int load(const wchar_t* path);
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Writes any partial block and the block index, and closes the
+	//! archive.
+	//-------------------------------------------------------------------------
+	void close();
+
+	//-------------------------------------------------------------------------
+	//! @fn append
+	//!
+	//! @brief Appends packets, given as wire words, to a created archive.
+	//-------------------------------------------------------------------------
+	void append(const uint32_t* arr, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn read
+	//!
+	//! @brief Decodes the next packets of a loaded archive into wire words.
+	//-------------------------------------------------------------------------
+	uint32_t read(uint32_t* arr, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn seek
+	//!
+	//! @brief Moves the reading position to the first packet at or after an
+	//! IRIG time.
+	//-------------------------------------------------------------------------
+	bool seek(uint32_t irig_ms);
+
+	//-------------------------------------------------------------------------
+	//! @fn rewind
+	//!
+	//! @brief Moves the reading position to the first packet.
+	//-------------------------------------------------------------------------
+	void rewind();
+
+	//-------------------------------------------------------------------------
+	//! @fn active
+	//!
+	//! @brief Returns whether an archive is open.
+	//-------------------------------------------------------------------------
+	bool active();
+
+	//-------------------------------------------------------------------------
+	//! @fn count
+	//!
+	//! @brief Returns the number of packets held.
+	//-------------------------------------------------------------------------
+	uint64_t count();
+
+	//-------------------------------------------------------------------------
+	//! @fn bytes
+	//!
+	//! @brief Returns the number of bytes written to, or held by, the file.
+	//-------------------------------------------------------------------------
+	uint64_t bytes();
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn encodeBlock
+	//!
+	//! @brief Encodes the buffered columns as a block and writes it out.
+	//-------------------------------------------------------------------------
+	void encodeBlock();
+
+	//-------------------------------------------------------------------------
+	//! @fn decodeBlock
+	//!
+	//! @brief Reads a block and decodes it into the columns.
+	//-------------------------------------------------------------------------
+	bool decodeBlock(uint64_t block);
+
+	//-------------------------------------------------------------------------
+	//! @fn wordOf
+	//!
+	//! @brief Returns the index of the word holding a column.
+	//-------------------------------------------------------------------------
+	static constexpr uint32_t wordOf(uint32_t col) {
+		return col < FIELD_COUNT ? PACKET_LAYOUT[col].word : col - FIELD_COUNT;
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn shiftOf
+	//!
+	//! @brief Returns the bit offset of a column within its word.
+	//-------------------------------------------------------------------------
+	static constexpr uint32_t shiftOf(uint32_t col) {
+		return col < FIELD_COUNT ? PACKET_LAYOUT[col].shift : 0;
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn maskOf
+	//!
+	//! @brief Returns the bits occupied by a column within its word, where the
+	//! column of each word takes whichever bits no field occupies.
+	//-------------------------------------------------------------------------
+	static constexpr uint32_t maskOf(uint32_t col) {
+		uint32_t bits = 0xFFFFFFFF;
+		if (col < FIELD_COUNT) {
+			return PacketLayout::mask(col);
+		}
+		for (uint32_t i = 0; i < FIELD_COUNT; ++i) {
+			if (PACKET_LAYOUT[i].word == col - FIELD_COUNT) {
+				bits &= ~PacketLayout::mask(i);
+			}
+		}
+		return bits;
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn rangeOf
+	//!
+	//! @brief Returns the greatest value of a column once shifted down, by
+	//! which its deltas wrap. The bits outside the fields wrap as a word.
+	//-------------------------------------------------------------------------
+	static constexpr uint32_t rangeOf(uint32_t col) {
+		return col < FIELD_COUNT ? PacketLayout::mask(col) >> 
+			PACKET_LAYOUT[col].shift : 0xFFFFFFFF;
+	}
+
+	//! The archive file.
+	FILE* file;
+
+	//! A flag signifying that the archive was created for appending.
+	bool writable;
+
+	//! The header, as read or as it shall be written.
+	ArchiveHeader header;
+
+	//! The word, bit offset, bits and greatest value of each column.
+	uint32_t column_word[ARCHIVE_COLUMNS];
+	uint32_t column_shift[ARCHIVE_COLUMNS];
+	uint32_t column_mask[ARCHIVE_COLUMNS];
+	uint32_t column_range[ARCHIVE_COLUMNS];
+
+	//! The buffered values of each column for the current block.
+	uint32_t* columns[ARCHIVE_COLUMNS];
+
+	//! The number of packets buffered in, or decoded into, the columns.
+	uint32_t block_fill;
+
+	//! The next packet of the decoded block to be read.
+	uint32_t block_pos;
+
+	//! The next block to be decoded.
+	uint64_t block_next;
+
+	//! The flags of the columns constant across the decoded block, whose 
+	//! values are held only at the first packet.
+	uint32_t block_constant;
+
+	//! The words composed of the constant columns of the decoded block.
+	uint32_t block_base[PACKET_WORDS];
+
+	//! A buffer holding one encoded block.
+	uint8_t* buffer;
+
+	//! The block index.
+	ArchiveBlock* index;
+
+	//! The number of entries allocated for the block index.
+	uint64_t index_capacity;
+
+	//! The number of bytes written to, or held by, the file.
+	uint64_t file_bytes;
+
+	//! The most recent IRIG time appended, for counting midnights.
+	uint32_t last_irig;
+
+	//! The milliseconds added for the midnights passed since the first packet.
+	uint64_t day_offset;
+};
+
+// Every column must have a bit among the constant flags of a block.
+static_assert(ARCHIVE_COLUMNS <= 32, "The archive has too many columns.");
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LAYOUT_SSE2
+#endif
+
+// Establish the globally accessible macros.
+#define PACKET_WORDS 6
+#define PACKET_BYTES (PACKET_WORDS * 4)
+#define PACKET_NUMBER_MASK 0x00FFFFFF
+#define IRIG_DAY_MS 86400000
+#define WIRE_LITTLE_ENDIAN 0
+#define WIRE_BIG_ENDIAN 1
+
+// An aggregated datagram, or frame, carries consecutive packets back to back,
+// each complete with its own length and number, and no more of them than fit
+// an Ethernet MTU beneath the IPv4 and UDP headers.
+#define FRAME_BYTES 1472
+#define FRAME_PACKETS (FRAME_BYTES / PACKET_BYTES)
+
+// The byte order of each word on the wire. The FPGA device has always
+// received the words least significant byte first, which the network order
+// may replace by defining PACKET_WIRE_ORDER as WIRE_BIG_ENDIAN.
+#ifndef PACKET_WIRE_ORDER
+#define PACKET_WIRE_ORDER WIRE_LITTLE_ENDIAN
+#endif
+
+//=============================================================================
+//! @enum PacketField
+//!
+//! @brief Enumerates the fields of the packet, in the order of the layout.
+//=============================================================================
+enum PacketField {
+	FIELD_SYSTEM_ID,
+	FIELD_MODE_SETTING,
+	FIELD_PACKET_LENGTH,
+	FIELD_PACKET_NUMBER,
+	FIELD_IRIG_TIME,
+	FIELD_ANTENNA_POSITION,
+	FIELD_TRANSMITTER_ONOFF,
+	FIELD_ANTENNA_PHASING,
+	FIELD_INTEGRATION_FP,
+	FIELD_RANGE_SCALE,
+	FIELD_CHANNEL_SELECT,
+	FIELD_ANTENNA_MODE,
+	FIELD_MODE_SWITCH,
+	FIELD_PRI_SELECT,
+	FIELD_MODE_M_SELECT,
+	FIELD_AFC_ONOFF,
+	FIELD_AGC_ONOFF,
+	FIELD_MGC_VOLTAGE,
+	FIELD_ADJ_RANGE_SCALE,
+	FIELD_COUNT
+};
+
+//=============================================================================
+//! @struct FieldLayout
+//!
+//! @brief Locates a single field within the packet words.
+//=============================================================================
+struct FieldLayout {
+
+	//! The index of the word holding the field.
+	uint32_t word;
+
+	//! The bit offset of the field's least significant bit.
+	uint32_t shift;
+
+	//! The number of bits in the field.
+	uint32_t width;
+};
+
+//! The location of every field, indexed by PacketField.
+static constexpr FieldLayout PACKET_LAYOUT[FIELD_COUNT] = {
+	{ 0,  0, 16 },	// System ID
+	{ 0, 16, 16 },	// Mode Setting
+	{ 1,  0,  8 },	// Packet Length
+	{ 1,  8, 24 },	// Packet Number
+	{ 2,  0, 32 },	// IRIG Time
+	{ 3,  0, 32 },	// Antenna Position
+	{ 4,  1,  1 },	// Transmitter On/Off
+	{ 4,  2,  1 },	// Antenna Phasing
+	{ 4,  3,  1 },	// Integration FP
+	{ 4,  4,  2 },	// Range Scale
+	{ 4,  6,  3 },	// Channel Select
+	{ 4,  9,  3 },	// Antenna Mode
+	{ 4, 12,  2 },	// Mode Switch
+	{ 4, 14,  1 },	// PRI Select
+	{ 4, 16,  2 },	// Mode M Select
+	{ 4, 18,  1 },	// AFC On/Off
+	{ 4, 19,  1 },	// AGC On/Off
+	{ 5,  0,  8 },	// MGC Voltage
+	{ 5,  8,  8 }	// Adjustable Range Scale
+};
+
+//=============================================================================
+//! @class PacketLayout
+//!
+//! @brief Derives the packet encoder and decoder from PACKET_LAYOUT at
+//! compile time, so that every field is placed by a constant shift and mask.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class PacketLayout {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn mask
+	//!
+	//! @brief Returns the bits occupied by a field within its word.
+	//-------------------------------------------------------------------------
+	static constexpr uint32_t mask(uint32_t field) {
+		return (uint32_t)((((uint64_t)1 << PACKET_LAYOUT[field].width) - 1) <<
+			PACKET_LAYOUT[field].shift);
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn inWords
+	//!
+	//! @brief Returns whether every field lies within the packet words.
+	//-------------------------------------------------------------------------
+	static constexpr bool inWords() {
+		for (uint32_t i = 0; i < FIELD_COUNT; ++i) {
+			if (PACKET_LAYOUT[i].word >= PACKET_WORDS) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn inWidth
+	//!
+	//! @brief Returns whether every field fits within its 32-bit word.
+	//-------------------------------------------------------------------------
+	static constexpr bool inWidth() {
+		for (uint32_t i = 0; i < FIELD_COUNT; ++i) {
+			if (PACKET_LAYOUT[i].width == 0 || PACKET_LAYOUT[i].shift +
+				PACKET_LAYOUT[i].width > 32) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn disjoint
+	//!
+	//! @brief Returns whether no two fields share a bit.
+	//-------------------------------------------------------------------------
+	static constexpr bool disjoint() {
+		for (uint32_t i = 0; i < FIELD_COUNT; ++i) {
+			for (uint32_t j = i + 1; j < FIELD_COUNT; ++j) {
+				if (PACKET_LAYOUT[i].word == PACKET_LAYOUT[j].word &&
+					(mask(i) & mask(j)) != 0) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn set
+	//!
+	//! @brief Places a value into its field, truncated to the field width.
+	//-------------------------------------------------------------------------
+	template <PacketField F>
+	static void set(uint32_t* words, uint32_t value) {
+		words[PACKET_LAYOUT[F].word] |= (value << PACKET_LAYOUT[F].shift) &
+			mask(F);
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn clear
+	//!
+	//! @brief Clears the bits of a field, leaving its neighbours untouched.
+	//-------------------------------------------------------------------------
+	template <PacketField F>
+	static void clear(uint32_t* words) {
+		words[PACKET_LAYOUT[F].word] &= ~mask(F);
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn get
+	//!
+	//! @brief Extracts the value of a field.
+	//-------------------------------------------------------------------------
+	template <PacketField F>
+	static uint32_t get(const uint32_t* words) {
+		return (words[PACKET_LAYOUT[F].word] & mask(F)) >>
+			PACKET_LAYOUT[F].shift;
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn swap
+	//!
+	//! @brief Reverses the bytes of a word.
+	//-------------------------------------------------------------------------
+	static uint32_t swap(uint32_t word) {
+		return (word >> 24) | ((word >> 8) & 0x0000FF00) | ((word << 8) &
+			0x00FF0000) | (word << 24);
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn toWire
+	//!
+	//! @brief Converts a host word into the wire byte order. Every Windows
+	//! target is little-endian, so only the big-endian order swaps.
+	//-------------------------------------------------------------------------
+	static uint32_t toWire(uint32_t word) {
+		return PACKET_WIRE_ORDER == WIRE_BIG_ENDIAN ? swap(word) : word;
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn fromWire
+	//!
+	//! @brief Converts a wire word into the host byte order.
+	//-------------------------------------------------------------------------
+	static uint32_t fromWire(uint32_t word) {
+		return toWire(word);
+	}
+
+	//-------------------------------------------------------------------------
+	//! @fn toWire
+	//!
+	//! @brief Converts a contiguous buffer of host words into the wire byte
+	//! order in place, four words per SSE2 operation.
+	//-------------------------------------------------------------------------
+	static void toWire(uint32_t* words, size_t count) {
+
+		// Declare all relevant variables.
+		size_t i;
+
+		// The little-endian order leaves the buffer untouched.
+		if (PACKET_WIRE_ORDER != WIRE_BIG_ENDIAN) {
+			return;
+		}
+
+		// Swap the bytes within each 32-bit lane by exchanging the bytes of
+		// each half, then the halves themselves.
+		i = 0;
+#ifdef LAYOUT_SSE2
+		for (; i + 4 <= count; i += 4) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(words + i));
+			v = _mm_or_si128(_mm_srli_epi16(v, 8), _mm_slli_epi16(v, 8));
+			v = _mm_or_si128(_mm_srli_epi32(v, 16), _mm_slli_epi32(v, 16));
+			_mm_storeu_si128((__m128i*)(words + i), v);
+		}
+#endif
+		for (; i < count; ++i) {
+			words[i] = swap(words[i]);
+		}
+	}
+};
+
+// Reject any layout in which a field leaves its word or overlaps another.
+static_assert(PacketLayout::inWords(), "A packet field lies beyond the "
+	"packet words.");
+static_assert(PacketLayout::inWidth(), "A packet field exceeds its word.");
+static_assert(PacketLayout::disjoint(), "Two packet fields overlap.");
@@ -0,0 +1,278 @@
+#include "PacketReceiver.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a PacketReceiver instance.
+//! @param addr The address on which to receive, either the multicast group
+//! targeted by the generator or a local unicast address.
+//! @param port The communication port on which to receive.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+PacketReceiver::PacketReceiver(char* addr, int port) : received(0), lost(0),
+	reordered(0), malformed(0), position_jumps(0), jitter_ns(0),
+	latency_max_ms(0), active_process(false), recv_socket(INVALID_SOCKET),
+	recv_address(), recvthread(NULL), timestamp(), frequency(0), started(
+	false), last_number(0), last_position(0), last_step(ROTATION_FULL),
+	last_arrival(0), last_gap(-1) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER freq;
+	uint32_t i;
+
+	// Clear the inter-arrival histogram.
+	for (i = 0; i < RECV_BUCKETS; ++i) {
+		buckets[i] = 0;
+	}
+
+	// Retrieve the counter frequency, against which arrivals are measured.
+	QueryPerformanceFrequency(&freq);
+	frequency = freq.QuadPart;
+
+	// Establish the address on which to receive.
+	memset((char*)&recv_address, 0, sizeof(recv_address));
+	recv_address.sin_family = AF_INET;
+	recv_address.sin_port = htons(port);
+	inet_pton(AF_INET, addr, &recv_address.sin_addr.s_addr);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a PacketReceiver instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+PacketReceiver::~PacketReceiver() {
+
+	// Finish the thread and clean up the socket, should the receiver still be
+	// running.
+	if (recvthread != NULL) {
+		uninit();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Binds the socket, joins the multicast group where the address is
+//! one, and commences the receiving thread.
+//! @return A zero value, if successful, or the socket error otherwise.
+//-----------------------------------------------------------------------------
+int PacketReceiver::init() {
+
+	// Declare all relevant variables.
+	WSADATA wsadata;
+	sockaddr_in bind_address;
+	ip_mreq group;
+	DWORD timeout;
+	int buffer;
+	int reuse;
+	int err;
+
+	// Establish the windows socket startup sequence.
+	if (WSAStartup(MAKEWORD(2, 2), &wsadata) != NO_ERROR) {
+		return WSASYSNOTREADY;
+	}
+
+	// Establish the receiving socket under the UDP protocol, sharing the port
+	// with any other listener, and enlarging the receive buffer so that a
+	// burst is not dropped while the thread is descheduled.
+	recv_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (recv_socket == INVALID_SOCKET) {
+		err = WSAGetLastError();
+		WSACleanup();
+		return err;
+	}
+	reuse = 1;
+	buffer = RECV_BUFFER_BYTES;
+	timeout = RECV_TIMEOUT_MS;
+	setsockopt(recv_socket, SOL_SOCKET, SO_REUSEADDR, (char*)&reuse, sizeof(
+		reuse));
+	setsockopt(recv_socket, SOL_SOCKET, SO_RCVBUF, (char*)&buffer, sizeof(
+		buffer));
+	setsockopt(recv_socket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(
+		timeout));
+
+	// A multicast group is received by binding to the port on every
+	// interface and joining the group. A unicast address is bound directly.
+	bind_address = recv_address;
+	if (IN_MULTICAST(ntohl(recv_address.sin_addr.s_addr))) {
+		bind_address.sin_addr.s_addr = htonl(INADDR_ANY);
+	}
+	if (bind(recv_socket, (SOCKADDR*)&bind_address, sizeof(bind_address)) ==
+		SOCKET_ERROR) {
+		err = WSAGetLastError();
+		closesocket(recv_socket);
+		WSACleanup();
+		return err;
+	}
+	if (IN_MULTICAST(ntohl(recv_address.sin_addr.s_addr))) {
+		group.imr_multiaddr = recv_address.sin_addr;
+		group.imr_interface.s_addr = htonl(INADDR_ANY);
+		if (setsockopt(recv_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)
+			&group, sizeof(group)) == SOCKET_ERROR) {
+			err = WSAGetLastError();
+			closesocket(recv_socket);
+			WSACleanup();
+			return err;
+		}
+	}
+
+	// Anchor the clock against which the IRIG times are compared, then start
+	// the receiving thread.
+	timestamp.anchor();
+	active_process = true;
+	recvthread = new std::thread(&PacketReceiver::receive, this);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Finishes the receiving thread and closes the socket.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketReceiver::uninit() {
+
+	// Toggle the active process flag, which the thread observes within one
+	// receive timeout, and join it.
+	active_process = false;
+	recvthread->join();
+	delete recvthread;
+	recvthread = NULL;
+
+	// Close the socket connection and perform cleanup operations.
+	closesocket(recv_socket);
+	recv_socket = INVALID_SOCKET;
+	WSACleanup();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Receives and validates datagrams until the receiver is stopped.
+//! Winsock offers no call receiving several datagrams at once, so each is
+//! received into the same buffer and validated in place. A datagram may be
+//! a frame of several packets, which are unpacked in order and share its 
+//! arrival time.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketReceiver::receive() {
+
+	// Declare all relevant variables.
+	uint32_t words[FRAME_BYTES / 4 + 1];
+	LARGE_INTEGER arrival;
+	int length;
+	int offset;
+
+	// Receive until stopped, timing each datagram as soon as it is returned.
+	// A timeout merely gives the loop the chance to observe the flag.
+	while (active_process) {
+		length = recv(recv_socket, (char*)words, sizeof(words), 0);
+		if (length == SOCKET_ERROR) {
+			continue;
+		}
+		QueryPerformanceCounter(&arrival);
+		if (length < PACKET_BYTES || length % PACKET_BYTES != 0) {
+			malformed.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+		for (offset = 0; offset < length; offset += PACKET_BYTES) {
+			validate(words + offset / 4, arrival.QuadPart);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Decodes a single packet and accounts for it in the statistics.
+//! @param arr A pointer to the wire words of the packet.
+//! @param arrival The performance counter reading at its arrival.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketReceiver::validate(const uint32_t* arr, int64_t arrival) {
+
+	// Declare all relevant variables.
+	Packet pckt;
+	uint32_t number;
+	uint32_t ahead;
+	uint32_t step;
+	uint32_t drift;
+	int64_t gap;
+	int64_t variation;
+	int64_t jitter;
+	int64_t latency;
+	uint32_t bucket;
+
+	// Decode the packet, the inverse of its conversion by the generator.
+	pckt.parse(arr);
+	number = pckt.getPacketNumber();
+	received.fetch_add(1, std::memory_order_relaxed);
+
+	// Compare the IRIG time against the local clock, allowing for the wrap
+	// at midnight.
+	latency = (int64_t)timestamp.irig(arrival) - pckt.getIRIGTime();
+	if (latency < -IRIG_DAY_MS / 2) {
+		latency += IRIG_DAY_MS;
+	}
+	if (latency > latency_max_ms.load(std::memory_order_relaxed)) {
+		latency_max_ms.store(latency, std::memory_order_relaxed);
+	}
+
+	// The first packet only establishes the sequence.
+	if (!started) {
+		started = true;
+		last_number = number;
+		last_position = pckt.getAntPosition();
+		last_arrival = arrival;
+		return;
+	}
+
+	// A number at or behind the greatest received, within half the 24-bit 
+	// range, is a duplicate or arrived late. A late packet was counted as 
+	// lost when the gap opened, so it is recounted as reordered.
+	ahead = (number - last_number) & PACKET_NUMBER_MASK;
+	if (ahead == 0 || ahead > PACKET_NUMBER_MASK / 2) {
+		reordered.fetch_add(1, std::memory_order_relaxed);
+		if (ahead != 0 && lost.load(std::memory_order_relaxed) > 0) {
+			lost.fetch_sub(1, std::memory_order_relaxed);
+		}
+		return;
+	}
+	lost.fetch_add(ahead - 1, std::memory_order_relaxed);
+
+	// Between consecutive packets, the antenna step should match the step
+	// before it to within the one position of rounding in the accumulator.
+	step = (pckt.getAntPosition() - last_position) & (ROTATION_FULL - 1);
+	if (ahead == 1) {
+		if (last_step != ROTATION_FULL) {
+			drift = (step - last_step) & (ROTATION_FULL - 1);
+			if (drift > 1 && drift < ROTATION_FULL - 1) {
+				position_jumps.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		last_step = step;
+	}
+	else {
+		last_step = ROTATION_FULL;
+	}
+	last_number = number;
+	last_position = pckt.getAntPosition();
+
+	// Place the inter-arrival time into its power-of-two bucket, and smooth
+	// the variation between successive gaps as RFC 3550 does.
+	gap = (int64_t)((arrival - last_arrival) * 1e9 / frequency);
+	last_arrival = arrival;
+	bucket = 0;
+	while (bucket < RECV_BUCKETS - 1 && (gap / 1000) >> bucket != 0) {
+		++bucket;
+	}
+	buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	if (last_gap >= 0) {
+		variation = gap > last_gap ? gap - last_gap : last_gap - gap;
+		jitter = jitter_ns.load(std::memory_order_relaxed);
+		jitter_ns.store(jitter + (variation - jitter) / RECV_JITTER_GAIN,
+			std::memory_order_relaxed);
+	}
+	last_gap = gap;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of inter-arrival times within a bucket.
+//! @param bucket The bucket, where zero holds gaps under one microsecond and
+//! bucket b holds gaps from 2^(b-1) up to 2^b microseconds.
+//! @return The number of gaps within the bucket.
+//-----------------------------------------------------------------------------
+uint64_t PacketReceiver::histogram(uint32_t bucket) {
+	return bucket < RECV_BUCKETS ? buckets[bucket].load(
+		std::memory_order_relaxed) : 0;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include <WS2tcpip.h>
+#include <winsock2.h>
+#include "Packet.h"
+#include "Timestamp.h"
+
+// Establish the globally accessible macros.
+#define RECV_BUCKETS 24
+#define RECV_TIMEOUT_MS 100
+#define RECV_BUFFER_BYTES (4 * 1024 * 1024)
+#define RECV_JITTER_GAIN 16
+
+//=============================================================================
+//! @class PacketReceiver
+//!
+//! @brief Stands in for the FPGA device, receiving the generated packets and
+//! validating them as they arrive. Loss and reordering are found from gaps in
+//! the packet numbers, jitter from the spacing of arrivals, and continuity
+//! from the step between successive antenna positions.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class PacketReceiver {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn PacketReceiver
+	//!
+	//! @brief Constructs a PacketReceiver instance.
+	//-------------------------------------------------------------------------
+	PacketReceiver(char* addr, int port);
+
+	//-------------------------------------------------------------------------
+	//! @fn ~PacketReceiver
+	//!
+	//! @brief Destroys a PacketReceiver instance.
+	//-------------------------------------------------------------------------
+	~PacketReceiver();
+
+	//-------------------------------------------------------------------------
+	//! @fn init
+	//!
+	//! @brief Binds the socket, joins the multicast group where the address
+	//! is one, and commences the receiving thread.
+	//-------------------------------------------------------------------------
+	int init();
+
+	//-------------------------------------------------------------------------
+	//! @fn uninit
+	//!
+	//! @brief Finishes the receiving thread and closes the socket.
+	//-------------------------------------------------------------------------
+	void uninit();
+
+	//-------------------------------------------------------------------------
+	//! @fn receive
+	//!
+	//! @brief Receives and validates datagrams until the receiver is stopped.
+	//-------------------------------------------------------------------------
+	void receive();
+
+	//-------------------------------------------------------------------------
+	//! @fn validate
+	//!
+	//! @brief Decodes a single packet and accounts for it in the statistics.
+	//-------------------------------------------------------------------------
+	void validate(const uint32_t* arr, int64_t arrival);
+
+	//-------------------------------------------------------------------------
+	//! @fn histogram
+	//!
+	//! @brief Returns the number of inter-arrival times within a bucket.
+	//-------------------------------------------------------------------------
+	uint64_t histogram(uint32_t bucket);
+
+	//! The number of packets received.
+	std::atomic<uint64_t> received;
+
+	//! The number of packets missing from the sequence.
+	std::atomic<uint64_t> lost;
+
+	//! The number of packets arriving after a later packet.
+	std::atomic<uint64_t> reordered;
+
+	//! The number of datagrams not holding a whole number of packets.
+	std::atomic<uint64_t> malformed;
+
+	//! The number of consecutive packets whose antenna step departed from
+	//! the step before it.
+	std::atomic<uint64_t> position_jumps;
+
+	//! The smoothed variation between successive inter-arrival times, in
+	//! nanoseconds.
+	std::atomic<int64_t> jitter_ns;
+
+	//! The greatest delay between a packet's IRIG time and its arrival, in
+	//! milliseconds.
+	std::atomic<int64_t> latency_max_ms;
+private:
+
+	//! A flag to restrict the operation of the receiving thread.
+	std::atomic<bool> active_process;
+
+	//! The socket on which the packets are received.
+	SOCKET recv_socket;
+
+	//! The address on which the packets are received.
+	sockaddr_in recv_address;
+
+	//! A pointer to the receiving thread.
+	std::thread* recvthread;
+
+	//! The clock against which IRIG times are compared.
+	Timestamp timestamp;
+
+	//! The performance counter frequency, in ticks per second.
+	int64_t frequency;
+
+	//! The number of packets falling into each inter-arrival bucket. Bucket
+	//! zero holds gaps under one microsecond, and bucket b holds gaps from
+	//! 2^(b-1) up to 2^b microseconds.
+	std::atomic<uint64_t> buckets[RECV_BUCKETS];
+
+	//! A flag signifying that a packet has been accounted for.
+	bool started;
+
+	//! The greatest packet number received so far.
+	uint32_t last_number;
+
+	//! The antenna position of the packet holding the last number.
+	uint32_t last_position;
+
+	//! The antenna step between the two most recent consecutive packets, or
+	//! ROTATION_FULL if there is none.
+	uint32_t last_step;
+
+	//! The arrival time of the most recent packet, in counter ticks.
+	int64_t last_arrival;
+
+	//! The most recent inter-arrival time, in nanoseconds, or negative if
+	//! there is none.
+	int64_t last_gap;
+};
@@ -0,0 +1,276 @@
+#include "PacketRecorder.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a PacketRecorder instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+PacketRecorder::PacketRecorder() : dropped(0), file(INVALID_HANDLE_VALUE),
+	mapping(NULL), header(NULL), records(NULL), capacity(0), written(0),
+	flushed(0), writable(false), flushing(false), flushthread(NULL) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a PacketRecorder instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+PacketRecorder::~PacketRecorder() {
+
+	// Close the recording, should it still be mapped.
+	if (header != NULL) {
+		close();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Creates a recording of a fixed capacity and maps it for writing. 
+//! The whole capacity is mapped up front, so that appending never remaps.
+//! @param path The location of the recording, which is replaced if it exists.
+//! @param capacity The greatest number of records the recording may hold.
+//! @return A zero value, if successful, or the system error otherwise.
+//-----------------------------------------------------------------------------
+int PacketRecorder::create(const wchar_t* path, uint64_t capacity) {
+
+	// Declare all relevant variables.
+	ULARGE_INTEGER bytes;
+	int err;
+
+	// Create the file, and map it at its full capacity, which extends the
+	// file to the same size.
+	file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+		NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return (int)GetLastError();
+	}
+	bytes.QuadPart = sizeof(RecordHeader) + capacity * sizeof(PacketRecord);
+	mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE, bytes.HighPart,
+		bytes.LowPart, NULL);
+	if (mapping != NULL) {
+		header = (RecordHeader*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0,
+			0);
+	}
+	if (header == NULL) {
+		err = (int)GetLastError();
+		if (mapping != NULL) {
+			CloseHandle(mapping);
+			mapping = NULL;
+		}
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+		return err;
+	}
+
+	// Write the header, with no records yet flushed.
+	memcpy(header->magic, RECORD_MAGIC, sizeof(header->magic));
+	header->version = RECORD_VERSION;
+	header->record_bytes = sizeof(PacketRecord);
+	header->frequency = frequency();
+	header->count = 0;
+	records = (PacketRecord*)(header + 1);
+	this->capacity = capacity;
+	written = 0;
+	flushed = 0;
+	dropped = 0;
+	writable = true;
+
+	// Start the thread which flushes the pages behind the writer.
+	flushing = true;
+	flushthread = new std::thread(&PacketRecorder::flush, this);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Maps an existing recording for reading.
+//! @param path The location of the recording.
+//! @return A zero value, if successful, or the system error otherwise.
+//-----------------------------------------------------------------------------
+int PacketRecorder::load(const wchar_t* path) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER bytes;
+	int err;
+
+	// Open and map the whole file.
+	file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, 
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return (int)GetLastError();
+	}
+	if (!GetFileSizeEx(file, &bytes) || bytes.QuadPart < (LONGLONG)sizeof(
+		RecordHeader)) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+		return ERROR_BAD_FORMAT;
+	}
+	mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != NULL) {
+		header = (RecordHeader*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 
+			0);
+	}
+	if (header == NULL) {
+		err = (int)GetLastError();
+		if (mapping != NULL) {
+			CloseHandle(mapping);
+			mapping = NULL;
+		}
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+		return err;
+	}
+
+	// Check the header against this build, and take the records the file 
+	// actually holds, which may be fewer than the count should the recording
+	// have been cut short.
+	records = (PacketRecord*)(header + 1);
+	capacity = (bytes.QuadPart - sizeof(RecordHeader)) / sizeof(PacketRecord);
+	writable = false;
+	if (memcmp(header->magic, RECORD_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != RECORD_VERSION || header->record_bytes != sizeof(
+		PacketRecord)) {
+		close();
+		return ERROR_BAD_FORMAT;
+	}
+	written = header->count < capacity ? header->count : capacity;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Flushes and unmaps the recording, trimming the file to the records
+//! written.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketRecorder::close() {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER end;
+
+	// Stop the flushing thread, which makes a final pass before finishing.
+	if (flushthread != NULL) {
+		flushing = false;
+		WakeByAddressAll(&flushing);
+		flushthread->join();
+		delete flushthread;
+		flushthread = NULL;
+	}
+
+	// Unmap the view, then cut the unused capacity from the end of the file.
+	UnmapViewOfFile(header);
+	CloseHandle(mapping);
+	if (writable) {
+		end.QuadPart = sizeof(RecordHeader) + written.load() * sizeof(
+			PacketRecord);
+		SetFilePointerEx(file, end, NULL, FILE_BEGIN);
+		SetEndOfFile(file);
+	}
+	CloseHandle(file);
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+	header = NULL;
+	records = NULL;
+	writable = false;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Appends a packet to the recording. Only the transmitting thread may
+//! call this. The record is copied into the mapped pages, and so involves no
+//! call into the system.
+//! @param arr A pointer to the wire words of the packet.
+//! @param ticks The performance counter reading at the send.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketRecorder::record(const uint32_t* arr, int64_t ticks) {
+
+	// Declare all relevant variables.
+	uint64_t idx;
+
+	// Once the capacity is reached, count the packets which are not kept.
+	idx = written.load(std::memory_order_relaxed);
+	if (idx >= capacity) {
+		dropped.store(dropped.load(std::memory_order_relaxed) + 1, 
+			std::memory_order_relaxed);
+		return;
+	}
+
+	// Copy the record, then publish it to the flushing thread.
+	records[idx].ticks = ticks;
+	memcpy(records[idx].words, arr, sizeof(records[idx].words));
+	written.store(idx + 1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns whether a recording is mapped.
+//! @return True if a recording has been created or loaded, false otherwise.
+//-----------------------------------------------------------------------------
+bool PacketRecorder::active() {
+	return header != NULL;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of records held.
+//! @return The number of records written, or held by a loaded recording.
+//-----------------------------------------------------------------------------
+uint64_t PacketRecorder::count() {
+	return written.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns a record of a loaded recording.
+//! @param index The index of the record, which must be less than count.
+//! @return A pointer to the record.
+//-----------------------------------------------------------------------------
+const PacketRecord* PacketRecorder::at(uint64_t index) {
+	return records + index;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the counter frequency at which the ticks were recorded.
+//! @return The frequency of a loaded recording, or of this machine's counter
+//! when none is loaded, in ticks per second.
+//-----------------------------------------------------------------------------
+int64_t PacketRecorder::frequency() {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER freq;
+
+	// A loaded recording carries the frequency of the machine it came from.
+	if (header != NULL && !writable && header->frequency > 0) {
+		return header->frequency;
+	}
+	QueryPerformanceFrequency(&freq);
+	return freq.QuadPart;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Flushes the pages written since the last flush, at intervals, until
+//! the recording is closed. Flushing a view only queues its dirty pages for 
+//! writing, so the file is written in the background while the transmitter
+//! continues to append. The count in the header trails the flushed records,
+//! so that a recording cut short is still read consistently.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketRecorder::flush() {
+
+	// Declare all relevant variables.
+	bool running;
+	bool expected;
+	uint64_t target;
+
+	// Flush whichever records were published since the previous pass, then
+	// wait out the interval unless the recording is closed in the meantime.
+	// The final pass follows the close.
+	do {
+		running = flushing.load();
+		target = written.load(std::memory_order_acquire);
+		if (target > flushed) {
+			FlushViewOfFile(records + flushed, (size_t)(target - flushed) *
+				sizeof(PacketRecord));
+			header->count = target;
+			FlushViewOfFile(header, sizeof(RecordHeader));
+			flushed = target;
+		}
+		if (running) {
+			expected = true;
+			WaitOnAddress(&flushing, &expected, sizeof(expected), 
+				RECORD_FLUSH_MS);
+		}
+	} while (running);
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include "PacketLayout.h"
+
+// Establish the globally accessible macros.
+#define RECORD_MAGIC "eGRIMREC"
+#define RECORD_VERSION 1
+#define RECORD_CAPACITY (1u << 22)
+#define RECORD_FLUSH_MS 250
+
+//=============================================================================
+//! @struct RecordHeader
+//!
+//! @brief The header opening a recording, holding what is needed to replay
+//! the records on another machine.
+//=============================================================================
+struct RecordHeader {
+
+	//! The characters identifying a recording, RECORD_MAGIC.
+	char magic[8];
+
+	//! The version of the record layout.
+	uint32_t version;
+
+	//! The size of each record, in bytes.
+	uint32_t record_bytes;
+
+	//! The frequency of the performance counter at recording, in ticks per
+	//! second.
+	int64_t frequency;
+
+	//! The number of records which have been flushed to the file.
+	uint64_t count;
+};
+
+//=============================================================================
+//! @struct PacketRecord
+//!
+//! @brief A single packet as it left the transmitter.
+//=============================================================================
+struct PacketRecord {
+
+	//! The performance counter reading at the send.
+	int64_t ticks;
+
+	//! The wire words of the packet, exactly as sent.
+	uint32_t words[PACKET_WORDS];
+};
+
+//=============================================================================
+//! @class PacketRecorder
+//!
+//! @brief Captures the transmitted packets into an append-only file mapped 
+//! into memory, so that a recording is written without any call into the 
+//! system on the transmitting thread. A background thread flushes the new 
+//! pages and the record count at intervals, leaving a readable recording 
+//! should the process end abruptly. The same class maps a recording back for 
+//! replay.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class PacketRecorder {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn PacketRecorder
+	//!
+	//! @brief Constructs a PacketRecorder instance.
+	//-------------------------------------------------------------------------
+	PacketRecorder();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~PacketRecorder
+	//!
+	//! @brief Destroys a PacketRecorder instance.
+	//-------------------------------------------------------------------------
+	~PacketRecorder();
+
+	//-------------------------------------------------------------------------
+	//! @fn create
+	//!
+	//! @brief Creates a recording of a fixed capacity and maps it for 
+	//! writing.
+	//-------------------------------------------------------------------------
+	int create(const wchar_t* path, uint64_t capacity = RECORD_CAPACITY);
+
+	//-------------------------------------------------------------------------
+	//! @fn load
+	//!
+	//! @brief Maps an existing recording for reading.
+	//-------------------------------------------------------------------------
+	int load(const wchar_t* path);
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Flushes and unmaps the recording, trimming the file to the
+	//! records written.
+	//-------------------------------------------------------------------------
+	void close();
+
+	//-------------------------------------------------------------------------
+	//! @fn record
+	//!
+	//! @brief Appends a packet to the recording. Only the transmitting thread
+	//! may call this.
+	//-------------------------------------------------------------------------
+	void record(const uint32_t* arr, int64_t ticks);
+
+	//-------------------------------------------------------------------------
+	//! @fn active
+	//!
+	//! @brief Returns whether a recording is mapped.
+	//-------------------------------------------------------------------------
+	bool active();
+
+	//-------------------------------------------------------------------------
+	//! @fn count
+	//!
+	//! @brief Returns the number of records held.
+	//-------------------------------------------------------------------------
+	uint64_t count();
+
+	//-------------------------------------------------------------------------
+	//! @fn at
+	//!
+	//! @brief Returns a record of a loaded recording.
+	//-------------------------------------------------------------------------
+	const PacketRecord* at(uint64_t index);
+
+	//-------------------------------------------------------------------------
+	//! @fn frequency
+	//!
+	//! @brief Returns the counter frequency at which the ticks were recorded.
+	//-------------------------------------------------------------------------
+	int64_t frequency();
+
+	//! The number of packets not recorded once the capacity was reached.
+	std::atomic<uint64_t> dropped;
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn flush
+	//!
+	//! @brief Flushes the pages written since the last flush, at intervals,
+	//! until the recording is closed.
+	//-------------------------------------------------------------------------
+	void flush();
+
+	//! A handle to the file holding the recording.
+	HANDLE file;
+
+	//! A handle to the mapping of the file.
+	HANDLE mapping;
+
+	//! The header at the start of the mapped view.
+	RecordHeader* header;
+
+	//! The records following the header within the mapped view.
+	PacketRecord* records;
+
+	//! The number of records the mapping can hold.
+	uint64_t capacity;
+
+	//! The number of records written, published to the flushing thread.
+	std::atomic<uint64_t> written;
+
+	//! The number of records whose pages have been flushed.
+	uint64_t flushed;
+
+	//! A flag signifying that the recording is mapped for writing.
+	bool writable;
+
+	//! A flag to restrict the operation of the flushing thread.
+	std::atomic<bool> flushing;
+
+	//! A pointer to the flushing thread.
+	std::thread* flushthread;
+};
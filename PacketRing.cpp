@@ -0,0 +1,259 @@
+#include "PacketRing.h"
+
+// Link the library providing the address-based wait functions.
+#pragma comment(lib, "Synchronization.lib")
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a PacketRing instance.
+//! @param queue_len The maximum number of packets held by the ring.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+PacketRing::PacketRing(uint32_t queue_len) : head(0), cached_tail(0),
+	head_pad(), tail(0), cached_head(0), tail_pad(), slots(NULL),
+	stamps(NULL), mask(0), limit(queue_len), closed(false) {
+
+	// Declare all relevant variables.
+	uint32_t count;
+
+	// Round the slot count up to a power of two, so that the free-running
+	// indices may be wrapped with a mask rather than a division.
+	count = 1;
+	while (count < queue_len) {
+		count <<= 1;
+	}
+	mask = count - 1;
+
+	// Allocate every slot up front, so that neither thread touches the heap
+	// once the ring is running.
+	slots = new uint32_t[count][PACKET_WORDS];
+	stamps = new int64_t[count]();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a PacketRing instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+PacketRing::~PacketRing() {
+
+	// Free the memory taken by the slot array.
+	delete[] slots;
+	delete[] stamps;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Waits for a free slot and returns it to the producer.
+//! @return A pointer to the slot words, or NULL if the ring has been closed.
+//-----------------------------------------------------------------------------
+uint32_t* PacketRing::acquire() {
+
+	// Declare all relevant variables.
+	uint32_t idx;
+	uint32_t spin;
+
+	// Only the producer writes the head index, so a relaxed load suffices.
+	idx = head.load(std::memory_order_relaxed);
+
+	// While the ring appears full, refresh the cached tail index, spinning
+	// briefly before blocking until the consumer releases a slot.
+	spin = 0;
+	while (idx - cached_tail >= limit) {
+		cached_tail = tail.load(std::memory_order_acquire);
+		if (idx - cached_tail < limit) {
+			break;
+		}
+		if (closed.load(std::memory_order_relaxed)) {
+			return NULL;
+		}
+		if (spin < RING_SPIN_COUNT) {
+			YieldProcessor();
+			++spin;
+			continue;
+		}
+		WaitOnAddress(&tail, &cached_tail, sizeof(cached_tail),
+			RING_WAIT_TIMEOUT);
+	}
+
+	// Return the slot beneath the head index.
+	return slots[idx & mask];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Waits for a free slot and returns it to the producer, along with the
+//! number of contiguous free slots which follow from it.
+//! @param want The greatest number of slots the producer intends to fill.
+//! @param granted A pointer to a value which shall be populated with the 
+//! number of slots which may be filled, between one and want.
+//! @return A pointer to the words of the first slot, or NULL if the ring has
+//! been closed.
+//-----------------------------------------------------------------------------
+uint32_t* PacketRing::acquire(uint32_t want, uint32_t* granted) {
+
+	// Declare all relevant variables.
+	uint32_t* slot;
+	uint32_t idx;
+	uint32_t count;
+
+	// Wait for the first slot as for a single packet.
+	slot = acquire();
+	if (slot == NULL) {
+		return NULL;
+	}
+
+	// Grant as many of the wanted slots as are free, stopping at the end of
+	// the slot array so that the run remains contiguous.
+	idx = head.load(std::memory_order_relaxed);
+	count = limit - (idx - cached_tail);
+	if (count > mask + 1 - (idx & mask)) {
+		count = mask + 1 - (idx & mask);
+	}
+	*granted = count < want ? count : want;
+	return slot;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Hands the most recently acquired slots to the consumer.
+//! @param count The number of slots to hand over.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketRing::publish(uint32_t count) {
+
+	// Advance the head index, making the slot contents visible to the
+	// consumer, and wake it should it be blocked. The wake remains in user
+	// mode whenever no thread is waiting on the address.
+	head.store(head.load(std::memory_order_relaxed) + count,
+		std::memory_order_release);
+	WakeByAddressSingle(&head);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Hands the most recently acquired slots to the consumer, noting the
+//! instant at which they were enqueued.
+//! @param count The number of slots to hand over.
+//! @param ticks The performance counter reading at which they were enqueued.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketRing::publish(uint32_t count, int64_t ticks) {
+
+	// Declare all relevant variables.
+	uint32_t idx;
+	uint32_t i;
+
+	// Note the instant against each slot before the release store publishes
+	// it, so that the consumer reads the instant along with the words.
+	idx = head.load(std::memory_order_relaxed);
+	for (i = 0; i < count; ++i) {
+		stamps[(idx + i) & mask] = ticks;
+	}
+	publish(count);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Waits for a published slot and returns it to the consumer, which
+//! may amend the words until the slot is released.
+//! @return A pointer to the slot words, or NULL if the ring has been closed.
+//-----------------------------------------------------------------------------
+uint32_t* PacketRing::front() {
+
+	// Declare all relevant variables.
+	uint32_t idx;
+	uint32_t spin;
+
+	// Only the consumer writes the tail index, so a relaxed load suffices.
+	idx = tail.load(std::memory_order_relaxed);
+
+	// While the ring appears empty, refresh the cached head index, spinning
+	// briefly before blocking until the producer publishes a slot.
+	spin = 0;
+	while (idx == cached_head) {
+		cached_head = head.load(std::memory_order_acquire);
+		if (idx != cached_head) {
+			break;
+		}
+		if (closed.load(std::memory_order_relaxed)) {
+			return NULL;
+		}
+		if (spin < RING_SPIN_COUNT) {
+			YieldProcessor();
+			++spin;
+			continue;
+		}
+		WaitOnAddress(&head, &cached_head, sizeof(cached_head),
+			RING_WAIT_TIMEOUT);
+	}
+
+	// Return the slot beneath the tail index.
+	return slots[idx & mask];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of published slots available to the consumer 
+//! without waiting.
+//! @return The number of slots which may be read through at.
+//-----------------------------------------------------------------------------
+uint32_t PacketRing::ready() {
+
+	// Refresh the cached head index, and measure it against the tail.
+	cached_head = head.load(std::memory_order_acquire);
+	return cached_head - tail.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns a published slot at an offset from the front of the ring.
+//! @param offset The offset from the front, which must be less than ready.
+//! @return A pointer to the slot words.
+//-----------------------------------------------------------------------------
+uint32_t* PacketRing::at(uint32_t offset) {
+	return slots[(tail.load(std::memory_order_relaxed) + offset) & mask];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the instant at which a published slot was enqueued.
+//! @param offset The offset from the front, which must be less than ready.
+//! @return The performance counter reading given to publish, or zero if none
+//! was given.
+//-----------------------------------------------------------------------------
+int64_t PacketRing::enqueued(uint32_t offset) {
+	return stamps[(tail.load(std::memory_order_relaxed) + offset) & mask];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns slots at the front of the ring to the producer.
+//! @param count The number of slots to return.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketRing::release(uint32_t count) {
+
+	// Advance the tail index, returning the slots to the producer, and wake 
+	// it should it be blocked.
+	tail.store(tail.load(std::memory_order_relaxed) + count,
+		std::memory_order_release);
+	WakeByAddressSingle(&tail);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Marks the ring as closed and wakes any blocked thread.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void PacketRing::close() {
+
+	// Toggle the closed flag, then wake both sides. A thread which misses the
+	// wake observes the flag once its bounded wait expires.
+	closed = true;
+	WakeByAddressAll(&head);
+	WakeByAddressAll(&tail);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of published slots awaiting the consumer.
+//! @return The current depth of the ring.
+//-----------------------------------------------------------------------------
+uint32_t PacketRing::size() {
+
+	// Declare all relevant variables.
+	uint32_t first;
+
+	// The indices are free-running, so their difference is the depth. The
+	// tail is read first, as it can never overtake the head.
+	first = tail.load(std::memory_order_acquire);
+	return head.load(std::memory_order_acquire) - first;
+}
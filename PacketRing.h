@@ -0,0 +1,156 @@
+#pragma once
+
+#include "stdafx.h"
+#include <atomic>
+#include "Packet.h"
+
+// Establish the globally accessible macros.
+#define CACHE_LINE 64
+#define RING_SPIN_COUNT 256
+#define RING_WAIT_TIMEOUT 10
+
+//=============================================================================
+//! @class PacketRing
+//!
+//! @brief A bounded, lock-free ring of encoded packets shared between exactly
+//! one producer thread and one consumer thread. Each slot holds the wire
+//! words of a single packet, and both sides block on the opposing index when
+//! the ring is full or empty.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class PacketRing {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn PacketRing
+	//!
+	//! @brief Constructs a PacketRing instance.
+	//-------------------------------------------------------------------------
+	PacketRing(uint32_t queue_len);
+
+	//-------------------------------------------------------------------------
+	//! @fn ~PacketRing
+	//!
+	//! @brief Destroys a PacketRing instance.
+	//-------------------------------------------------------------------------
+	~PacketRing();
+
+	//-------------------------------------------------------------------------
+	//! @fn acquire
+	//!
+	//! @brief Waits for a free slot and returns it to the producer.
+	//-------------------------------------------------------------------------
+	uint32_t* acquire();
+
+	//-------------------------------------------------------------------------
+	//! @fn acquire
+	//!
+	//! @brief Waits for a free slot and returns it to the producer, along with
+	//! the number of contiguous free slots which follow from it.
+	//-------------------------------------------------------------------------
+	uint32_t* acquire(uint32_t want, uint32_t* granted);
+
+	//-------------------------------------------------------------------------
+	//! @fn publish
+	//!
+	//! @brief Hands the most recently acquired slots to the consumer.
+	//-------------------------------------------------------------------------
+	void publish(uint32_t count = 1);
+
+	//-------------------------------------------------------------------------
+	//! @fn publish
+	//!
+	//! @brief Hands the most recently acquired slots to the consumer, noting
+	//! the instant at which they were enqueued.
+	//-------------------------------------------------------------------------
+	void publish(uint32_t count, int64_t ticks);
+
+	//-------------------------------------------------------------------------
+	//! @fn front
+	//!
+	//! @brief Waits for a published slot and returns it to the consumer.
+	//-------------------------------------------------------------------------
+	uint32_t* front();
+
+	//-------------------------------------------------------------------------
+	//! @fn ready
+	//!
+	//! @brief Returns the number of published slots available to the consumer
+	//! without waiting.
+	//-------------------------------------------------------------------------
+	uint32_t ready();
+
+	//-------------------------------------------------------------------------
+	//! @fn at
+	//!
+	//! @brief Returns a published slot at an offset from the front of the ring.
+	//-------------------------------------------------------------------------
+	uint32_t* at(uint32_t offset);
+
+	//-------------------------------------------------------------------------
+	//! @fn enqueued
+	//!
+	//! @brief Returns the instant at which a published slot was enqueued.
+	//-------------------------------------------------------------------------
+	int64_t enqueued(uint32_t offset);
+
+	//-------------------------------------------------------------------------
+	//! @fn release
+	//!
+	//! @brief Returns slots at the front of the ring to the producer.
+	//-------------------------------------------------------------------------
+	void release(uint32_t count = 1);
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Marks the ring as closed and wakes any blocked thread.
+	//-------------------------------------------------------------------------
+	void close();
+
+	//-------------------------------------------------------------------------
+	//! @fn size
+	//!
+	//! @brief Returns the number of published slots awaiting the consumer.
+	//-------------------------------------------------------------------------
+	uint32_t size();
+private:
+
+	//! The index of the next slot to be published, written by the producer.
+	std::atomic<uint32_t> head;
+
+	//! The producer's most recently observed copy of the tail index.
+	uint32_t cached_tail;
+
+	//! Padding to keep the producer and consumer indices on separate cache
+	//! lines.
+	char head_pad[CACHE_LINE - sizeof(std::atomic<uint32_t>) -
+		sizeof(uint32_t)];
+
+	//! The index of the next slot to be released, written by the consumer.
+	std::atomic<uint32_t> tail;
+
+	//! The consumer's most recently observed copy of the head index.
+	uint32_t cached_head;
+
+	//! Padding to keep the consumer index away from the read-only fields.
+	char tail_pad[CACHE_LINE - sizeof(std::atomic<uint32_t>) -
+		sizeof(uint32_t)];
+
+	//! The preallocated slots, each holding the wire words of one packet.
+	uint32_t (*slots)[PACKET_WORDS];
+
+	//! The performance counter reading at which each slot was published, or
+	//! zero if the producer did not note one.
+	int64_t* stamps;
+
+	//! A mask mapping the free-running indices onto the slot array.
+	uint32_t mask;
+
+	//! The maximum number of published slots, as requested by the user.
+	uint32_t limit;
+
+	//! A flag to release both threads from their blocking waits.
+	std::atomic<bool> closed;
+};
@@ -0,0 +1,64 @@
+#include "ParameterBlock.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a ParameterBlock instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+ParameterBlock::ParameterBlock() : sequence(0), data() {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Publishes a new set of parameters. Only a single thread may write.
+//! @param params The parameters to publish.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void ParameterBlock::write(const Parameters& params) {
+
+	// Declare all relevant variables.
+	uint32_t seq;
+
+	// Mark the write as under way, ordering the mark before the copy, and 
+	// then publish the copy with the even sequence.
+	seq = sequence.load(std::memory_order_relaxed);
+	sequence.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&data, &params, sizeof(data));
+	sequence.store(seq + 2, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Copies out a consistent set of parameters, retrying whenever a 
+//! write overlaps the copy.
+//! @param params The parameters to populate.
+//! @return The version of the parameters copied.
+//-----------------------------------------------------------------------------
+uint32_t ParameterBlock::read(Parameters* params) {
+
+	// Declare all relevant variables.
+	uint32_t before;
+	uint32_t after;
+
+	// Copy the parameters between two reads of the sequence, ordering the 
+	// copy before the second read, until neither read finds a write.
+	do {
+		before = sequence.load(std::memory_order_acquire);
+		if (before & 1) {
+			YieldProcessor();
+			after = before + 1;
+			continue;
+		}
+		memcpy(params, &data, sizeof(data));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = sequence.load(std::memory_order_relaxed);
+	} while (before != after);
+	return before;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the sequence of the most recently published parameters, 
+//! which a reader compares against the version it last read.
+//! @return The sequence, which is odd should a write be under way.
+//-----------------------------------------------------------------------------
+uint32_t ParameterBlock::version() {
+	return sequence.load(std::memory_order_acquire);
+}
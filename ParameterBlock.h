@@ -0,0 +1,77 @@
+#pragma once
+
+#include "stdafx.h"
+#include <string.h>
+#include <atomic>
+#include "Packet.h"
+
+//=============================================================================
+//! @struct Parameters
+//!
+//! @brief The settings of a running generator which may change while it 
+//! runs. The antenna position, packet number and IRIG time of the sample are
+//! ignored, since they continue from the packets already generated.
+//=============================================================================
+struct Parameters {
+
+	//! The delay period between packet transmissions, in seconds.
+	double packet_rate;
+
+	//! The angle of antenna rotation for a duration of one second.
+	double rotate_rate;
+
+	//! The sample carrying every mode field of the packets.
+	Packet sample;
+};
+
+//=============================================================================
+//! @class ParameterBlock
+//!
+//! @brief Publishes Parameters from one writing thread to any number of 
+//! reading threads under a sequence lock. The writer makes the sequence odd,
+//! copies the parameters, and makes it even again. A reader copies them out
+//! between two reads of the sequence, and retries should the sequence have
+//! been odd or have changed, so that neither side ever blocks the other, and
+//! a reader polling for a change pays a single load.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class ParameterBlock {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn ParameterBlock
+	//!
+	//! @brief Constructs a ParameterBlock instance.
+	//-------------------------------------------------------------------------
+	ParameterBlock();
+
+	//-------------------------------------------------------------------------
+	//! @fn write
+	//!
+	//! @brief Publishes a new set of parameters.
+	//-------------------------------------------------------------------------
+	void write(const Parameters& params);
+
+	//-------------------------------------------------------------------------
+	//! @fn read
+	//!
+	//! @brief Copies out a consistent set of parameters.
+	//-------------------------------------------------------------------------
+	uint32_t read(Parameters* params);
+
+	//-------------------------------------------------------------------------
+	//! @fn version
+	//!
+	//! @brief Returns the sequence of the most recently published parameters.
+	//-------------------------------------------------------------------------
+	uint32_t version();
+private:
+
+	//! The sequence, which is odd while a write is under way, and advances by
+	//! two with each write.
+	std::atomic<uint32_t> sequence;
+
+	//! The most recently published parameters.
+	Parameters data;
+};
@@ -0,0 +1,290 @@
+#include "RateCalibrator.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a RateCalibrator instance.
+//! @param addr The address to which the packets are sent.
+//! @param port The communication port to which the packets are sent.
+//! @param feedback_port The port on which the receiver listens, being the
+//! communication port itself for a looped-back link.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+RateCalibrator::RateCalibrator(const char* addr, int port, int feedback_port) :
+	address(), port(port), feedback_port(feedback_port),
+	probe_ms(CALIB_PROBE_MS), max_jitter_ns(CALIB_JITTER_NS), batch_size(1),
+	batch_latency(0), curve(), count(0), best_pps(0), snap(NULL),
+	runner(NULL), done(false), cancelled(false) {
+	strcpy_s(address, sizeof(address), addr);
+	snap = new HistogramSnapshot();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a RateCalibrator instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+RateCalibrator::~RateCalibrator() {
+	stop();
+	delete snap;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Sets the duration of each probe and the jitter it may show. This
+//! must precede start or run.
+//! @param duration_ms The duration of each probe, in milliseconds.
+//! @param max_jitter_ns The greatest smoothed inter-arrival jitter at the
+//! receiver with which a probe passes, in nanoseconds.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RateCalibrator::setProbe(uint32_t duration_ms, int64_t max_jitter_ns) {
+	probe_ms = duration_ms;
+	this->max_jitter_ns = max_jitter_ns;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Sets the batching of the probing generators, as by the setBatch of
+//! SampleGenerator. This must precede start or run.
+//! @param size The greatest number of packets sent in a single batch.
+//! @param max_latency The greatest delay, in seconds, which batching may add
+//! to a packet.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RateCalibrator::setBatch(uint32_t size, double max_latency) {
+	batch_size = size;
+	batch_latency = max_latency;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Commences the calibration on its own thread, which a window may
+//! poll through finished.
+//! @param queue_len The number of packets the ring of each probe may hold.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RateCalibrator::start(uint32_t queue_len) {
+	if (runner != NULL) {
+		return;
+	}
+	done = false;
+	cancelled = false;
+	runner = new std::thread(&RateCalibrator::run, this, queue_len);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Cancels a running calibration, which ends its probe within
+//! CALIB_POLL_MS, and joins its thread. The probes already complete remain.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RateCalibrator::stop() {
+	cancelled = true;
+	if (runner != NULL) {
+		runner->join();
+		delete runner;
+		runner = NULL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns whether the calibration thread has completed, whether by
+//! finishing the search or by being cancelled.
+//! @return A true value, if the calibration has completed, false otherwise.
+//-----------------------------------------------------------------------------
+bool RateCalibrator::finished() {
+	return done.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Runs the calibration on the calling thread. The unpaced probe finds
+//! the ceiling of the transmitter, and the sweep of even fractions of it 
+//! draws the curve. Should the link keep up with the ceiling, that is the 
+//! answer. Otherwise the sweep brackets the highest passing rate beneath the
+//! lowest failing one, and the search halves the bracket until it is within
+//! CALIB_TOLERANCE of its top or CALIB_SEARCH probes have run.
+//! @param queue_len The number of packets the ring of each probe may hold.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RateCalibrator::run(uint32_t queue_len) {
+
+	// Declare all relevant variables.
+	double ceiling;
+	double rate;
+	double lo;
+	double hi;
+	bool unpaced;
+	uint32_t i;
+
+	count = 0;
+	best_pps = 0;
+
+	// Find the ceiling of the transmitter, then sweep even fractions of it,
+	// keeping every point for the curve, and bracket the highest rate 
+	// passing beneath the lowest failing.
+	unpaced = probe(queue_len, 0);
+	ceiling = curve[0].achieved_pps;
+	hi = ceiling;
+	for (i = 1; i <= CALIB_SWEEP && !cancelled && ceiling > 0; ++i) {
+		rate = ceiling * i / CALIB_SWEEP;
+		if (!probe(queue_len, 1.0 / rate) && rate < hi) {
+			hi = rate;
+		}
+	}
+	if (unpaced) {
+		best_pps = ceiling;
+		done.store(true, std::memory_order_release);
+		return;
+	}
+	lo = 0;
+	for (i = 1; i < count; ++i) {
+		if (curve[i].passed && curve[i].offered_pps < hi &&
+			curve[i].offered_pps > lo) {
+			lo = curve[i].offered_pps;
+		}
+	}
+
+	// Halve the bracket until it is narrow enough.
+	for (i = 0; i < CALIB_SEARCH && !cancelled && hi - lo > CALIB_TOLERANCE *
+		hi; ++i) {
+		rate = (lo + hi) / 2;
+		if (probe(queue_len, 1.0 / rate)) {
+			lo = rate;
+		}
+		else {
+			hi = rate;
+		}
+	}
+	best_pps = lo;
+	done.store(true, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Runs a fresh generator at one period for the probe duration, with
+//! a fresh receiver on the feedback port, and records the outcome as the
+//! next point of the curve. A packet counts as lost should it never arrive,
+//! including the last of the probe, which the receiver is given
+//! CALIB_SETTLE_MS to collect.
+//! @param queue_len The number of packets the ring may hold.
+//! @param period The delay period between packet transmissions, in seconds,
+//! or zero to run unpaced.
+//! @return A true value, if the probe passed, false otherwise.
+//-----------------------------------------------------------------------------
+bool RateCalibrator::probe(uint32_t queue_len, double period) {
+
+	// Declare all relevant variables.
+	CalibrationPoint* pt;
+	SampleGenerator* generator;
+	PacketReceiver* receiver;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double> elapsed;
+	uint32_t waited;
+	uint64_t lost;
+	int err;
+
+	pt = &curve[count.load(std::memory_order_relaxed)];
+	memset(pt, 0, sizeof(*pt));
+	pt->period = period;
+	pt->offered_pps = period > 0 ? 1.0 / period : 0;
+
+	// Start the receiver before the generator, so that the first packet
+	// establishes the sequence. A probe whose receiver cannot listen fails.
+	receiver = new PacketReceiver(address, feedback_port);
+	err = receiver->init();
+	if (err != 0) {
+		delete receiver;
+		count.fetch_add(1, std::memory_order_release);
+		return false;
+	}
+
+	// Run the generator for the probe duration, or until cancelled.
+	generator = new SampleGenerator(address, port);
+	generator->setBatch(batch_size, batch_latency);
+	start = std::chrono::steady_clock::now();
+	generator->init(queue_len, period, 0, 6);
+	for (waited = 0; waited < probe_ms && !cancelled; waited += CALIB_POLL_MS) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(CALIB_POLL_MS));
+	}
+	generator->uninit();
+	elapsed = std::chrono::steady_clock::now() - start;
+
+	// Allow the final packets to arrive before stopping the receiver.
+	std::this_thread::sleep_for(std::chrono::milliseconds(CALIB_SETTLE_MS));
+	receiver->uninit();
+
+	// Record the outcome as seen from both ends.
+	pt->sent = generator->sent();
+	pt->received = receiver->received.load();
+	pt->achieved_pps = pt->sent / elapsed.count();
+	lost = receiver->lost.load();
+	pt->lost = pt->sent > pt->received ? pt->sent - pt->received : 0;
+	pt->lost = lost > pt->lost ? lost : pt->lost;
+	pt->jitter_ns = receiver->jitter_ns.load();
+	pt->latency_max_ms = receiver->latency_max_ms.load();
+	generator->metric(METRIC_LATENESS).snapshot(snap);
+	pt->lateness_p99_ns = snap->percentile(0.99);
+	generator->metric(METRIC_RESIDENCY).snapshot(snap);
+	pt->residency_p99_ns = snap->percentile(0.99);
+	pt->passed = !cancelled && pt->sent > 0 && pt->lost == 0 &&
+		pt->jitter_ns <= max_jitter_ns;
+	delete generator;
+	delete receiver;
+	count.fetch_add(1, std::memory_order_release);
+	return pt->passed;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the highest rate which passed.
+//! @return The rate, in packets per second, valid once the calibration has
+//! finished, and zero should no probe have passed.
+//-----------------------------------------------------------------------------
+double RateCalibrator::best() {
+	return best_pps;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of probes run, each of which may be read while
+//! the calibration continues.
+//! @return The probe count.
+//-----------------------------------------------------------------------------
+uint32_t RateCalibrator::points() {
+	return count.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the outcome of one probe.
+//! @param which The index of the probe, below points.
+//! @return A reference to the outcome.
+//-----------------------------------------------------------------------------
+const CalibrationPoint& RateCalibrator::point(uint32_t which) {
+	return curve[which];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Writes the best rate and every probe, in the order run, as a JSON
+//! object, from which the throughput and latency curve may be plotted.
+//! @param out The file to which the object is written.
+//! @param name The name given to the object.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RateCalibrator::write(FILE* out, const char* name) {
+
+	// Declare all relevant variables.
+	const CalibrationPoint* pt;
+	uint32_t points;
+	uint32_t i;
+
+	points = this->points();
+	fprintf(out, "{\"name\": \"%s\", \"best_pps\": %.0f, \"best_period_us\": "
+		"%.3f, \"max_jitter_ns\": %lld, \"probe_ms\": %u, \"points\": [",
+		name, best_pps, best_pps > 0 ? 1e6 / best_pps : 0.0,
+		(long long)max_jitter_ns, probe_ms);
+	for (i = 0; i < points; ++i) {
+		pt = &curve[i];
+		fprintf(out, "{\"period_us\": %.3f, \"offered_pps\": %.0f, "
+			"\"achieved_pps\": %.0f, \"sent\": %llu, \"received\": %llu, "
+			"\"lost\": %llu, \"jitter_ns\": %lld, \"latency_max_ms\": %lld, "
+			"\"lateness_p99_ns\": %llu, \"residency_p99_ns\": %llu, "
+			"\"passed\": %s}%s", pt->period * 1e6, pt->offered_pps,
+			pt->achieved_pps, (unsigned long long)pt->sent, (unsigned long
+			long)pt->received, (unsigned long long)pt->lost, (long long)
+			pt->jitter_ns, (long long)pt->latency_max_ms, (unsigned long long)
+			pt->lateness_p99_ns, (unsigned long long)pt->residency_p99_ns,
+			pt->passed ? "true" : "false", i + 1 < points ? ", " : "");
+	}
+	fprintf(out, "]}");
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "stdafx.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include "SampleGenerator.h"
+#include "PacketReceiver.h"
+#include "LatencyHistogram.h"
+
+// Establish the globally accessible macros.
+#define CALIB_SWEEP 4
+#define CALIB_SEARCH 8
+#define CALIB_POINTS (1 + CALIB_SWEEP + CALIB_SEARCH)
+#define CALIB_TOLERANCE 0.01
+#define CALIB_PROBE_MS 1000
+#define CALIB_JITTER_NS 50000
+#define CALIB_SETTLE_MS 50
+#define CALIB_POLL_MS 10
+
+//=============================================================================
+//! @struct CalibrationPoint
+//!
+//! @brief The outcome of running the generator at one rate for one probe,
+//! as seen by both the generator and the receiver.
+//=============================================================================
+struct CalibrationPoint {
+
+	//! The delay period between packet transmissions, in seconds, or zero
+	//! for an unpaced probe.
+	double period;
+
+	//! The rate offered by the period, in packets per second, or zero for an
+	//! unpaced probe.
+	double offered_pps;
+
+	//! The rate achieved by the transmitter, in packets per second.
+	double achieved_pps;
+
+	//! The number of packets released by the transmitter.
+	uint64_t sent;
+
+	//! The number of packets received.
+	uint64_t received;
+
+	//! The number of packets sent but never received.
+	uint64_t lost;
+
+	//! The smoothed inter-arrival jitter at the receiver, in nanoseconds.
+	int64_t jitter_ns;
+
+	//! The greatest latency seen by the receiver, in milliseconds.
+	int64_t latency_max_ms;
+
+	//! The 99th percentile of the lateness of each release, in nanoseconds.
+	uint64_t lateness_p99_ns;
+
+	//! The 99th percentile of the time each packet waited in the ring, in
+	//! nanoseconds.
+	uint64_t residency_p99_ns;
+
+	//! A flag signifying that no packet was lost and the jitter was within
+	//! its bound.
+	bool passed;
+};
+
+//=============================================================================
+//! @class RateCalibrator
+//!
+//! @brief Finds the highest packet rate which a link carries without loss
+//! and within a jitter bound. The generator is first run unpaced, to find
+//! the ceiling of the transmitter, then at even fractions of the ceiling,
+//! and finally at rates halving the interval between the highest which
+//! passed and the lowest which failed. Each probe runs a fresh generator and
+//! receiver, the receiver listening on the feedback port, which is the
+//! generator's own port whenever the link is looped back. Every probe is
+//! kept as a point of the throughput and latency curve.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class RateCalibrator {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn RateCalibrator
+	//!
+	//! @brief Constructs a RateCalibrator instance.
+	//-------------------------------------------------------------------------
+	RateCalibrator(const char* addr, int port, int feedback_port);
+
+	//-------------------------------------------------------------------------
+	//! @fn ~RateCalibrator
+	//!
+	//! @brief Destroys a RateCalibrator instance.
+	//-------------------------------------------------------------------------
+	~RateCalibrator();
+
+	//-------------------------------------------------------------------------
+	//! @fn setProbe
+	//!
+	//! @brief Sets the duration of each probe and the jitter it may show.
+	//-------------------------------------------------------------------------
+	void setProbe(uint32_t duration_ms, int64_t max_jitter_ns);
+
+	//-------------------------------------------------------------------------
+	//! @fn setBatch
+	//!
+	//! @brief Sets the batching of the probing generators.
+	//-------------------------------------------------------------------------
+	void setBatch(uint32_t size, double max_latency);
+
+	//-------------------------------------------------------------------------
+	//! @fn start
+	//!
+	//! @brief Commences the calibration on its own thread.
+	//-------------------------------------------------------------------------
+	void start(uint32_t queue_len);
+
+	//-------------------------------------------------------------------------
+	//! @fn stop
+	//!
+	//! @brief Cancels a running calibration and joins its thread.
+	//-------------------------------------------------------------------------
+	void stop();
+
+	//-------------------------------------------------------------------------
+	//! @fn finished
+	//!
+	//! @brief Returns whether the calibration thread has completed.
+	//-------------------------------------------------------------------------
+	bool finished();
+
+	//-------------------------------------------------------------------------
+	//! @fn run
+	//!
+	//! @brief Runs the calibration on the calling thread.
+	//-------------------------------------------------------------------------
+	void run(uint32_t queue_len);
+
+	//-------------------------------------------------------------------------
+	//! @fn best
+	//!
+	//! @brief Returns the highest rate which passed.
+	//-------------------------------------------------------------------------
+	double best();
+
+	//-------------------------------------------------------------------------
+	//! @fn points
+	//!
+	//! @brief Returns the number of probes run.
+	//-------------------------------------------------------------------------
+	uint32_t points();
+
+	//-------------------------------------------------------------------------
+	//! @fn point
+	//!
+	//! @brief Returns the outcome of one probe.
+	//-------------------------------------------------------------------------
+	const CalibrationPoint& point(uint32_t which);
+
+	//-------------------------------------------------------------------------
+	//! @fn write
+	//!
+	//! @brief Writes the best rate and the curve as a JSON object.
+	//-------------------------------------------------------------------------
+	void write(FILE* out, const char* name);
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn probe
+	//!
+	//! @brief Runs the generator at one period, recording the outcome.
+	//-------------------------------------------------------------------------
+	bool probe(uint32_t queue_len, double period);
+
+	//! The address to which the packets are sent.
+	char address[32];
+
+	//! The communication port to which the packets are sent.
+	int port;
+
+	//! The port on which the receiver listens.
+	int feedback_port;
+
+	//! The duration of each probe, in milliseconds.
+	uint32_t probe_ms;
+
+	//! The greatest receiver jitter with which a probe passes.
+	int64_t max_jitter_ns;
+
+	//! The greatest number of packets sent in a single batch.
+	uint32_t batch_size;
+
+	//! The greatest delay, in seconds, which batching may add to a packet.
+	double batch_latency;
+
+	//! The outcome of each probe, in the order run.
+	CalibrationPoint curve[CALIB_POINTS];
+
+	//! The number of probes run.
+	std::atomic<uint32_t> count;
+
+	//! The highest rate which passed, in packets per second.
+	double best_pps;
+
+	//! The snapshot through which the generator metrics are read.
+	HistogramSnapshot* snap;
+
+	//! A pointer to the calibration thread.
+	std::thread* runner;
+
+	//! A flag signifying that the calibration thread has completed.
+	std::atomic<bool> done;
+
+	//! A flag signifying that the calibration should stop at once.
+	std::atomic<bool> cancelled;
+};
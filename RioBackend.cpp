@@ -0,0 +1,308 @@
+#include "RioBackend.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a RioBackend instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+RioBackend::RioBackend() : rio(), sock(INVALID_SOCKET), pool(NULL), 
+	pool_id(RIO_INVALID_BUFFERID), completions(RIO_INVALID_CQ), 
+	requests(RIO_INVALID_RQ), address_bufs(), destinations(NULL), 
+	destination_count(0), skew(NULL), ns_per_tick(0.0), results(NULL), 
+	queued(0), outstanding(0), aggregate(1) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a RioBackend instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+RioBackend::~RioBackend() {
+	close();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Opens a socket for Registered I/O, which must be created with its
+//! own flag, and registers the pool of send buffers and the addresses with 
+//! it. The queues are polled, so neither raises a notification.
+//! @param sock The socket of the generator, whose multicast scope is copied.
+//! @param destinations The destinations to which the packets are sent.
+//! @param destination_count The number of destinations, from 1 to DEST_MAX.
+//! @param batch_size The greatest number of packets sent in a single batch,
+//! which, sent to every destination, must not exceed RIO_DEPTH.
+//! @param aggregate The greatest number of packets in each datagram, from 1
+//! to FRAME_PACKETS.
+//! @param skew The histogram of the send skew between destinations, or NULL.
+//! @return A zero value, if successful, or the socket error otherwise, in
+//! which case the backend is left closed.
+//-----------------------------------------------------------------------------
+int RioBackend::open(SOCKET sock, Destination* destinations, uint32_t 
+	destination_count, uint32_t batch_size, uint32_t aggregate, 
+	LatencyHistogram* skew) {
+
+	// Declare all relevant variables.
+	GUID guid = WSAID_MULTIPLE_RIO;
+	LARGE_INTEGER freq;
+	unsigned char ttl;
+	int ttl_len;
+	DWORD bytes;
+	uint32_t d;
+	int err;
+
+	if (destination_count == 0 || destination_count > DEST_MAX || 
+		batch_size * destination_count > RIO_DEPTH) {
+		return WSAEINVAL;
+	}
+	this->destinations = destinations;
+	this->destination_count = destination_count;
+	this->skew = skew;
+	this->aggregate = aggregate < 1 ? 1 : aggregate > FRAME_PACKETS ? 
+		FRAME_PACKETS : aggregate;
+	QueryPerformanceFrequency(&freq);
+	ns_per_tick = 1e9 / (double)freq.QuadPart;
+
+	// Open the registered socket with the multicast scope of the generator's
+	// socket, and retrieve the extension functions through it.
+	this->sock = WSASocket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, 
+		WSA_FLAG_REGISTERED_IO);
+	if (this->sock == INVALID_SOCKET) {
+		return WSAGetLastError();
+	}
+	ttl = 1;
+	ttl_len = sizeof(ttl);
+	getsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, (char*)&ttl, &ttl_len);
+	rio.cbSize = sizeof(rio);
+	if (setsockopt(this->sock, IPPROTO_IP, IP_MULTICAST_TTL, (char*)&ttl, 
+		sizeof(ttl)) == SOCKET_ERROR || WSAIoctl(this->sock, 
+		SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid), 
+		&rio, sizeof(rio), &bytes, NULL, NULL) == SOCKET_ERROR) {
+		err = WSAGetLastError();
+		close();
+		return err;
+	}
+
+	// Register one buffer per outstanding packet, with the address of each 
+	// destination after them.
+	pool = new char[RIO_DEPTH * PACKET_BYTES + DEST_MAX * 
+		sizeof(SOCKADDR_INET)]();
+	for (d = 0; d < destination_count; ++d) {
+		memcpy(pool + RIO_DEPTH * PACKET_BYTES + d * sizeof(SOCKADDR_INET), 
+			&destinations[d].address, sizeof(destinations[d].address));
+	}
+	pool_id = rio.RIORegisterBuffer(pool, RIO_DEPTH * PACKET_BYTES + 
+		DEST_MAX * sizeof(SOCKADDR_INET));
+	if (pool_id == RIO_INVALID_BUFFERID) {
+		err = WSAGetLastError();
+		close();
+		return err;
+	}
+	for (d = 0; d < destination_count; ++d) {
+		address_bufs[d].BufferId = pool_id;
+		address_bufs[d].Offset = RIO_DEPTH * PACKET_BYTES + d * 
+			sizeof(SOCKADDR_INET);
+		address_bufs[d].Length = sizeof(SOCKADDR_INET);
+	}
+
+	// Create the polled completion queue, and the request queue sending 
+	// through it.
+	results = new RIORESULT[RIO_REAP]();
+	completions = rio.RIOCreateCompletionQueue(RIO_DEPTH, NULL);
+	if (completions == RIO_INVALID_CQ) {
+		err = WSAGetLastError();
+		close();
+		return err;
+	}
+	requests = rio.RIOCreateRequestQueue(this->sock, 0, 1, RIO_DEPTH, 1, 
+		completions, completions, NULL);
+	if (requests == RIO_INVALID_RQ) {
+		err = WSAGetLastError();
+		close();
+		return err;
+	}
+	queued = 0;
+	outstanding = 0;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Copies packets from the front of the ring into the pool, queues a
+//! deferred send of each frame to every destination, and commits the batch 
+//! with the final send, so that all destinations are served by a single 
+//! call. Each frame is copied once, its buffers shared by the sends to every
+//! destination, and ends early where the pool wraps. Should the pool be full,
+//! the completions are polled until enough buffers return, for no more than
+//! RIO_STALL_MS, after which, or once the completion queue is corrupt, the
+//! batch is counted as failed to every destination.
+//! @param ring The ring holding the packets.
+//! @param count The number of packets to send.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RioBackend::send(PacketRing* ring, uint32_t count) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER first;
+	LARGE_INTEGER last;
+	RIO_BUF buf;
+	uint32_t deferred;
+	uint32_t slot;
+	uint32_t n;
+	uint32_t i;
+	uint32_t j;
+	uint32_t d;
+	bool ready;
+
+	// Return the buffers of finished sends, waiting for enough of them. A 
+	// single request queue completes its sends in order, so the buffers are
+	// reused in the order they were queued.
+	QueryPerformanceCounter(&first);
+	ready = reap();
+	while (ready && outstanding + count * destination_count > RIO_DEPTH) {
+		QueryPerformanceCounter(&last);
+		if ((last.QuadPart - first.QuadPart) * ns_per_tick >= RIO_STALL_MS * 
+			1e6) {
+			ready = false;
+			break;
+		}
+		YieldProcessor();
+		ready = reap();
+	}
+	if (!ready) {
+		for (d = 0; d < destination_count; ++d) {
+			destinations[d].errors.fetch_add(count, 
+				std::memory_order_relaxed);
+		}
+		return;
+	}
+
+	// Queue each frame from its run of buffers to each destination, 
+	// deferring every send but the last, which commits the whole batch. The
+	// context of each send identifies its destination and its packet count.
+	QueryPerformanceCounter(&first);
+	buf.BufferId = pool_id;
+	deferred = 0;
+	for (i = 0; i < count; i += n) {
+		slot = (uint32_t)(queued % RIO_DEPTH);
+		n = count - i < aggregate ? count - i : aggregate;
+		n = n < RIO_DEPTH - slot ? n : RIO_DEPTH - slot;
+		for (j = 0; j < n; ++j) {
+			memcpy(pool + (slot + j) * PACKET_BYTES, ring->at(i + j), 
+				PACKET_BYTES);
+		}
+		buf.Offset = slot * PACKET_BYTES;
+		buf.Length = n * PACKET_BYTES;
+		queued += n;
+		for (d = 0; d < destination_count; ++d) {
+			if (!rio.RIOSendEx(requests, &buf, 1, NULL, &address_bufs[d], 
+				NULL, NULL, i + n < count || d + 1 < destination_count ? 
+				RIO_MSG_DEFER : 0, (PVOID)(uintptr_t)(d | n << 
+				RIO_CONTEXT_SHIFT))) {
+				destinations[d].errors.fetch_add(n, 
+					std::memory_order_relaxed);
+				continue;
+			}
+			outstanding += n;
+			deferred = i + n < count || d + 1 < destination_count ? 
+				deferred + n : 0;
+		}
+	}
+
+	// Should the committing send have failed, commit the deferred sends on
+	// their own, as they are already counted outstanding. Should that fail 
+	// too, they leave with the next commit, or the next batch stalls.
+	if (deferred > 0) {
+		rio.RIOSendEx(requests, NULL, 0, NULL, NULL, NULL, NULL, 
+			RIO_MSG_COMMIT_ONLY, NULL);
+	}
+	if (destination_count > 1 && skew != NULL) {
+		QueryPerformanceCounter(&last);
+		skew->record((uint64_t)((last.QuadPart - first.QuadPart) * 
+			ns_per_tick));
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Dequeues the completed sends, returning their buffers to the pool,
+//! and counts the packets of each as sent or failed against the destination 
+//! named by its context.
+//! @return True, if successful, or false if the completion queue is corrupt,
+//! in which case no outstanding send will complete.
+//-----------------------------------------------------------------------------
+bool RioBackend::reap() {
+
+	// Declare all relevant variables.
+	ULONG done;
+	ULONG i;
+	uint32_t d;
+	uint32_t n;
+
+	done = rio.RIODequeueCompletion(completions, results, RIO_REAP);
+	if (done == RIO_CORRUPT_CQ) {
+		return false;
+	}
+	for (i = 0; i < done; ++i) {
+		d = (uint32_t)results[i].RequestContext & ((1 << RIO_CONTEXT_SHIFT) -
+			1);
+		n = (uint32_t)(results[i].RequestContext >> RIO_CONTEXT_SHIFT);
+		outstanding -= n < outstanding ? n : outstanding;
+		if (d >= destination_count) {
+			continue;
+		}
+		if (results[i].Status == 0) {
+			destinations[d].sent.fetch_add(n, std::memory_order_relaxed);
+		}
+		else {
+			destinations[d].errors.fetch_add(n, std::memory_order_relaxed);
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Waits, for no more than RIO_DRAIN_MS, for the outstanding sends to
+//! complete, then frees the socket, along with its request queue, before the
+//! completion queue and the registration it used.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RioBackend::close() {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	// Allow the queued packets to leave.
+	if (completions != RIO_INVALID_CQ) {
+		for (i = 0; i < RIO_DRAIN_MS && outstanding > 0; ++i) {
+			if (!reap()) {
+				break;
+			}
+			if (outstanding > 0) {
+				Sleep(1);
+			}
+		}
+	}
+
+	// Free the socket and queues, and then the buffers they sent from.
+	if (sock != INVALID_SOCKET) {
+		closesocket(sock);
+		sock = INVALID_SOCKET;
+	}
+	requests = RIO_INVALID_RQ;
+	if (completions != RIO_INVALID_CQ) {
+		rio.RIOCloseCompletionQueue(completions);
+		completions = RIO_INVALID_CQ;
+	}
+	if (pool_id != RIO_INVALID_BUFFERID) {
+		rio.RIODeregisterBuffer(pool_id);
+		pool_id = RIO_INVALID_BUFFERID;
+	}
+	delete[] pool;
+	pool = NULL;
+	delete[] results;
+	results = NULL;
+	outstanding = 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the kind of the backend.
+//! @return BACKEND_RIO.
+//-----------------------------------------------------------------------------
+uint32_t RioBackend::kind() {
+	return BACKEND_RIO;
+}
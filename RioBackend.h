@@ -0,0 +1,142 @@
+#pragma once
+
+#include "stdafx.h"
+#include <mswsock.h>
+#include "TransmitBackend.h"
+
+// Establish the globally accessible macros.
+#define RIO_DEPTH 1024
+#define RIO_REAP 64
+#define RIO_DRAIN_MS 100
+#define RIO_STALL_MS 100
+#define RIO_CONTEXT_SHIFT 16
+
+//=============================================================================
+//! @class RioBackend
+//!
+//! @brief Sends the packets through Registered I/O. The packets are copied 
+//! into a pool of send buffers registered with the socket once, so that no
+//! send locks or maps its memory, and each batch is queued as deferred sends
+//! and committed together, costing a single transition into the kernel. The
+//! completions are polled from a queue in user memory as the sends finish,
+//! without a wait, and each returns its buffer to the pool. Packed frames 
+//! are sent from runs of consecutive buffers, so that packing costs nothing
+//! beyond the copy into the pool.
+//!
+//! The packets are copied, rather than sent from the registered slots of the
+//! ring, because a send completes only after the transmitter has released 
+//! its slots to the generator. Sending in place would hold every slot until
+//! its completion is reaped, tying the depth of the ring to that of the
+//! request queue and stalling the generator behind the network, where the
+//! copy of a packet costs far less than its send.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class RioBackend : public TransmitBackend {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn RioBackend
+	//!
+	//! @brief Constructs a RioBackend instance.
+	//-------------------------------------------------------------------------
+	RioBackend();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~RioBackend
+	//!
+	//! @brief Destroys a RioBackend instance.
+	//-------------------------------------------------------------------------
+	~RioBackend();
+
+	//-------------------------------------------------------------------------
+	//! @fn open
+	//!
+	//! @brief Opens a registered socket, and registers the buffer pool and 
+	//! the addresses with it.
+	//-------------------------------------------------------------------------
+	int open(SOCKET sock, Destination* destinations, uint32_t 
+		destination_count, uint32_t batch_size, uint32_t aggregate, 
+		LatencyHistogram* skew);
+
+	//-------------------------------------------------------------------------
+	//! @fn send
+	//!
+	//! @brief Queues packets from the front of the ring, and commits them.
+	//-------------------------------------------------------------------------
+	void send(PacketRing* ring, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Waits for the outstanding sends, and frees the registered
+	//! socket, queues and buffers.
+	//-------------------------------------------------------------------------
+	void close();
+
+	//-------------------------------------------------------------------------
+	//! @fn kind
+	//!
+	//! @brief Returns the kind of the backend.
+	//-------------------------------------------------------------------------
+	uint32_t kind();
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn reap
+	//!
+	//! @brief Dequeues the completed sends, returning their buffers and 
+	//! counting them against their destinations.
+	//-------------------------------------------------------------------------
+	bool reap();
+
+	//! The functions of the Registered I/O extension.
+	RIO_EXTENSION_FUNCTION_TABLE rio;
+
+	//! The socket opened for Registered I/O.
+	SOCKET sock;
+
+	//! The send buffers, one packet each, followed by the address of each 
+	//! destination.
+	char* pool;
+
+	//! The registration of the pool.
+	RIO_BUFFERID pool_id;
+
+	//! The queue of completed sends.
+	RIO_CQ completions;
+
+	//! The queue of requested sends.
+	RIO_RQ requests;
+
+	//! The registered slice of the pool holding the address of each 
+	//! destination.
+	RIO_BUF address_bufs[DEST_MAX];
+
+	//! The destinations to which the packets are sent, owned by the caller.
+	Destination* destinations;
+
+	//! The number of destinations.
+	uint32_t destination_count;
+
+	//! The histogram of the time between queueing the first send of a batch
+	//! and committing the last, in nanoseconds, or NULL if it is not measured.
+	LatencyHistogram* skew;
+
+	//! The number of nanoseconds per performance counter tick.
+	double ns_per_tick;
+
+	//! The results dequeued from the completion queue.
+	RIORESULT* results;
+
+	//! The number of packets copied into the pool since the backend was 
+	//! opened.
+	uint64_t queued;
+
+	//! The number of packets queued to a destination but not yet sent, 
+	//! counted once for each destination.
+	uint32_t outstanding;
+
+	//! The greatest number of packets packed into each datagram.
+	uint32_t aggregate;
+};
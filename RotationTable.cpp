@@ -0,0 +1,135 @@
+#include "RotationTable.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a RotationTable instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+RotationTable::RotationTable() : length(0), footprint(0), build_us(0),
+	entries(NULL), cursor(0), indexed(false), phase(0), step(0) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a RotationTable instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+RotationTable::~RotationTable() {
+	clear();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Encodes the packets following the given sample.
+//! @param smpl The sample preceding the first packet, with its rotation rate
+//! already set.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RotationTable::build(Packet smpl) {
+
+	// Declare all relevant variables.
+	std::chrono::steady_clock::time_point start;
+	std::chrono::duration<double, std::micro> elapsed;
+	uint32_t bits;
+	uint32_t i;
+
+	// Discard any previous table.
+	clear();
+	start = std::chrono::steady_clock::now();
+
+	// Adding the increment modulo 2^64 repeats after 2^(64 - z) steps, where z
+	// counts its trailing zero bits.
+	step = smpl.getAntStep();
+	phase = smpl.getAntPhase();
+	bits = 0;
+	if (step != 0) {
+		bits = 64;
+		while (((step >> (64 - bits)) & 1) == 0) {
+			--bits;
+		}
+	}
+
+	// Should the accumulator repeat within the table, encode that exact cycle
+	// in order.
+	if (bits < 32 && ((uint32_t)1 << bits) <= ROTATION_TABLE_MAX) {
+		length = (uint32_t)1 << bits;
+		entries = new uint32_t[length][PACKET_WORDS];
+		for (i = 0; i < length; ++i) {
+			smpl.updateAntPos();
+			smpl.convert(entries[i]);
+		}
+		indexed = false;
+	}
+
+	// Otherwise, encode every position of a full revolution, and carry the 
+	// accumulator along with the table.
+	else {
+		length = ROTATION_FULL;
+		entries = new uint32_t[length][PACKET_WORDS];
+		for (i = 0; i < length; ++i) {
+			smpl.setAntPhase((uint64_t)i << PHASE_SHIFT);
+			smpl.convert(entries[i]);
+		}
+		indexed = true;
+	}
+
+	// Record the size of the table, and the time taken to build it.
+	footprint = sizeof(uint32_t) * PACKET_WORDS * length;
+	elapsed = std::chrono::steady_clock::now() - start;
+	build_us = elapsed.count();
+	cursor = 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Frees the table.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RotationTable::clear() {
+	delete[] entries;
+	entries = NULL;
+	length = 0;
+	footprint = 0;
+	cursor = 0;
+	indexed = false;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Copies the next packet of the cycle into the given words.
+//! @param arr A pointer to a memory location which shall be populated.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void RotationTable::next(uint32_t* arr) {
+
+	// Copy the entry for the advanced phase of an indexed table.
+	if (indexed) {
+		phase += step;
+		memcpy(arr, entries[phase >> PHASE_SHIFT], sizeof(entries[0]));
+		return;
+	}
+
+	// Copy the entry beneath the cursor, wrapping at the end of the cycle.
+	memcpy(arr, entries[cursor], sizeof(entries[cursor]));
+	if (++cursor == length) {
+		cursor = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the antenna phase of the most recently copied packet, from
+//! which a rebuilt table or another generator may continue.
+//! @return The antenna phase, in units of 2^-64 of a full rotation.
+//-----------------------------------------------------------------------------
+uint64_t RotationTable::getPhase() {
+
+	// A cycle repeats the phase after its final entry, so the cursor alone
+	// locates the phase within it.
+	if (indexed) {
+		return phase;
+	}
+	return phase + (uint64_t)cursor * step;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns whether the table holds a complete cycle.
+//! @return True, if the table may be used, false otherwise.
+//-----------------------------------------------------------------------------
+bool RotationTable::valid() {
+	return entries != NULL;
+}
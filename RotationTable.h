@@ -0,0 +1,99 @@
+#pragma once
+
+#include "stdafx.h"
+#include <string.h>
+#include <chrono>
+#include "Packet.h"
+
+// Establish the globally accessible macros.
+#define ROTATION_TABLE_MAX ROTATION_FULL
+
+//=============================================================================
+//! @class RotationTable
+//!
+//! @brief Holds the encoded words of a constant rate rotation, so that each
+//! packet may be copied out of the table rather than converted. Where the
+//! phase accumulator repeats within ROTATION_TABLE_MAX packets, the table
+//! holds that exact cycle. Otherwise it holds one full revolution, indexed by
+//! the upper bits of its own copy of the accumulator.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class RotationTable {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn RotationTable
+	//!
+	//! @brief Constructs a RotationTable instance.
+	//-------------------------------------------------------------------------
+	RotationTable();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~RotationTable
+	//!
+	//! @brief Destroys a RotationTable instance.
+	//-------------------------------------------------------------------------
+	~RotationTable();
+
+	//-------------------------------------------------------------------------
+	//! @fn build
+	//!
+	//! @brief Encodes the packets following the given sample.
+	//-------------------------------------------------------------------------
+	void build(Packet smpl);
+
+	//-------------------------------------------------------------------------
+	//! @fn clear
+	//!
+	//! @brief Frees the table.
+	//-------------------------------------------------------------------------
+	void clear();
+
+	//-------------------------------------------------------------------------
+	//! @fn next
+	//!
+	//! @brief Copies the next packet of the cycle into the given words.
+	//-------------------------------------------------------------------------
+	void next(uint32_t* arr);
+
+	//-------------------------------------------------------------------------
+	//! @fn getPhase
+	//!
+	//! @brief Returns the antenna phase of the most recently copied packet.
+	//-------------------------------------------------------------------------
+	uint64_t getPhase();
+
+	//-------------------------------------------------------------------------
+	//! @fn valid
+	//!
+	//! @brief Returns whether the table holds a complete cycle.
+	//-------------------------------------------------------------------------
+	bool valid();
+
+	//! The number of packets in the cycle.
+	uint32_t length;
+
+	//! The memory taken by the table, in bytes.
+	size_t footprint;
+
+	//! The time taken to build the table, in microseconds.
+	double build_us;
+private:
+
+	//! The encoded words of each packet in the cycle.
+	uint32_t (*entries)[PACKET_WORDS];
+
+	//! The index of the next packet to be copied from the cycle.
+	uint32_t cursor;
+
+	//! A flag signifying that the entries are indexed by antenna position.
+	bool indexed;
+
+	//! The phase accumulator of an indexed table, or the phase preceding the
+	//! first entry of a cycle.
+	uint64_t phase;
+
+	//! The phase increment per packet.
+	uint64_t step;
+};
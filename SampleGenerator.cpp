@@ -7,12 +7,26 @@
 //! @return Nothing.
 //-----------------------------------------------------------------------------
 SampleGenerator::SampleGenerator(char * addr, int port) : 
-	active_process(false), packet_queue(), fpga_socket(), fpga_address(), 
-	genthread(NULL), trxthread(NULL), queue_mutex() {
+	active_process(false), sample(), rotation_table(), batch_generator(), 
+	mode_sample(), scan_pattern(), scan_program(), event_timeline(), 
+	packet_ring(NULL), fpga_socket(), socket_open(false), fpga_address(), 
+	destinations(NULL), destination_count(0), genthread(NULL), 
+	trxthread(NULL), pacer(), timestamp(), batch_size(1), batch_latency(0), 
+	aggregate(1), backend_kind(BACKEND_SOCKET), backend(NULL), 
+	transmit_allocs(0), metrics(), ns_per_tick(0), recorder(), 
+	transmitted(0), replayed(0), archive(), clock(), parameters(), 
+	applied(0), retime_at(RETIME_NONE), retime_period(0) {
 
 	// Declare all relevant variables.
 	WSADATA wsadata;
 	unsigned char multicastTTL;
+	LARGE_INTEGER freq;
+
+	// Retrieve the counter frequency, in which the metrics are measured, and
+	// pace the transmitter by the generator's clock.
+	QueryPerformanceFrequency(&freq);
+	ns_per_tick = 1e9 / freq.QuadPart;
+	pacer.setClock(&clock);
 
 	// Establish the windows socket startup sequence, cleaning up the socket 
 	// data in the event of a failure.
@@ -29,6 +43,7 @@ SampleGenerator::SampleGenerator(char * addr, int port) :
 		WSACleanup();
 		exit(11);
 	}
+	socket_open = true;
 
 	// Establish multicasting within the client code.
 	multicastTTL = 1;
@@ -44,6 +59,11 @@ SampleGenerator::SampleGenerator(char * addr, int port) :
 	fpga_address.sin_family = AF_INET;
 	fpga_address.sin_port = htons(port);
 	inet_pton(AF_INET, addr, &fpga_address.sin_addr.s_addr);
+
+	// The FPGA device is the first of the receivers.
+	destinations = new Destination[DEST_MAX]();
+	destinations[0].address = fpga_address;
+	destination_count = 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -52,10 +72,222 @@ SampleGenerator::SampleGenerator(char * addr, int port) :
 //-----------------------------------------------------------------------------
 SampleGenerator::~SampleGenerator() {
 
-	// Pause the system and clean up the socket structure.
-	system("pause");
-	WSACleanup();
-	exit(0);
+	// Finish the threads, should the generator or a replay still be running,
+	// and close the socket, should it never have been started.
+	if (trxthread != NULL) {
+		uninit();
+	}
+	if (socket_open) {
+		closesocket(fpga_socket);
+		WSACleanup();
+		socket_open = false;
+	}
+	delete[] destinations;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Enables batched transmission, in which several ready packets are 
+//! handed to the socket in a single call. This must precede init.
+//! @param size The greatest number of packets sent in a single batch, where a
+//! value of one disables batching.
+//! @param max_latency The greatest delay, in seconds, which batching may add 
+//! to a packet. Whenever the packet period exceeds this budget, packets keep
+//! their individual deadlines.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::setBatch(uint32_t size, double max_latency) {
+	batch_size = size < 1 ? 1 : size;
+	batch_latency = max_latency;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Packs several consecutive packets into every datagram, each packet 
+//! complete with its own length and number. The datagrams are formed from 
+//! the batches of setBatch, whose latency budget therefore bounds the delay
+//! of the first packet of each, while FRAME_PACKETS bounds their size. A 
+//! recording replays every packet alone, so while one is set the packets 
+//! stay unpacked. This must precede init.
+//! @param packets The greatest number of packets in each datagram, where a 
+//! value of one sends every packet alone.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::setAggregation(uint32_t packets) {
+	aggregate = packets < 1 || recorder.active() ? 1 : packets > 
+		FRAME_PACKETS ? FRAME_PACKETS : packets;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Selects the backend through which the transmitter sends. Should the
+//! backend be unavailable when the generator starts, it sends through plain 
+//! sockets instead. This must precede init.
+//! @param kind The kind of backend, BACKEND_SOCKET, BACKEND_RIO or
+//! BACKEND_SHARED.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::setBackend(uint32_t kind) {
+	backend_kind = kind < BACKEND_COUNT ? kind : BACKEND_SOCKET;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the backend through which the transmitter sends, which is 
+//! the one requested unless it was unavailable.
+//! @return The kind of backend of the running transmitter, or the kind 
+//! requested before it starts.
+//-----------------------------------------------------------------------------
+uint32_t SampleGenerator::getBackend() {
+	return backend != NULL ? backend->kind() : backend_kind;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Selects the mode fields of the packets and the scan pattern they
+//! follow. The antenna mode gives the direction, or stops the antenna, and 
+//! in the manual modes, mode M selects a sector scan or a flicker, which the
+//! pattern shapes. This must precede init or render, and reconfigure may 
+//! later change the mode fields.
+//! @param smpl The sample carrying the mode fields. Its antenna position, 
+//! packet number and IRIG time are ignored.
+//! @param pattern The shape of the motion.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::setScan(Packet smpl, const ScanPattern& pattern) {
+	mode_sample = smpl;
+	scan_pattern = pattern;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Loads a script of field changes, such as of the channel, range 
+//! scale or transmitter, to be applied at set times during the run, in the
+//! format EventTimeline::load reads. Each change applies from the first 
+//! packet due at or after its time, and holds over any later reconfigure. 
+//! The rotation table cannot take a change part way through its cycle, so 
+//! a run with a script is always generated in batches. This must precede 
+//! init or render, and an empty path discards the script.
+//! @param path The location of the script.
+//! @return A zero value, if successful, or the error code otherwise, in 
+//! which case no change is applied.
+//-----------------------------------------------------------------------------
+int SampleGenerator::setTimeline(const wchar_t* path) {
+	if (path == NULL || path[0] == L'\0') {
+		event_timeline.clear();
+		return 0;
+	}
+	return event_timeline.load(path);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Adds a further receiver of every transmitted packet. Each packet is
+//! encoded once and sent to every receiver in the same batch, in the order
+//! they were added. This must precede init.
+//! @param addr The receiver address.
+//! @param port The communication port of the receiver.
+//! @return The index of the receiver, or -1 should DEST_MAX receivers 
+//! already be present, or the address not be understood.
+//-----------------------------------------------------------------------------
+int SampleGenerator::addDestination(const char* addr, int port) {
+
+	// Declare all relevant variables.
+	Destination* added;
+
+	if (destination_count >= DEST_MAX) {
+		return -1;
+	}
+	added = &destinations[destination_count];
+	memset((char*)&added->address, 0, sizeof(added->address));
+	added->address.sin_family = AF_INET;
+	added->address.sin_port = htons(port);
+	if (inet_pton(AF_INET, addr, &added->address.sin_addr.s_addr) != 1) {
+		return -1;
+	}
+	added->sent = 0;
+	added->errors = 0;
+	return (int)destination_count++;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of receivers of every transmitted packet.
+//! @return The receiver count, including the FPGA device.
+//-----------------------------------------------------------------------------
+uint32_t SampleGenerator::destinationCount() {
+	return destination_count;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns one of the receivers, whose counts of datagrams sent and of
+//! failed sends may be read while the transmitter runs.
+//! @param which The index of the receiver, below destinationCount.
+//! @return A reference to the receiver.
+//-----------------------------------------------------------------------------
+Destination& SampleGenerator::destination(uint32_t which) {
+	return destinations[which];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Records every transmitted packet, with the counter reading at its 
+//! send, into a memory-mapped file. The records keep no trace of how the 
+//! packets were packed, so a recording is refused while they are aggregated.
+//! This must precede init.
+//! @param path The location of the recording, which is replaced if it exists.
+//! @param capacity The greatest number of packets recorded, beyond which 
+//! packets are sent but not kept.
+//! @return A zero value, if successful, ERROR_NOT_SUPPORTED if the packets are
+//! aggregated, or the system error otherwise.
+//-----------------------------------------------------------------------------
+int SampleGenerator::setRecording(const wchar_t* path, uint64_t capacity) {
+	if (aggregate > 1) {
+		return ERROR_NOT_SUPPORTED;
+	}
+	return recorder.create(path, capacity);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Streams the packets of an archive into the ring in place of 
+//! generating them, starting over from the first packet whenever the archive
+//! is exhausted. The transmitter stamps each packet as usual. This must 
+//! precede init.
+//! @param path The location of the archive.
+//! @return A zero value, if successful, or the error code otherwise.
+//-----------------------------------------------------------------------------
+int SampleGenerator::setArchive(const wchar_t* path) {
+
+	// Declare all relevant variables.
+	int err;
+
+	// Open the archive, refusing one without any packets to stream.
+	err = archive.load(path);
+	if (err != 0) {
+		return err;
+	}
+	if (archive.count() == 0) {
+		archive.close();
+		return ERROR_BAD_FORMAT;
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Transmits the packets of a recording in place of generating them. 
+//! The packets are sent exactly as recorded, stamps included, each in a 
+//! datagram of its own to every receiver, so that they receive the original 
+//! packets in their original order. This takes the place of init, and is 
+//! stopped by uninit.
+//! @param path The location of the recording.
+//! @param timed A flag to send each packet at its recorded offset from the 
+//! first, rather than as fast as possible.
+//! @return A zero value, if successful, or the system error otherwise.
+//-----------------------------------------------------------------------------
+int SampleGenerator::replay(const wchar_t* path, bool timed) {
+
+	// Declare all relevant variables.
+	int err;
+
+	// Map the recording, then start the transmitter alone.
+	err = recorder.load(path);
+	if (err != 0) {
+		return err;
+	}
+	active_process = true;
+	trxthread = new std::thread(&SampleGenerator::playback, this, timed);
+	return 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -69,6 +301,33 @@ SampleGenerator::~SampleGenerator() {
 void SampleGenerator::init(uint32_t queue_len, double packet_rate, double 
 	rotate_start, double rotate_rate) {
 
+	// Declare all relevant variables.
+	Parameters params;
+
+	// Allocate the ring of encoded packets shared by both threads.
+	packet_ring = new PacketRing(queue_len);
+
+	// Prepare the sample and its generator, and publish the parameters from
+	// which any later change departs.
+	prepare(packet_rate, rotate_start, rotate_rate);
+	params.packet_rate = packet_rate;
+	params.rotate_rate = rotate_rate;
+	params.sample = sample;
+	parameters.write(params);
+	applied = parameters.version();
+	retime_at = RETIME_NONE;
+
+	// Open the requested backend to every receiver, falling back to plain 
+	// sockets should it be unavailable on this system.
+	backend = TransmitBackend::create(backend_kind);
+	if (backend->open(fpga_socket, destinations, destination_count, 
+		batch_size, aggregate, &metrics[METRIC_SKEW]) != 0) {
+		delete backend;
+		backend = TransmitBackend::create(BACKEND_SOCKET);
+		backend->open(fpga_socket, destinations, destination_count, 
+			batch_size, aggregate, &metrics[METRIC_SKEW]);
+	}
+
 	// Toggle the active process flag to enable the generator and transmitter 
 	// threads.
 	active_process = true;
@@ -79,6 +338,105 @@ void SampleGenerator::init(uint32_t queue_len, double packet_rate, double
 	trxthread = new std::thread(&SampleGenerator::transmit, this, packet_rate);
 }
 
+//-----------------------------------------------------------------------------
+//! @brief Changes the rate and rotation of the running generator, keeping 
+//! the mode fields most recently given.
+//! @param packet_rate The delay period between packet transmisssions.
+//! @param rotate_rate The angle of antenna rotation for a duration of one 
+//! second.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::reconfigure(double packet_rate, double rotate_rate) {
+
+	// Declare all relevant variables.
+	Parameters params;
+
+	parameters.read(&params);
+	reconfigure(params.sample, packet_rate, rotate_rate);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Changes the rate, rotation and mode fields of the running 
+//! generator without stopping it. The generating thread picks up the change
+//! before its next packet, continuing the antenna from its present phase, 
+//! and the transmitter adopts the new period at that same packet, so that 
+//! neither the antenna nor the packet numbers skip. Neither thread takes a 
+//! lock; each polls the version of the parameters once per packet or batch.
+//! Only a single thread may reconfigure the generator.
+//! @param smpl The sample carrying the new mode fields. Its antenna position,
+//! packet number and IRIG time are ignored.
+//! @param packet_rate The delay period between packet transmisssions.
+//! @param rotate_rate The angle of antenna rotation for a duration of one 
+//! second.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::reconfigure(Packet smpl, double packet_rate, double 
+	rotate_rate) {
+
+	// Declare all relevant variables.
+	Parameters params;
+
+	params.packet_rate = packet_rate < 0 ? 0 : packet_rate;
+	params.rotate_rate = rotate_rate;
+	params.sample = smpl;
+	parameters.write(params);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Generates a run of packets into memory without pacing, on a 
+//! simulated clock, so that an hour of traffic takes only as long as its 
+//! encoding. Every packet carries the antenna position, IRIG time and 
+//! sequence number which a real-time run meeting each of its deadlines would
+//! send. This may not be called while the generator is running.
+//! @param arr The destination of the wire words, PACKET_WORDS per packet.
+//! @param count The number of packets to generate.
+//! @param packet_rate The delay period between packet transmisssions.
+//! @param rotate_start The initial angle of the antenna.
+//! @param rotate_rate The angle of antenna rotation for a duration of one 
+//! second.
+//! @param irig_ms The IRIG time of the first packet, in milliseconds of the
+//! day.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::render(uint32_t* arr, uint64_t count, double 
+	packet_rate, double rotate_start, double rotate_rate, double irig_ms) {
+	simulate(arr, NULL, count, packet_rate, rotate_start, rotate_rate, 
+		irig_ms);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Generates a run of packets into an archive without pacing, on a 
+//! simulated clock, exactly as render does into memory. This may not be 
+//! called while the generator is running.
+//! @param path The location of the archive, which is replaced if it exists.
+//! @param count The number of packets to generate.
+//! @param packet_rate The delay period between packet transmisssions.
+//! @param rotate_start The initial angle of the antenna.
+//! @param rotate_rate The angle of antenna rotation for a duration of one 
+//! second.
+//! @param irig_ms The IRIG time of the first packet, in milliseconds of the
+//! day.
+//! @return A zero value, if successful, or the error code otherwise.
+//-----------------------------------------------------------------------------
+int SampleGenerator::render(const wchar_t* path, uint64_t count, double 
+	packet_rate, double rotate_start, double rotate_rate, double irig_ms) {
+
+	// Declare all relevant variables.
+	PacketArchive* sink;
+	int err;
+
+	// Create the archive, generate into it, and write its index.
+	sink = new PacketArchive();
+	err = sink->create(path);
+	if (err == 0) {
+		simulate(NULL, sink, count, packet_rate, rotate_start, rotate_rate,
+			irig_ms);
+		sink->close();
+	}
+	delete sink;
+	return err;
+}
+
 //-----------------------------------------------------------------------------
 //! @brief Finishes the generator and transmitter threads, clears the queue
 //! object, and performs cleanup operations on the socket.
@@ -86,31 +444,54 @@ void SampleGenerator::init(uint32_t queue_len, double packet_rate, double
 //-----------------------------------------------------------------------------
 void SampleGenerator::uninit() {
 
-	// Lock the queue mutex to prevent pushing/popping samples.
-	queue_mutex.lock();
-
 	// Toggle the active process flag to false, allowing the threads to finish.
 	active_process = false;
 
-	// Unlock the queue to allow pushing/popping samples.
-	queue_mutex.unlock();
+	// Close the ring to release either thread from a blocking wait. A replay
+	// runs the transmitter alone, without a ring.
+	if (packet_ring != NULL) {
+		packet_ring->close();
+	}
 
 	// Join the generator and transmitter threads.
-	genthread->join();
-	trxthread->join();
+	if (genthread != NULL) {
+		genthread->join();
+	}
+	if (trxthread != NULL) {
+		trxthread->join();
+	}
 
 	// Free the memory taken be the created thread objects.
-	free(genthread);
-	free(trxthread);
+	delete genthread;
+	delete trxthread;
+	genthread = NULL;
+	trxthread = NULL;
+
+	// Free the ring, along with any packets remaining in it, the rotation 
+	// table, and the backend, once its outstanding sends have left.
+	rotation_table.clear();
+	delete packet_ring;
+	packet_ring = NULL;
+	if (backend != NULL) {
+		backend->close();
+		delete backend;
+		backend = NULL;
+	}
 
-	// Empty the packet queue of sample objects.
-	while (!packet_queue.empty()) {
-		packet_queue.pop();
+	// Trim and close the recording, whether captured or replayed.
+	if (recorder.active()) {
+		recorder.close();
+	}
+	if (archive.active()) {
+		archive.close();
 	}
 
 	// Close the socket connection and perform cleanup operations.
-	closesocket(fpga_socket);
-	WSACleanup();
+	if (socket_open) {
+		closesocket(fpga_socket);
+		WSACleanup();
+		socket_open = false;
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -125,36 +506,275 @@ void SampleGenerator::uninit() {
 void SampleGenerator::generate(uint32_t queue_len, double packet_rate, double 
 	rotate_start, double rotate_rate) {
 
-	// Initialize the variables with default values.
-	Packet smpl;
-
-	// Set the rotation rate of the antenna object.
-	smpl.setAntPos(rotate_rate);
+	// Declare all relevant variables.
+	uint32_t* slot;
+	uint32_t granted;
+	uint32_t limit;
+	uint64_t generated;
+	LARGE_INTEGER enqueued;
+	Parameters params;
 
 	// Continuously push updated data onto the queue.
+	generated = 0;
 	while (active_process) {
 
-		// If the queue is larger than the maximum length, wait for a brief 
-		// period before trying again.
-		if (packet_queue.size() > queue_len - 1) {
-			std::chrono::microseconds delay(50);
-			std::this_thread::sleep_for(delay);
+		// Apply any change of parameters at this packet boundary, once the
+		// transmitter has retimed for the previous change.
+		if (parameters.version() != applied && retime_at.load(
+			std::memory_order_acquire) == RETIME_NONE) {
+			applied = parameters.read(&params);
+			apply(params, generated);
+		}
+
+		// With an archive, decode a run of packets directly into the free 
+		// slots of the ring, starting over once the archive is exhausted.
+		if (archive.active()) {
+			slot = packet_ring->acquire(BATCH_LANES, &granted);
+			if (slot == NULL) {
+				break;
+			}
+			granted = archive.read(slot, granted);
+			if (granted == 0) {
+				archive.rewind();
+				continue;
+			}
+			QueryPerformanceCounter(&enqueued);
+			packet_ring->publish(granted, enqueued.QuadPart);
+			generated += granted;
 			continue;
 		}
 
-		// Update the antenna position at the specified rotation rate, and 
-		// transmission period.
-		smpl.updateAntPos(rotate_rate, packet_rate);
+		// Without a rotation table, advance a batch of packets and write them
+		// directly into the free slots of the ring, in a format recognized by
+		// the FPGA device. Any scripted change falling due is merged into the
+		// sample first, and the batch ends before the next, so that each 
+		// takes effect on its own packet.
+		if (!rotation_table.valid()) {
+			if (generated >= event_timeline.next()) {
+				event_timeline.step(generated);
+				batch_generator.patch(event_timeline.masks, 
+					event_timeline.values);
+			}
+			limit = event_timeline.next() - generated < BATCH_LANES ? 
+				(uint32_t)(event_timeline.next() - generated) : BATCH_LANES;
+			granted = batch_generator.fill(packet_ring, limit);
+			if (granted == 0) {
+				break;
+			}
+			generated += granted;
+			continue;
+		}
+
+		// Wait for a free slot within the ring, finishing should the ring be 
+		// closed in the meantime.
+		slot = packet_ring->acquire();
+		if (slot == NULL) {
+			break;
+		}
+
+		// Copy the next packet of the cycle into the slot, and hand it to the
+		// transmitter along with the instant it was enqueued.
+		rotation_table.next(slot);
+		QueryPerformanceCounter(&enqueued);
+		packet_ring->publish(1, enqueued.QuadPart);
+		++generated;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Sets the initial position and rate of the antenna, and prepares
+//! whichever generator advances it.
+//! @param packet_rate The delay period between packet transmisssions.
+//! @param rotate_start The initial angle of the antenna.
+//! @param rotate_rate The angle of antenna rotation for a duration of one 
+//! second.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::prepare(double packet_rate, double rotate_start, double
+	rotate_rate) {
+
+	// Set the initial position of the antenna, and compute the phase 
+	// increment for the rotation rate and transmission period once.
+	sample = mode_sample;
+	sample.setAntPos(rotate_start);
+	sample.setAntRate(rotate_rate, packet_rate);
+	event_timeline.compile(packet_rate);
+	build(packet_rate);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Prepares whichever generator advances the sample, following its 
+//! present phase.
+//! @param packet_rate The delay period between packet transmisssions.
+//! @param from_step The step of the last packet generated, from which the
+//! scan pattern ramps to the new rate, or SCAN_NO_RAMP.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::build(double packet_rate, uint64_t from_step) {
 
-		// Lock the queue mutex to prevent popping samples from the object.
-		queue_mutex.lock();
+	// Any motion but a constant clockwise rotation compiles into a scan 
+	// program, which the batch generator follows. For the fixed-rate antenna
+	// modes without a script, encode the rotation up front, so that the 
+	// generator need only copy each packet out of the table. Any other mode
+	// advances a batch of packets at a time, keeping the scripted changes 
+	// already applied.
+	if (scan_program.compile(sample, scan_pattern, packet_rate, from_step)) {
+		rotation_table.clear();
+		batch_generator.init(sample, &scan_program);
+	}
+	else if (sample.getAntMode() <= ANTENNA_FIXED_12 && 
+		!event_timeline.active()) {
+		rotation_table.build(sample);
+		return;
+	}
+	else {
+		rotation_table.clear();
+		batch_generator.init(sample);
+	}
+	batch_generator.patch(event_timeline.masks, event_timeline.values);
+}
 
-		// Push a copy of the Packet object onto the queue.
-		packet_queue.push(smpl);
+//-----------------------------------------------------------------------------
+//! @brief Continues the generated packets under new parameters. The sample 
+//! takes the new mode fields at the antenna phase of the last packet 
+//! generated, and the next packet advances from it by the new step. The 
+//! scripted changes yet to come are keyed to the new period, so that each 
+//! keeps its time. The transmitter is then asked to adopt the new period at
+//! the same packet. An archive keeps its recorded packets, and changes only 
+//! its period.
+//! @param params The new parameters.
+//! @param generated The number of packets generated before the change.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::apply(const Parameters& params, uint64_t generated) {
+
+	// Declare all relevant variables.
+	uint64_t phase;
+	uint64_t step;
 
-		// Unlock the queue to allow popping samples from the object.
-		queue_mutex.unlock();
+	// Rebuild the generator from the present phase, ramping from the present
+	// step should the scan pattern ask it to.
+	if (!archive.active()) {
+		phase = rotation_table.valid() ? rotation_table.getPhase() : 
+			batch_generator.getPhase();
+		step = rotation_table.valid() ? sample.getAntStep() : 
+			batch_generator.getStep();
+		sample = params.sample;
+		sample.setAntPhase(phase);
+		sample.setAntRate(params.rotate_rate, params.packet_rate);
+		event_timeline.retime(generated, params.packet_rate);
+		build(params.packet_rate, step);
 	}
+
+	// Hand the period to the transmitter, ordered before the count.
+	retime_period = params.packet_rate;
+	retime_at.store(generated, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the greatest number of packets released together, being 
+//! those whose deadlines fall within the latency budget of the first, so that
+//! long periods keep per-packet timing.
+//! @param packet_rate The delay period between packet transmisssions.
+//! @return The batch limit, of at least one.
+//-----------------------------------------------------------------------------
+uint32_t SampleGenerator::batchLimit(double packet_rate) {
+
+	// Declare all relevant variables.
+	uint32_t limit;
+
+	limit = batch_size;
+	if (packet_rate > 0 && limit > 1 + batch_latency / packet_rate) {
+		limit = 1 + (uint32_t)(batch_latency / packet_rate);
+	}
+	return limit;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Generates a run of packets on the simulated clock. The packets are
+//! released by the same schedule and stamped by the same timestamp as in the
+//! transmitter, each batch at the instant of its final deadline, but the 
+//! clock is moved to each deadline rather than waited upon.
+//! @param arr The destination of the wire words, or NULL to generate through
+//! a single batch of words.
+//! @param sink The archive to which each batch is appended, or NULL.
+//! @param count The number of packets to generate.
+//! @param packet_rate The delay period between packet transmisssions.
+//! @param rotate_start The initial angle of the antenna.
+//! @param rotate_rate The angle of antenna rotation for a duration of one 
+//! second.
+//! @param irig_ms The IRIG time of the first packet, in milliseconds of the
+//! day.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::simulate(uint32_t* arr, PacketArchive* sink, uint64_t
+	count, double packet_rate, double rotate_start, double rotate_rate, 
+	double irig_ms) {
+
+	// Declare all relevant variables.
+	uint32_t* chunk;
+	uint32_t* words;
+	uint32_t batch_limit;
+	uint32_t batch;
+	uint32_t irig;
+	uint32_t n;
+	uint32_t i;
+	uint32_t j;
+	uint64_t done;
+
+	// Prepare the generator, and anchor the schedule and the timestamps to
+	// the simulated clock at the first packet.
+	prepare(packet_rate, rotate_start, rotate_rate);
+	batch_limit = batchLimit(packet_rate);
+	chunk = arr == NULL ? new uint32_t[BATCH_LANES * PACKET_WORDS] : NULL;
+	clock.simulate(irig_ms);
+	timestamp.anchor(clock);
+	pacer.start(packet_rate);
+
+	for (done = 0; done < count; done += n) {
+
+		// Generate the next batch of packets in the transmitted format, 
+		// applying the scripted changes as the generating thread does.
+		if (done >= event_timeline.next()) {
+			event_timeline.step(done);
+			batch_generator.patch(event_timeline.masks, event_timeline.values);
+		}
+		n = count - done < BATCH_LANES ? (uint32_t)(count - done) : 
+			BATCH_LANES;
+		if (event_timeline.next() - done < n) {
+			n = (uint32_t)(event_timeline.next() - done);
+		}
+		words = arr != NULL ? arr + done * PACKET_WORDS : chunk;
+		if (rotation_table.valid()) {
+			for (i = 0; i < n; ++i) {
+				rotation_table.next(words + i * PACKET_WORDS);
+			}
+		}
+		else {
+			batch_generator.advance(n);
+			batch_generator.write(words, n);
+		}
+
+		// Release the packets by the schedule, and stamp each with the IRIG
+		// time of its release.
+		for (i = 0; i < n; i += batch) {
+			batch = n - i < batch_limit ? n - i : batch_limit;
+			pacer.wait(batch);
+			irig = timestamp.irig(pacer.now());
+			for (j = 0; j < batch; ++j) {
+				timestamp.stamp(words + (i + j) * PACKET_WORDS, irig);
+			}
+		}
+		if (sink != NULL) {
+			sink->append(words, n);
+		}
+	}
+
+	// Return to the performance counter, and free the table and the words.
+	pacer.stop();
+	clock.release();
+	rotation_table.clear();
+	delete[] chunk;
 }
 
 //-----------------------------------------------------------------------------
@@ -166,48 +786,300 @@ void SampleGenerator::generate(uint32_t queue_len, double packet_rate, double
 void SampleGenerator::transmit(double packet_rate) {
 
 	// Declare all relevant variables.
-	Packet* smpl;
-	uint32_t* trns;
+	const uint32_t* trns;
+	uint32_t batch_limit;
+	uint32_t count;
+	uint32_t irig_ms;
+	uint32_t i;
+	uint64_t alloc_base;
+	uint64_t boundary;
+	int64_t dequeued;
+	int64_t late;
+	bool steady;
+	bool recording;
 
-	// Continuously push updated data onto the queue.
+	// Limit each batch to the packets whose deadlines fall within the latency
+	// budget of the first.
+	batch_limit = batchLimit(packet_rate);
+
+	// Anchor the timestamps to the wall clock, and the transmission schedule
+	// at the present instant.
+	alloc_base = 0;
+	steady = false;
+	recording = recorder.active();
+	timestamp.anchor(clock);
+	pacer.start(packet_rate);
+	transmitted.store(0, std::memory_order_relaxed);
+
+	// Continuously pop encoded packets from the ring.
 	while (active_process) {
 
-		// If the queue is empty, wait for a brief period before trying again.
-		if (packet_queue.empty()) {
-			std::chrono::microseconds delay(50);
-			std::this_thread::sleep_for(delay);
-			continue;
+		// Wait for an encoded packet within the ring, finishing should the 
+		// ring be closed in the meantime.
+		trns = packet_ring->front();
+		if (trns == NULL) {
+			break;
+		}
+
+		// Gather whichever further packets are already waiting, up to the 
+		// batch limit, recording the depth of the ring as found.
+		count = packet_ring->ready();
+		metrics[METRIC_DEPTH].record(count);
+		if (count > batch_limit) {
+			count = batch_limit;
 		}
 
-		// Initialize the variables with default values.
-		smpl = new Packet();
-		trns = new uint32_t[6];
+		// Should the parameters have changed, end the batch at the first
+		// packet generated under them, and adopt the new period once that
+		// packet is reached. The count is read after the ring, so it is seen
+		// before any packet beyond it.
+		boundary = retime_at.load(std::memory_order_acquire);
+		if (boundary != RETIME_NONE) {
+			if (pacer.count == boundary) {
+				packet_rate = retime_period;
+				pacer.retime(packet_rate);
+				batch_limit = batchLimit(packet_rate);
+				retime_at.store(RETIME_NONE, std::memory_order_release);
+				if (count > batch_limit) {
+					count = batch_limit;
+				}
+			}
+			else if (count > boundary - pacer.count) {
+				count = (uint32_t)(boundary - pacer.count);
+			}
+		}
+
+		// Wait for the deadline of the final packet, t0 + n * packet_rate, 
+		// absorbing the time spent on the previous packets.
+		pacer.wait(count);
 
-		// Lock the queue mutex to prevent pushing samples onto the object.
-		queue_mutex.lock();
+		// Stamp each packet with the IRIG time of its release and the next 
+		// sequence number, reading the counter once for the batch. The same
+		// reading ends the residency of each packet within the ring, and the
+		// lateness of its deadline is taken from the schedule's log.
+		dequeued = pacer.now();
+		irig_ms = timestamp.irig(dequeued);
+		for (i = 0; i < count; ++i) {
+			timestamp.stamp(packet_ring->at(i), irig_ms);
+			metrics[METRIC_RESIDENCY].record((uint64_t)((dequeued - 
+				packet_ring->enqueued(i)) * ns_per_tick));
+			if (packet_rate > 0) {
+				late = pacer.lateness(pacer.count - count + i);
+				metrics[METRIC_LATENESS].record(late > 0 ? late : 0);
+			}
+			if (recording) {
+				recorder.record(packet_ring->at(i), dequeued);
+			}
+		}
 
-		// Pop a sample from the queue and convert it to a format recognized by 
-		// the FPGA device.
-		*smpl = packet_queue.front();
-		packet_queue.pop();
-		smpl->convert(trns);
+		// Hand the retrieved packets to the backend.
+		backend->send(packet_ring, count);
+		metrics[METRIC_SEND].record((uint64_t)((pacer.now() - dequeued) * 
+			ns_per_tick));
 
-		// Unlock the queue to allow pushing samples onto the object.
-		queue_mutex.unlock();
+		// Return the slots to the generator, and publish the count sent.
+		packet_ring->release(count);
+		transmitted.store(pacer.count, std::memory_order_relaxed);
 
-		// Send the retrieved packet over the communication socket.
-		if (sendto(fpga_socket, (const char*)trns, 20, 0, (SOCKADDR*)
-			&fpga_address, sizeof(struct sockaddr_in)) < 0) {
-			int err = WSAGetLastError();
+		// Once the first packets have been sent, every later allocation on 
+		// this thread lies on the steady-state hot path, and should not occur.
+		if (!steady) {
+			alloc_base = AllocCounter::count();
+			steady = true;
 		}
+	}
 
-		// Delay the next packet transmission by whatever period the user has
-		// has specified.
-		std::chrono::duration<double> delay(packet_rate);
-		std::this_thread::sleep_for(delay);
+	// Record the steady-state allocations, and release the timer resolution 
+	// raised by the schedule.
+	if (steady) {
+		transmit_allocs = AllocCounter::count() - alloc_base;
+	}
+	pacer.stop();
+}
 
-		// Clear the generated sample and associated conversion from memory.
-		free(smpl);
-		free(trns);
+//-----------------------------------------------------------------------------
+//! @brief Transmits the packets of a loaded recording, finishing at its end.
+//! @param timed A flag to send each packet at its recorded offset from the 
+//! first, scaled to this machine's counter, rather than as fast as possible.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::playback(bool timed) {
+
+	// Declare all relevant variables.
+	const PacketRecord* rec;
+	uint64_t total;
+	uint64_t i;
+	uint32_t d;
+	int64_t origin;
+	int64_t first;
+	int64_t target;
+	int64_t sending;
+	double scale;
+
+	// Raise the timer resolution, and anchor the recorded offsets at the
+	// present instant.
+	total = recorder.count();
+	if (total == 0) {
+		return;
+	}
+	pacer.start(0);
+	scale = 1e9 / ns_per_tick / recorder.frequency();
+	first = recorder.at(0)->ticks;
+	origin = pacer.now();
+
+	// Send each record to every receiver, recording the lateness of its 
+	// replay and the duration of the sends.
+	for (i = 0; i < total && active_process; ++i) {
+		rec = recorder.at(i);
+		if (timed) {
+			target = origin + (int64_t)((rec->ticks - first) * scale);
+			sending = pacer.until(target);
+			metrics[METRIC_LATENESS].record((uint64_t)((sending - target) *
+				ns_per_tick));
+		}
+		else {
+			sending = pacer.now();
+		}
+		for (d = 0; d < destination_count; ++d) {
+			if (sendto(fpga_socket, (const char*)rec->words, TRANSMIT_LEN, 0,
+				(SOCKADDR*)&destinations[d].address, 
+				sizeof(struct sockaddr_in)) < 0) {
+				destinations[d].errors.fetch_add(1, 
+					std::memory_order_relaxed);
+			}
+			else {
+				destinations[d].sent.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		metrics[METRIC_SEND].record((uint64_t)((pacer.now() - sending) * 
+			ns_per_tick));
+		replayed.store(i + 1, std::memory_order_relaxed);
 	}
+	pacer.stop();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of heap allocations made by the transmitting 
+//! thread once it reached its steady state.
+//! @return The allocation count, valid once uninit has joined the thread, and
+//! zero unless the project is built with EGRIM_ALLOC_HOOK.
+//-----------------------------------------------------------------------------
+uint64_t SampleGenerator::allocations() {
+	return transmit_allocs;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of packets released by the transmitter.
+//! @return The packet count, which may be read while the generator runs.
+//-----------------------------------------------------------------------------
+uint64_t SampleGenerator::sent() {
+	return transmitted.load(std::memory_order_relaxed) + replayed.load(
+		std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the rotation table used by the generating thread.
+//! @return A reference to the table, valid from init until uninit.
+//-----------------------------------------------------------------------------
+RotationTable& SampleGenerator::table() {
+	return rotation_table;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the batch generator used by the generating thread.
+//! @return A reference to the batch generator.
+//-----------------------------------------------------------------------------
+BatchGenerator& SampleGenerator::batcher() {
+	return batch_generator;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the scan program followed by the generating thread.
+//! @return A reference to the scan program, which is followed only when the
+//! motion is not a constant clockwise rotation.
+//-----------------------------------------------------------------------------
+ScanProgram& SampleGenerator::scan() {
+	return scan_program;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the timeline of field changes applied by the generating 
+//! thread.
+//! @return A reference to the timeline, whose events are keyed to their 
+//! packets from init or render onward.
+//-----------------------------------------------------------------------------
+EventTimeline& SampleGenerator::script() {
+	return event_timeline;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the send-time stamp used by the transmitting thread.
+//! @return A reference to the stamp, whose sequence is valid once uninit has
+//! joined the thread.
+//-----------------------------------------------------------------------------
+Timestamp& SampleGenerator::stamps() {
+	return timestamp;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the pacer governing the transmitting thread.
+//! @return A reference to the pacer, whose lateness statistics are complete
+//! once uninit has joined the thread.
+//-----------------------------------------------------------------------------
+Pacer& SampleGenerator::schedule() {
+	return pacer;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns one of the histograms recorded by the transmitting thread,
+//! which may be snapshotted while it runs.
+//! @param which The metric, one of the METRIC values.
+//! @return A reference to the histogram.
+//-----------------------------------------------------------------------------
+LatencyHistogram& SampleGenerator::metric(uint32_t which) {
+	return metrics[which];
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Writes a snapshot of every histogram as a single JSON line, so that
+//! repeated dumps to the same file may be read as a series.
+//! @param out The file to which the line is written.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SampleGenerator::dump(FILE* out) {
+
+	// Declare all relevant variables.
+	static const char* names[METRIC_COUNT] = { "residency_ns", "lateness_ns", 
+		"send_ns", "queue_depth", "skew_ns" };
+	HistogramSnapshot* snap;
+	uint32_t i;
+
+	// The snapshot is too large to hold comfortably on the stack.
+	snap = new HistogramSnapshot();
+	fprintf(out, "{\"irig_ms\": %u, \"sent\": %llu, \"metrics\": [", 
+		timestamp.irig(), (unsigned long long)transmitted.load(
+		std::memory_order_relaxed));
+	for (i = 0; i < METRIC_COUNT; ++i) {
+		metrics[i].snapshot(snap);
+		snap->write(out, names[i]);
+		fprintf(out, "%s", i + 1 < METRIC_COUNT ? ", " : "");
+	}
+	fprintf(out, "], \"destinations\": [");
+	for (i = 0; i < destination_count; ++i) {
+		fprintf(out, "{\"sent\": %llu, \"errors\": %llu}%s", 
+			(unsigned long long)destinations[i].sent.load(), 
+			(unsigned long long)destinations[i].errors.load(), 
+			i + 1 < destination_count ? ", " : "");
+	}
+	fprintf(out, "]}\n");
+	fflush(out);
+	delete snap;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the recorder capturing or replaying the packets.
+//! @return A reference to the recorder.
+//-----------------------------------------------------------------------------
+PacketRecorder& SampleGenerator::recording() {
+	return recorder;
 }
\ No newline at end of file
@@ -1,13 +1,37 @@
+#pragma once
+
 #include "stdafx.h"
-#include <queue>
 #include <atomic>
 #include <chrono>
 #include <thread>
-#include <mutex>
 #include <tchar.h>
 #include <WS2tcpip.h>
 #include <winsock2.h>
 #include "Packet.h"
+#include "PacketRing.h"
+#include "Pacer.h"
+#include "AllocCounter.h"
+#include "RotationTable.h"
+#include "BatchGenerator.h"
+#include "Timestamp.h"
+#include "LatencyHistogram.h"
+#include "PacketRecorder.h"
+#include "PacketArchive.h"
+#include "Clock.h"
+#include "ParameterBlock.h"
+#include "TransmitBackend.h"
+#include "ScanProgram.h"
+#include "EventTimeline.h"
+
+// Establish the globally accessible macros.
+#define TRANSMIT_LEN PACKET_BYTES
+#define METRIC_RESIDENCY 0
+#define METRIC_LATENESS 1
+#define METRIC_SEND 2
+#define METRIC_DEPTH 3
+#define METRIC_SKEW 4
+#define METRIC_COUNT 5
+#define RETIME_NONE UINT64_MAX
 
 //=============================================================================
 //! @class SampleGenerator
@@ -31,6 +55,97 @@ public:
 	//-------------------------------------------------------------------------
 	~SampleGenerator();
 
+	//-------------------------------------------------------------------------
+	//! @fn setBatch
+	//!
+	//! @brief Enables batched transmission, in which several ready packets
+	//! are handed to the socket in a single call.
+	//-------------------------------------------------------------------------
+	void setBatch(uint32_t size, double max_latency);
+
+	//-------------------------------------------------------------------------
+	//! @fn setAggregation
+	//!
+	//! @brief Packs several consecutive packets of each batch into every
+	//! datagram.
+	//-------------------------------------------------------------------------
+	void setAggregation(uint32_t packets);
+
+	//-------------------------------------------------------------------------
+	//! @fn setBackend
+	//!
+	//! @brief Selects the backend through which the transmitter sends.
+	//-------------------------------------------------------------------------
+	void setBackend(uint32_t kind);
+
+	//-------------------------------------------------------------------------
+	//! @fn getBackend
+	//!
+	//! @brief Returns the backend through which the transmitter sends.
+	//-------------------------------------------------------------------------
+	uint32_t getBackend();
+
+	//-------------------------------------------------------------------------
+	//! @fn setScan
+	//!
+	//! @brief Selects the mode fields of the packets and the scan pattern 
+	//! they follow.
+	//-------------------------------------------------------------------------
+	void setScan(Packet smpl, const ScanPattern& pattern);
+
+	//-------------------------------------------------------------------------
+	//! @fn setTimeline
+	//!
+	//! @brief Loads a script of field changes to be applied at set times 
+	//! during the run.
+	//-------------------------------------------------------------------------
+	int setTimeline(const wchar_t* path);
+
+	//-------------------------------------------------------------------------
+	//! @fn addDestination
+	//!
+	//! @brief Adds a further receiver of every transmitted packet.
+	//-------------------------------------------------------------------------
+	int addDestination(const char* addr, int port);
+
+	//-------------------------------------------------------------------------
+	//! @fn destinationCount
+	//!
+	//! @brief Returns the number of receivers of every transmitted packet.
+	//-------------------------------------------------------------------------
+	uint32_t destinationCount();
+
+	//-------------------------------------------------------------------------
+	//! @fn destination
+	//!
+	//! @brief Returns one of the receivers, with its send and error counts.
+	//-------------------------------------------------------------------------
+	Destination& destination(uint32_t which);
+
+	//-------------------------------------------------------------------------
+	//! @fn setRecording
+	//!
+	//! @brief Records every transmitted packet into a memory-mapped file.
+	//-------------------------------------------------------------------------
+	int setRecording(const wchar_t* path, uint64_t capacity = 
+		RECORD_CAPACITY);
+
+	//-------------------------------------------------------------------------
+	//! @fn setArchive
+	//!
+	//! @brief Streams the packets of an archive into the ring in place of
+	//! generating them.
+	//-------------------------------------------------------------------------
+	int setArchive(const wchar_t* path);
+
+	//-------------------------------------------------------------------------
+	//! @fn replay
+	//!
+	//! @brief Transmits the packets of a recording in place of generating
+	//! them, at their recorded timing or as fast as possible.
+	//-------------------------------------------------------------------------
+	int replay(const wchar_t* path, bool timed);
+
 	//-------------------------------------------------------------------------
 	//! @fn init
 	//!
@@ -39,6 +154,40 @@ public:
 	void init(uint32_t queue_len, double packet_rate, double rotate_start, 
 		double rotate_rate);
 
+	//-------------------------------------------------------------------------
+	//! @fn reconfigure
+	//!
+	//! @brief Changes the rate and rotation of the running generator from the
+	//! next packet boundary, keeping its mode fields.
+	//-------------------------------------------------------------------------
+	void reconfigure(double packet_rate, double rotate_rate);
+
+	//-------------------------------------------------------------------------
+	//! @fn reconfigure
+	//!
+	//! @brief Changes the rate, rotation and mode fields of the running 
+	//! generator from the next packet boundary.
+	//-------------------------------------------------------------------------
+	void reconfigure(Packet smpl, double packet_rate, double rotate_rate);
+
+	//-------------------------------------------------------------------------
+	//! @fn render
+	//!
+	//! @brief Generates a run of packets into memory without pacing, on a
+	//! simulated clock.
+	//-------------------------------------------------------------------------
+	void render(uint32_t* arr, uint64_t count, double packet_rate, double 
+		rotate_start, double rotate_rate, double irig_ms);
+
+	//-------------------------------------------------------------------------
+	//! @fn render
+	//!
+	//! @brief Generates a run of packets into an archive without pacing, on a
+	//! simulated clock.
+	//-------------------------------------------------------------------------
+	int render(const wchar_t* path, uint64_t count, double packet_rate, 
+		double rotate_start, double rotate_rate, double irig_ms);
+
 	//-------------------------------------------------------------------------
 	//! @fn uninit
 	//!
@@ -63,29 +212,252 @@ public:
 	//! rate of time.
 	//-------------------------------------------------------------------------
 	void transmit(double packet_rate);
+
+	//-------------------------------------------------------------------------
+	//! @fn allocations
+	//!
+	//! @brief Returns the number of heap allocations made by the transmitting
+	//! thread once it reached its steady state.
+	//-------------------------------------------------------------------------
+	uint64_t allocations();
+
+	//-------------------------------------------------------------------------
+	//! @fn sent
+	//!
+	//! @brief Returns the number of packets released by the transmitter.
+	//-------------------------------------------------------------------------
+	uint64_t sent();
+
+	//-------------------------------------------------------------------------
+	//! @fn table
+	//!
+	//! @brief Returns the rotation table used by the generating thread.
+	//-------------------------------------------------------------------------
+	RotationTable& table();
+
+	//-------------------------------------------------------------------------
+	//! @fn batcher
+	//!
+	//! @brief Returns the batch generator used by the generating thread.
+	//-------------------------------------------------------------------------
+	BatchGenerator& batcher();
+
+	//-------------------------------------------------------------------------
+	//! @fn scan
+	//!
+	//! @brief Returns the scan program followed by the generating thread.
+	//-------------------------------------------------------------------------
+	ScanProgram& scan();
+
+	//-------------------------------------------------------------------------
+	//! @fn script
+	//!
+	//! @brief Returns the timeline of field changes applied by the generating
+	//! thread.
+	//-------------------------------------------------------------------------
+	EventTimeline& script();
+
+	//-------------------------------------------------------------------------
+	//! @fn stamps
+	//!
+	//! @brief Returns the send-time stamp used by the transmitting thread.
+	//-------------------------------------------------------------------------
+	Timestamp& stamps();
+
+	//-------------------------------------------------------------------------
+	//! @fn schedule
+	//!
+	//! @brief Returns the pacer governing the transmitting thread.
+	//-------------------------------------------------------------------------
+	Pacer& schedule();
+
+	//-------------------------------------------------------------------------
+	//! @fn recording
+	//!
+	//! @brief Returns the recorder capturing or replaying the packets.
+	//-------------------------------------------------------------------------
+	PacketRecorder& recording();
+
+	//-------------------------------------------------------------------------
+	//! @fn metric
+	//!
+	//! @brief Returns one of the histograms recorded by the transmitting
+	//! thread, which may be snapshotted while it runs.
+	//-------------------------------------------------------------------------
+	LatencyHistogram& metric(uint32_t which);
+
+	//-------------------------------------------------------------------------
+	//! @fn dump
+	//!
+	//! @brief Writes a snapshot of every histogram as a single JSON line.
+	//-------------------------------------------------------------------------
+	void dump(FILE* out);
 private:
 
+	//-------------------------------------------------------------------------
+	//! @fn prepare
+	//!
+	//! @brief Sets the initial position and rate of the antenna, and prepares
+	//! whichever generator advances it.
+	//-------------------------------------------------------------------------
+	void prepare(double packet_rate, double rotate_start, double rotate_rate);
+
+	//-------------------------------------------------------------------------
+	//! @fn build
+	//!
+	//! @brief Prepares whichever generator advances the sample.
+	//-------------------------------------------------------------------------
+	void build(double packet_rate, uint64_t from_step = SCAN_NO_RAMP);
+
+	//-------------------------------------------------------------------------
+	//! @fn apply
+	//!
+	//! @brief Continues the generated packets under new parameters, and asks
+	//! the transmitter to retime at the same packet.
+	//-------------------------------------------------------------------------
+	void apply(const Parameters& params, uint64_t generated);
+
+	//-------------------------------------------------------------------------
+	//! @fn batchLimit
+	//!
+	//! @brief Returns the greatest number of packets released together.
+	//-------------------------------------------------------------------------
+	uint32_t batchLimit(double packet_rate);
+
+	//-------------------------------------------------------------------------
+	//! @fn simulate
+	//!
+	//! @brief Generates a run of packets on the simulated clock.
+	//-------------------------------------------------------------------------
+	void simulate(uint32_t* arr, PacketArchive* sink, uint64_t count, double
+		packet_rate, double rotate_start, double rotate_rate, double irig_ms);
+
+	//-------------------------------------------------------------------------
+	//! @fn playback
+	//!
+	//! @brief Transmits the packets of a loaded recording.
+	//-------------------------------------------------------------------------
+	void playback(bool timed);
+
+
 	//! A flag to restrict the operation of the generation and transmission 
 	//! threads.
 	std::atomic<bool> active_process;
 
-	//! A queue of Packet objects to be transmitted at a constant rate.
-	std::queue<Packet> packet_queue;
+	//! The sample preceding the first generated packet.
+	Packet sample;
+
+	//! One full cycle of encoded packets, for the fixed-rate antenna modes.
+	RotationTable rotation_table;
+
+	//! The batch generator advancing the packets of the remaining modes.
+	BatchGenerator batch_generator;
+
+	//! The sample whose mode fields the generated packets take.
+	Packet mode_sample;
+
+	//! The shape of the antenna's motion in the modes which scan.
+	ScanPattern scan_pattern;
+
+	//! The scan pattern compiled for the present sample and rate, which the 
+	//! batch generator follows for any motion but a constant rotation.
+	ScanProgram scan_program;
+
+	//! The field changes scripted for the run, which the batch generator 
+	//! merges into its sample at their packets.
+	EventTimeline event_timeline;
+
+	//! A ring of encoded packets to be transmitted at a constant rate.
+	PacketRing* packet_ring;
 
 	//! A communication socket over which Packets are transferred to the FPGA 
 	//! device.
 	SOCKET fpga_socket;
 
+	//! A flag signifying that the socket is open, and the socket library 
+	//! started, apart from whether any thread is running.
+	bool socket_open;
+
 	//! An address representing the location of the FPGA device.
 	sockaddr_in fpga_address;
 
+	//! The receivers of every transmitted packet, the first of which is the
+	//! FPGA device.
+	Destination* destinations;
+
+	//! The number of receivers.
+	uint32_t destination_count;
+
 	//! A pointer to the packet-generating thread.
 	std::thread* genthread;
 
 	//! A pointer to the packet-transmitting thread.
 	std::thread* trxthread;
 
-	//! A mutex to prevent simultaneous popping and pushing of samples onto the 
-	//! queue object.
-	std::mutex queue_mutex;
+	//! The absolute-deadline scheduler pacing the transmitting thread.
+	Pacer pacer;
+
+	//! The send-time stamp of IRIG time and sequence number.
+	Timestamp timestamp;
+
+	//! The greatest number of packets sent in a single batch.
+	uint32_t batch_size;
+
+	//! The greatest delay, in seconds, which batching may add to a packet.
+	double batch_latency;
+
+	//! The greatest number of packets packed into each datagram.
+	uint32_t aggregate;
+
+	//! The kind of backend requested for the transmitter.
+	uint32_t backend_kind;
+
+	//! The backend through which the transmitter sends, while it runs.
+	TransmitBackend* backend;
+
+	//! The number of allocations made by the transmitting thread after its
+	//! first packet, as counted by the allocation hook.
+	std::atomic<uint64_t> transmit_allocs;
+
+	//! The histograms recorded by the transmitting thread: the nanoseconds
+	//! each packet spent within the ring, the nanoseconds by which it missed
+	//! its deadline, the nanoseconds taken by each send call, and the depth of
+	//! the ring at each batch.
+	LatencyHistogram metrics[METRIC_COUNT];
+
+	//! The nanoseconds elapsed per performance counter tick.
+	double ns_per_tick;
+
+	//! The recorder capturing the transmitted packets, or holding those to
+	//! be replayed.
+	PacketRecorder recorder;
+
+	//! The number of generated packets sent, published by the transmitter so
+	//! that other threads need not read its schedule.
+	std::atomic<uint64_t> transmitted;
+
+	//! The number of recorded packets replayed.
+	std::atomic<uint64_t> replayed;
+
+	//! The archive streamed into the ring in place of generated packets.
+	PacketArchive archive;
+
+	//! The clock pacing and stamping the packets, which is simulated while
+	//! rendering.
+	Clock clock;
+
+	//! The parameters which may be changed while the generator runs.
+	ParameterBlock parameters;
+
+	//! The version of the parameters most recently applied by the generating
+	//! thread.
+	uint32_t applied;
+
+	//! The number of packets generated before the most recent change of 
+	//! parameters, at which the transmitter retimes, or RETIME_NONE once it
+	//! has done so.
+	std::atomic<uint64_t> retime_at;
+
+	//! The period adopted by the transmitter at the retiming packet.
+	double retime_period;
 };
\ No newline at end of file
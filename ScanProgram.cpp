@@ -0,0 +1,339 @@
+#include "ScanProgram.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a ScanProgram instance, holding the antenna still.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+ScanProgram::ScanProgram() : used(0), lead(0), rejected(false), segments(),
+	index(0), offset(0), base(0), phase(0) {
+	append(0, 0, SCAN_HOLD);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Compiles the pattern selected by the sample's mode fields, starting
+//! from its present phase. The manual modes scan a sector or flicker as mode
+//! M selects, and otherwise rotate continuously, counter-clockwise in the
+//! manual CCW mode. The stopped mode holds the antenna still. A continuous
+//! rotation stops and starts should the pattern ask it to. Every program
+//! opens with a ramp from the previous step, if one is given and differs,
+//! and a sector or flicker then travels at the scan rate to the edge of the
+//! sector at which its sweep begins. A pattern whose segments, once split to
+//! SCAN_HOLD packets, would not fit the program is rejected, and the antenna
+//! rotates steadily in its direction instead.
+//! @param smpl The sample, with its phase and clockwise rotation rate set.
+//! @param pattern The shape of the motion.
+//! @param clkrate The packet transmission rate, in seconds.
+//! @param from_step The step of the packet preceding the first, from which
+//! the program ramps, or SCAN_NO_RAMP to begin at the new rate.
+//! @return A true value, if the program is needed, or false if the motion is
+//! a constant clockwise rotation which the sample's own step describes.
+//-----------------------------------------------------------------------------
+bool ScanProgram::compile(Packet smpl, const ScanPattern& pattern, double
+	clkrate, uint64_t from_step) {
+
+	// Declare all relevant variables.
+	int64_t s;
+	uint64_t mag;
+	uint64_t ramp;
+	uint64_t width;
+	uint64_t entry;
+	uint64_t at;
+	uint64_t sweep;
+	uint64_t over;
+	uint64_t hop;
+	uint64_t rate;
+	uint8_t mode;
+	uint8_t mode_m;
+	uint32_t i;
+
+	used = 0;
+	lead = 0;
+	rejected = false;
+	index = 0;
+	offset = 0;
+	phase = smpl.getAntPhase();
+	base = phase;
+
+	// Take the signed step from the direction the antenna mode gives, and
+	// the length of a change of rate in packets.
+	mode = smpl.getAntMode();
+	mode_m = smpl.getModeM();
+	s = (int64_t)smpl.getAntStep();
+	if (mode == ANTENNA_MANUAL_CCW) {
+		s = -s;
+	}
+	else if (mode == ANTENNA_STOPPED) {
+		s = 0;
+	}
+	mag = s < 0 ? (uint64_t)-s : (uint64_t)s;
+	ramp = clkrate > 0 ? (uint64_t)(pattern.ramp_s / clkrate + 0.5) : 0;
+	width = angle(pattern.sector_width > 0 ? pattern.sector_width :
+		SCAN_SECTOR_WIDTH);
+
+	// Ramp from the previous step, should the rate have changed.
+	if (from_step != SCAN_NO_RAMP && from_step != (uint64_t)s && ramp > 0) {
+		append(from_step, (uint64_t)((s - (int64_t)from_step) / (int64_t)
+			ramp), ramp);
+	}
+	at = base;
+	for (i = 0; i < used; ++i) {
+		at += segments[i].advance;
+	}
+
+	// Without a sector, rotate continuously, stopping and starting should
+	// the pattern ask it to. A constant clockwise rotation from the sample's
+	// own step needs no program.
+	if (mode < ANTENNA_MANUAL_CW || mode > ANTENNA_MANUAL_CCW || mode_m ==
+		MODE_M_NONE || mag == 0 || width == 0) {
+		lead = used;
+		if (mag != 0 && pattern.run_s > 0 && pattern.stop_s > 0 && clkrate >
+			0) {
+			append((uint64_t)s, 0, (uint64_t)(pattern.run_s / clkrate + 0.5));
+			if (ramp > 0) {
+				append((uint64_t)s, (uint64_t)(-s / (int64_t)ramp), ramp);
+			}
+			append(0, 0, (uint64_t)(pattern.stop_s / clkrate + 0.5));
+			if (ramp > 0) {
+				append(0, (uint64_t)(s / (int64_t)ramp), ramp);
+			}
+		}
+		else {
+			append((uint64_t)s, 0, SCAN_HOLD);
+		}
+		if (rejected) {
+			return rotate(s, smpl.getAntStep());
+		}
+		return used > 1 || (uint64_t)s != smpl.getAntStep();
+	}
+
+	// A sector reverses at each edge. Each reversal overshoots the point at
+	// which it begins by a quarter of the distance the ramp would cover at the
+	// scan rate, so the sweeps are kept that far inside the sector, and the
+	// ramp is shortened should it not fit.
+	over = 0;
+	if (mode_m == MODE_M_SECTOR) {
+		if (ramp > (width / 2) / (mag / 4 + 1)) {
+			ramp = (width / 2) / (mag / 4 + 1);
+		}
+		over = ramp * (mag / 4);
+	}
+
+	// Travel at the scan rate to the point at which the sweep begins.
+	entry = angle(pattern.sector_start) + (s > 0 ? over : width - over);
+	append((uint64_t)s, 0, (s > 0 ? entry - at : at - entry) / mag);
+	lead = used;
+
+	// A sector sweeps one way and back, turning within the sector.
+	if (mode_m == MODE_M_SECTOR) {
+		sweep = (width - 2 * over) / mag;
+		append((uint64_t)s, 0, sweep);
+		if (ramp > 0) {
+			append((uint64_t)s, (uint64_t)(-2 * s / (int64_t)ramp), ramp);
+		}
+		append((uint64_t)-s, 0, sweep);
+		if (ramp > 0) {
+			append((uint64_t)-s, (uint64_t)(2 * s / (int64_t)ramp), ramp);
+		}
+	}
+
+	// A flicker sweeps the sector in the scan direction only, then slews
+	// back across it, or, flickering between two sectors, slews on to the
+	// start of the other.
+	else {
+		rate = pattern.slew_rate > 0 ? angle(pattern.slew_rate * clkrate) :
+			mag * SCAN_SLEW_FACTOR;
+		hop = angle(pattern.flicker_offset != 0 ? pattern.flicker_offset :
+			180.0);
+		sweep = width / mag;
+		for (i = 0; i < (mode_m == MODE_M_FLICKER_2 ? 2u : 1u); ++i) {
+			append((uint64_t)s, 0, sweep);
+			at = entry + (uint64_t)s * sweep;
+			if (mode_m == MODE_M_FLICKER_1) {
+				slew(sweep * mag, s < 0, rate);
+				continue;
+			}
+			entry += i == 0 ? hop : (uint64_t)0 - hop;
+			slew(s > 0 ? entry - at : at - entry, s > 0, rate);
+		}
+	}
+	if (used == lead) {
+		append(0, 0, SCAN_HOLD);
+	}
+	if (rejected) {
+		return rotate(s, smpl.getAntStep());
+	}
+	close();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Advances the antenna by several transmission periods, writing the
+//! position reached at each. Within a segment each position depends only on
+//! the segment's start and its own index, so the loop carries no dependency
+//! and may be vectorized.
+//! @param positions A pointer to a memory location which shall be populated
+//! with one position per period.
+//! @param count The number of periods to advance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void ScanProgram::advance(uint32_t* positions, uint32_t count) {
+
+	// Declare all relevant variables.
+	const ScanSegment* seg;
+	uint64_t i;
+	uint32_t done;
+	uint32_t n;
+	uint32_t j;
+
+	for (done = 0; done < count; done += n) {
+
+		// Evaluate the rest of the batch, or of the segment, whichever ends
+		// first.
+		seg = &segments[index];
+		n = seg->length - offset < count - done ? seg->length - offset :
+			count - done;
+		for (j = 0; j < n; ++j) {
+			i = offset + j + 1;
+			positions[done + j] = (uint32_t)((base + i * seg->step +
+				seg->accel * (i * (i - 1) / 2)) >> PHASE_SHIFT);
+		}
+		offset += n;
+		i = offset;
+		phase = base + i * seg->step + seg->accel * (i * (i - 1) / 2);
+
+		// Move to the next segment, returning to the start of the cycle after
+		// its last.
+		if (offset == seg->length) {
+			base += seg->advance;
+			offset = 0;
+			index = index + 1 < used ? index + 1 : lead;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the antenna phase of the most recently advanced packet.
+//! @return The antenna phase, in units of 2^-64 of a full rotation.
+//-----------------------------------------------------------------------------
+uint64_t ScanProgram::getPhase() {
+	return phase;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the phase the next packet will add, from which a change of
+//! rate may ramp.
+//! @return The step, modulo 2^64.
+//-----------------------------------------------------------------------------
+uint64_t ScanProgram::getStep() {
+	return segments[index].step + offset * segments[index].accel;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Converts an angle into a phase, as setAntRate does a rotation.
+//! @param degrees The angle, which wraps to a single turn.
+//! @return The phase, in units of 2^-64 of a full rotation.
+//-----------------------------------------------------------------------------
+uint64_t ScanProgram::angle(double degrees) {
+
+	// Declare all relevant variables.
+	double rev;
+	double upper;
+	uint64_t high;
+
+	rev = fmod(degrees / 360.0, 1.0);
+	if (rev < 0) {
+		rev += 1.0;
+	}
+	upper = rev * 4294967296.0;
+	high = (uint64_t)upper;
+	return (high << 32) + (uint64_t)((upper - high) * 4294967296.0);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Adds a segment to the program, finding the phase it advances. A
+//! segment longer than SCAN_HOLD is split into several, each continuing the
+//! step of the last, and an empty segment is dropped. Should the segments
+//! not fit within SCAN_SEGMENTS, the program is marked as rejected.
+//! @param step The phase added for the first packet.
+//! @param accel The change of the step from each packet to the next.
+//! @param length The number of packets.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void ScanProgram::append(uint64_t step, uint64_t accel, uint64_t length) {
+
+	// Declare all relevant variables.
+	ScanSegment* seg;
+	uint64_t n;
+
+	for (; length > 0 && !rejected; length -= n) {
+		if (used == SCAN_SEGMENTS) {
+			rejected = true;
+			return;
+		}
+		n = length < SCAN_HOLD ? length : SCAN_HOLD;
+		seg = &segments[used++];
+		seg->step = step;
+		seg->accel = accel;
+		seg->length = (uint32_t)n;
+		seg->advance = n * step + accel * (n * (n - 1) / 2);
+		step += n * accel;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Replaces the program with a constant rotation at the given step,
+//! from the phase at which it began, for a pattern which was rejected.
+//! @param step The signed phase added for each packet.
+//! @param own_step The sample's own step, a clockwise rotation.
+//! @return A true value, if the program is needed, or false if the rotation
+//! is the sample's own.
+//-----------------------------------------------------------------------------
+bool ScanProgram::rotate(int64_t step, uint64_t own_step) {
+	used = 0;
+	lead = 0;
+	rejected = false;
+	append((uint64_t)step, 0, SCAN_HOLD);
+	rejected = true;
+	return (uint64_t)step != own_step;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Adds a segment moving the antenna a given distance at no more than
+//! a given rate, in as few packets as that allows.
+//! @param distance The phase to be covered.
+//! @param clockwise A flag signifying that the antenna moves clockwise.
+//! @param rate The greatest phase added per packet.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void ScanProgram::slew(uint64_t distance, bool clockwise, uint64_t rate) {
+
+	// Declare all relevant variables.
+	uint64_t n;
+	uint64_t step;
+
+	if (distance == 0 || rate == 0) {
+		return;
+	}
+	n = distance / rate + (distance % rate != 0 ? 1 : 0);
+	step = distance / n;
+	append(clockwise ? step : (uint64_t)0 - step, 0, n);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Makes the cycle return the antenna exactly to where it began, by
+//! taking the rounding left by its ramps and slews out of its last segment,
+//! so that a sector or flicker never drifts however long it runs.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void ScanProgram::close() {
+
+	// Declare all relevant variables.
+	uint64_t net;
+	uint32_t i;
+
+	net = 0;
+	for (i = lead; i < used; ++i) {
+		net += segments[i].advance;
+	}
+	segments[used - 1].advance -= net;
+}
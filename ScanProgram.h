@@ -0,0 +1,198 @@
+#pragma once
+
+#include "stdafx.h"
+#include <math.h>
+#include "Packet.h"
+
+// Establish the globally accessible macros.
+#define SCAN_SEGMENTS 32
+#define SCAN_HOLD 0x40000000u
+#define SCAN_SECTOR_WIDTH 90.0
+#define SCAN_SLEW_FACTOR 4
+#define SCAN_NO_RAMP UINT64_MAX
+#define ANTENNA_FIXED_6 0
+#define ANTENNA_FIXED_12 1
+#define ANTENNA_MANUAL_CW 2
+#define ANTENNA_MANUAL_CCW 3
+#define ANTENNA_STOPPED 4
+#define MODE_M_SECTOR 0
+#define MODE_M_FLICKER_1 1
+#define MODE_M_FLICKER_2 2
+#define MODE_M_NONE 3
+
+//=============================================================================
+//! @struct ScanPattern
+//!
+//! @brief The shape of the antenna's motion beyond its rate and direction,
+//! which the antenna and mode M fields of the sample select between. A
+//! zeroed pattern scans a sector of SCAN_SECTOR_WIDTH from north, reverses
+//! at once, flicks between sectors half a turn apart at SCAN_SLEW_FACTOR
+//! times the scan rate, and never stops.
+//=============================================================================
+struct ScanPattern {
+
+	//! The counter-clockwise edge of the sector, in degrees.
+	double sector_start;
+
+	//! The width of the sector, in degrees, or zero for SCAN_SECTOR_WIDTH.
+	double sector_width;
+
+	//! The bearing of the second flicker sector from the first, in degrees,
+	//! or zero for half a turn.
+	double flicker_offset;
+
+	//! The rate at which a flicker moves between sweeps, in degrees per
+	//! second, or zero for SCAN_SLEW_FACTOR times the scan rate.
+	double slew_rate;
+
+	//! The time taken by each change of rate, whether reversing, stopping,
+	//! starting, or following a new rotation rate, in seconds, or zero to
+	//! change at once.
+	double ramp_s;
+
+	//! The time the antenna runs between stops, in seconds, or zero never to
+	//! stop.
+	double run_s;
+
+	//! The time the antenna stays stopped, in seconds.
+	double stop_s;
+};
+
+//=============================================================================
+//! @struct ScanSegment
+//!
+//! @brief A run of packets over which the antenna phase follows a quadratic
+//! in the packet index, such that the i'th packet, counting from one, lies
+//! at i * step + accel * i * (i - 1) / 2 from the start of the segment. The
+//! arithmetic is modulo 2^64, so that a negative step or accel turns the
+//! antenna counter-clockwise.
+//=============================================================================
+struct ScanSegment {
+
+	//! The phase added for the first packet.
+	uint64_t step;
+
+	//! The change of the step from each packet to the next.
+	uint64_t accel;
+
+	//! The phase from the start of the segment to the start of the next.
+	uint64_t advance;
+
+	//! The number of packets in the segment.
+	uint32_t length;
+};
+
+//=============================================================================
+//! @class ScanProgram
+//!
+//! @brief A scan pattern compiled into a short program of segments, which
+//! runs a lead-in once and then repeats a cycle. Constant rotation either
+//! way, a stopped antenna, rate ramps, stops and starts, sector scans and
+//! flickers all compile into the same form, so that evaluating any of them
+//! is the same few integer operations per packet, with no branch on the
+//! mode and no trigonometry. The only branch is at the end of each segment.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class ScanProgram {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn ScanProgram
+	//!
+	//! @brief Constructs a ScanProgram instance.
+	//-------------------------------------------------------------------------
+	ScanProgram();
+
+	//-------------------------------------------------------------------------
+	//! @fn compile
+	//!
+	//! @brief Compiles the pattern selected by the sample's mode fields.
+	//-------------------------------------------------------------------------
+	bool compile(Packet smpl, const ScanPattern& pattern, double clkrate,
+		uint64_t from_step = SCAN_NO_RAMP);
+
+	//-------------------------------------------------------------------------
+	//! @fn advance
+	//!
+	//! @brief Advances the antenna by several transmission periods, writing
+	//! the position reached at each.
+	//-------------------------------------------------------------------------
+	void advance(uint32_t* positions, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn getPhase
+	//!
+	//! @brief Returns the antenna phase of the most recently advanced packet.
+	//-------------------------------------------------------------------------
+	uint64_t getPhase();
+
+	//-------------------------------------------------------------------------
+	//! @fn getStep
+	//!
+	//! @brief Returns the phase the next packet will add.
+	//-------------------------------------------------------------------------
+	uint64_t getStep();
+
+	//-------------------------------------------------------------------------
+	//! @fn angle
+	//!
+	//! @brief Converts an angle into a phase.
+	//-------------------------------------------------------------------------
+	static uint64_t angle(double degrees);
+
+	//! The number of segments in use, of which the first lead are run once.
+	uint32_t used;
+
+	//! The number of segments in the lead-in.
+	uint32_t lead;
+
+	//! A flag signifying that the last pattern compiled needed more than 
+	//! SCAN_SEGMENTS segments, and was replaced by a constant rotation.
+	bool rejected;
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn append
+	//!
+	//! @brief Adds a segment to the program, split as its length requires.
+	//-------------------------------------------------------------------------
+	void append(uint64_t step, uint64_t accel, uint64_t length);
+
+	//-------------------------------------------------------------------------
+	//! @fn rotate
+	//!
+	//! @brief Replaces the program with a constant rotation.
+	//-------------------------------------------------------------------------
+	bool rotate(int64_t step, uint64_t own_step);
+
+	//-------------------------------------------------------------------------
+	//! @fn slew
+	//!
+	//! @brief Adds a segment moving the antenna a given distance at no more
+	//! than a given rate.
+	//-------------------------------------------------------------------------
+	void slew(uint64_t distance, bool clockwise, uint64_t rate);
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Makes the cycle return the antenna to where it began.
+	//-------------------------------------------------------------------------
+	void close();
+
+	//! The segments of the lead-in and then the cycle.
+	ScanSegment segments[SCAN_SEGMENTS];
+
+	//! The index of the segment being run.
+	uint32_t index;
+
+	//! The number of packets of the segment already run.
+	uint32_t offset;
+
+	//! The phase at the start of the segment being run.
+	uint64_t base;
+
+	//! The antenna phase of the most recently advanced packet.
+	uint64_t phase;
+};
@@ -0,0 +1,72 @@
+#include "SharedBackend.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a SharedBackend instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+SharedBackend::SharedBackend() : destination(NULL), ring() {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a SharedBackend instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+SharedBackend::~SharedBackend() {
+	close();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Creates the shared ring named after the first destination, holding
+//! SHARED_SLOTS packets. Packets are never packed in the ring, nor sent over
+//! the socket, so the aggregation and the other destinations are ignored.
+//! @param sock The socket of the transmitter, which is not used.
+//! @param destinations The destinations, the first of which names the ring.
+//! @param destination_count The number of destinations.
+//! @param batch_size The greatest number of packets sent in a single batch.
+//! @param aggregate The greatest number of packets in each datagram.
+//! @param skew The histogram of the send skew between destinations, which 
+//! is not measured.
+//! @return A zero value, if successful, or the system error otherwise.
+//-----------------------------------------------------------------------------
+int SharedBackend::open(SOCKET sock, Destination* destinations, uint32_t 
+	destination_count, uint32_t batch_size, uint32_t aggregate, 
+	LatencyHistogram* skew) {
+
+	// Declare all relevant variables.
+	wchar_t name[SHARED_NAME_LEN];
+
+	destination = &destinations[0];
+	SharedRing::name(destination->address, name, SHARED_NAME_LEN);
+	return ring.create(name, batch_size > SHARED_SLOTS ? batch_size : 
+		SHARED_SLOTS);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Publishes packets from the front of the ring to the shared ring,
+//! counting them as sent to the first destination.
+//! @param ring The ring holding the packets.
+//! @param count The number of packets to publish.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SharedBackend::send(PacketRing* ring, uint32_t count) {
+	this->ring.publish(ring, count);
+	destination->sent.fetch_add(count, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Closes the shared ring, which remains for any consumer still 
+//! attached.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SharedBackend::close() {
+	ring.close();
+	destination = NULL;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the kind of the backend.
+//! @return BACKEND_SHARED.
+//-----------------------------------------------------------------------------
+uint32_t SharedBackend::kind() {
+	return BACKEND_SHARED;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "stdafx.h"
+#include "TransmitBackend.h"
+#include "SharedRing.h"
+
+//=============================================================================
+//! @class SharedBackend
+//!
+//! @brief Hands the packets to consumers on the same machine through a 
+//! shared-memory ring rather than the network. The ring is named after the
+//! first destination, from which any number of local consumers read the 
+//! packets in place, so the remaining destinations are not needed. Each 
+//! batch costs one copy into the ring and, only when a consumer sleeps, one
+//! call to wake it.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class SharedBackend : public TransmitBackend {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn SharedBackend
+	//!
+	//! @brief Constructs a SharedBackend instance.
+	//-------------------------------------------------------------------------
+	SharedBackend();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~SharedBackend
+	//!
+	//! @brief Destroys a SharedBackend instance.
+	//-------------------------------------------------------------------------
+	~SharedBackend();
+
+	//-------------------------------------------------------------------------
+	//! @fn open
+	//!
+	//! @brief Creates the shared ring named after the first destination.
+	//-------------------------------------------------------------------------
+	int open(SOCKET sock, Destination* destinations, uint32_t 
+		destination_count, uint32_t batch_size, uint32_t aggregate, 
+		LatencyHistogram* skew);
+
+	//-------------------------------------------------------------------------
+	//! @fn send
+	//!
+	//! @brief Publishes packets from the front of the ring.
+	//-------------------------------------------------------------------------
+	void send(PacketRing* ring, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Closes the shared ring.
+	//-------------------------------------------------------------------------
+	void close();
+
+	//-------------------------------------------------------------------------
+	//! @fn kind
+	//!
+	//! @brief Returns the kind of the backend.
+	//-------------------------------------------------------------------------
+	uint32_t kind();
+private:
+
+	//! The destination after which the ring is named, owned by the caller.
+	Destination* destination;
+
+	//! The shared ring into which the packets are published.
+	SharedRing ring;
+};
@@ -0,0 +1,433 @@
+#include "SharedRing.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a SharedRing instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+SharedRing::SharedRing() : dropped(0), mapping(NULL), producer(NULL), 
+	header(NULL), slots(NULL), mask(0), events(), consumer(-1), next(0) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a SharedRing instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+SharedRing::~SharedRing() {
+
+	// Close the ring, should it still be mapped.
+	if (header != NULL) {
+		close();
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Creates the named ring as its producer, along with the wake event of
+//! every cursor. The producer first creates a mutex named after the ring,
+//! which it holds until it closes, and refuses the ring should the mutex
+//! already exist, since another producer then writes it. Should a ring of the
+//! same layout still be held open by its consumers, the producer continues
+//! from its head, so that the consumers carry on across a restart of the
+//! generator. A surviving ring of another layout is refused, since its view
+//! may be smaller than this one and its consumers still read it.
+//! @param name The name of the shared memory, such as one built by name.
+//! @param slots The number of slots, rounded up to a power of two.
+//! @return A zero value, if successful, ERROR_BUSY should another producer 
+//! hold the ring, ERROR_BAD_FORMAT should a ring of another layout already 
+//! exist under the name, or the system error otherwise.
+//-----------------------------------------------------------------------------
+int SharedRing::create(const wchar_t* name, uint32_t slots) {
+
+	// Declare all relevant variables.
+	ULARGE_INTEGER bytes;
+	wchar_t wake[SHARED_NAME_LEN + 16];
+	uint32_t count;
+	bool existed;
+	uint32_t i;
+	int err;
+
+	// Shut out any other producer. The mutex lives while a producer holds
+	// it, and vanishes with the process of one which ends without closing.
+	swprintf_s(wake, SHARED_NAME_LEN + 16, L"%ls.producer", name);
+	producer = CreateMutexW(NULL, FALSE, wake);
+	if (producer == NULL) {
+		return (int)GetLastError();
+	}
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		CloseHandle(producer);
+		producer = NULL;
+		return ERROR_BUSY;
+	}
+
+	// Round the slot count up to a power of two, so that the free-running
+	// indices may be wrapped with a mask.
+	count = 1;
+	while (count < slots) {
+		count <<= 1;
+	}
+
+	// Create the shared memory, backed by the paging file, and map it whole.
+	bytes.QuadPart = sizeof(SharedHeader) + (uint64_t)count * PACKET_BYTES;
+	mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+		bytes.HighPart, bytes.LowPart, name);
+	existed = GetLastError() == ERROR_ALREADY_EXISTS;
+	if (mapping != NULL) {
+		header = (SharedHeader*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0,
+			0, 0);
+	}
+	if (header == NULL) {
+		err = (int)GetLastError();
+		close();
+		return err;
+	}
+
+	// Continue a ring surviving from an earlier producer with the same 
+	// layout, leaving any other untouched.
+	if (existed && (memcmp(header->magic, SHARED_MAGIC, sizeof(
+		header->magic)) != 0 || header->version != SHARED_VERSION || 
+		header->slot_bytes != PACKET_BYTES || header->slots != count || 
+		header->consumers != SHARED_CONSUMERS)) {
+		close();
+		return ERROR_BAD_FORMAT;
+	}
+
+	// Write the layout of a new ring.
+	if (!existed) {
+		header->version = SHARED_VERSION;
+		header->slot_bytes = PACKET_BYTES;
+		header->slots = count;
+		header->consumers = SHARED_CONSUMERS;
+		header->head.store(0, std::memory_order_relaxed);
+		header->writing.store(0, std::memory_order_relaxed);
+		for (i = 0; i < SHARED_CONSUMERS; ++i) {
+			header->cursors[i].cursor.store(0, std::memory_order_relaxed);
+			header->cursors[i].attached.store(0, std::memory_order_relaxed);
+			header->cursors[i].waiting.store(0, std::memory_order_relaxed);
+			header->cursors[i].pid.store(0, std::memory_order_relaxed);
+		}
+
+		// Write the magic last, so that no consumer attaches to a partial
+		// layout.
+		std::atomic_thread_fence(std::memory_order_release);
+		memcpy(header->magic, SHARED_MAGIC, sizeof(header->magic));
+	}
+	this->slots = (uint32_t(*)[PACKET_WORDS])(header + 1);
+	mask = count - 1;
+	consumer = -1;
+
+	// Create an auto-resetting wake event for each cursor.
+	for (i = 0; i < SHARED_CONSUMERS; ++i) {
+		swprintf_s(wake, SHARED_NAME_LEN + 16, L"%ls.wake.%u", name, i);
+		events[i] = CreateEventW(NULL, FALSE, FALSE, wake);
+		if (events[i] == NULL) {
+			err = (int)GetLastError();
+			close();
+			return err;
+		}
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Attaches to the named ring as a consumer, claiming a free cursor,
+//! or, should none be free, one whose process has ended without detaching.
+//! The consumer begins at the current head, reading only what is published
+//! from then on.
+//! @param name The name of the shared memory.
+//! @return A zero value, if successful, ERROR_BAD_FORMAT should the ring not
+//! match this build, ERROR_NOT_ENOUGH_QUOTA should every cursor be held, or
+//! the system error otherwise.
+//-----------------------------------------------------------------------------
+int SharedRing::open(const wchar_t* name) {
+
+	// Declare all relevant variables.
+	wchar_t wake[SHARED_NAME_LEN + 16];
+	uint32_t expected;
+	uint32_t self;
+	int32_t i;
+	int err;
+
+	// Open and map the shared memory.
+	mapping = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, name);
+	if (mapping != NULL) {
+		header = (SharedHeader*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0,
+			0, 0);
+	}
+	if (header == NULL) {
+		err = (int)GetLastError();
+		if (mapping != NULL) {
+			CloseHandle(mapping);
+			mapping = NULL;
+		}
+		return err;
+	}
+
+	// Check the layout against this build.
+	if (memcmp(header->magic, SHARED_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != SHARED_VERSION || header->slot_bytes !=
+		PACKET_BYTES || header->consumers != SHARED_CONSUMERS) {
+		close();
+		return ERROR_BAD_FORMAT;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	slots = (uint32_t(*)[PACKET_WORDS])(header + 1);
+	mask = header->slots - 1;
+
+	// Claim the first free cursor, placing it at the head.
+	self = GetCurrentProcessId();
+	for (i = 0; i < SHARED_CONSUMERS; ++i) {
+		expected = 0;
+		if (header->cursors[i].attached.compare_exchange_strong(expected, 1)) {
+			header->cursors[i].pid.store(self, std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	// Failing that, take over the cursor of an ended process. Its identifier
+	// is swapped for this one, so that only one consumer takes it over.
+	if (i == SHARED_CONSUMERS) {
+		for (i = 0; i < SHARED_CONSUMERS; ++i) {
+			expected = header->cursors[i].pid.load(std::memory_order_relaxed);
+			if (expected != 0 && !alive(expected) && 
+				header->cursors[i].pid.compare_exchange_strong(expected, 
+				self)) {
+				break;
+			}
+		}
+	}
+	if (i == SHARED_CONSUMERS) {
+		close();
+		return ERROR_NOT_ENOUGH_QUOTA;
+	}
+	consumer = i;
+	next = header->head.load(std::memory_order_acquire);
+	header->cursors[i].waiting.store(0, std::memory_order_relaxed);
+	header->cursors[i].cursor.store(next, std::memory_order_release);
+	dropped = 0;
+
+	// Open the cursor's wake event.
+	swprintf_s(wake, SHARED_NAME_LEN + 16, L"%ls.wake.%d", name, i);
+	events[i] = OpenEventW(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, wake);
+	if (events[i] == NULL) {
+		err = (int)GetLastError();
+		close();
+		return err;
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Detaches from the ring, freeing a consumer's cursor, and unmaps it.
+//! The shared memory itself remains while any process holds it open.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SharedRing::close() {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	if (header != NULL && consumer >= 0) {
+		header->cursors[consumer].waiting.store(0, std::memory_order_relaxed);
+		header->cursors[consumer].pid.store(0, std::memory_order_relaxed);
+		header->cursors[consumer].attached.store(0,
+			std::memory_order_release);
+	}
+	for (i = 0; i < SHARED_CONSUMERS; ++i) {
+		if (events[i] != NULL) {
+			CloseHandle(events[i]);
+			events[i] = NULL;
+		}
+	}
+	if (header != NULL) {
+		UnmapViewOfFile(header);
+		header = NULL;
+	}
+	if (mapping != NULL) {
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+	if (producer != NULL) {
+		CloseHandle(producer);
+		producer = NULL;
+	}
+	slots = NULL;
+	consumer = -1;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Copies packets from the front of a transmit ring into the shared
+//! ring, overwriting the oldest slots, and wakes each consumer which flagged
+//! that it waits. The index being written is raised before the copy and the
+//! head after it, so that a consumer may tell whether the slots it read were
+//! overwritten meanwhile.
+//! @param ring The transmit ring holding the packets.
+//! @param count The number of packets to copy, no more than the slots.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SharedRing::publish(PacketRing* ring, uint32_t count) {
+
+	// Declare all relevant variables.
+	uint64_t head;
+	uint32_t i;
+
+	// Copy the packets between the two index updates.
+	head = header->head.load(std::memory_order_relaxed);
+	header->writing.store(head + count, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (i = 0; i < count; ++i) {
+		memcpy(slots[(head + i) & mask], ring->at(i), PACKET_BYTES);
+	}
+	header->head.store(head + count, std::memory_order_release);
+
+	// Wake the consumers about to sleep. The full fence orders the head
+	// before the flags, pairing with the fence in wait, so that a consumer
+	// either sees the new head or is seen to wait.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for (i = 0; i < SHARED_CONSUMERS; ++i) {
+		if (header->cursors[i].waiting.load(std::memory_order_relaxed) != 0 &&
+			header->cursors[i].waiting.exchange(0) != 0) {
+			SetEvent(events[i]);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the contiguous published slots from the consumer's cursor,
+//! for reading in place, without copying. Should the consumer have fallen a
+//! whole ring behind, its cursor first moves to half a ring behind the head,
+//! and the packets skipped are counted as dropped.
+//! @param want The greatest number of slots wanted.
+//! @param granted Receives the number of slots returned, which stop at the
+//! end of the slot array.
+//! @return The first slot, or NULL if nothing is published beyond the cursor.
+//-----------------------------------------------------------------------------
+const uint32_t* SharedRing::acquire(uint32_t want, uint32_t* granted) {
+
+	// Declare all relevant variables.
+	uint64_t head;
+	uint64_t avail;
+	uint64_t run;
+
+	head = header->head.load(std::memory_order_acquire);
+	if (head - next > mask + 1) {
+		dropped += head - (mask + 1) / 2 - next;
+		next = head - (mask + 1) / 2;
+	}
+	avail = head - next;
+	run = mask + 1 - (next & mask);
+	avail = avail < run ? avail : run;
+	avail = avail < want ? avail : want;
+	*granted = (uint32_t)avail;
+	return avail > 0 ? slots[next & mask] : NULL;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Advances the consumer's cursor past slots it has read, and checks
+//! that the producer did not overwrite them while they were read.
+//! @param count The number of slots read, no more than were granted.
+//! @return A true value, if the slots read were intact, false if they were
+//! overwritten, in which case they are counted as dropped and should be
+//! discarded.
+//-----------------------------------------------------------------------------
+bool SharedRing::release(uint32_t count) {
+
+	// Declare all relevant variables.
+	bool intact;
+
+	// The oldest slot read is overwritten once the producer writes a whole
+	// ring beyond it.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	intact = header->writing.load(std::memory_order_relaxed) <= next + mask +
+		1;
+	next += count;
+	header->cursors[consumer].cursor.store(next, std::memory_order_release);
+	if (!intact) {
+		dropped += count;
+	}
+	return intact;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Sleeps until a slot is published beyond the consumer's cursor. The
+//! consumer flags that it waits and checks the head once more before
+//! sleeping, so that the producer signals only consumers which sleep, and
+//! none misses a publication.
+//! @param timeout_ms The longest time to sleep, in milliseconds.
+//! @return A true value, if a slot is published beyond the cursor, false if
+//! the wait timed out.
+//-----------------------------------------------------------------------------
+bool SharedRing::wait(uint32_t timeout_ms) {
+
+	// Declare all relevant variables.
+	SharedCursor* own;
+
+	own = &header->cursors[consumer];
+	if (header->head.load(std::memory_order_acquire) != next) {
+		return true;
+	}
+	own->waiting.store(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (header->head.load(std::memory_order_acquire) != next) {
+		own->waiting.store(0, std::memory_order_relaxed);
+		return true;
+	}
+	WaitForSingleObject(events[consumer], timeout_ms);
+	own->waiting.store(0, std::memory_order_relaxed);
+	return header->head.load(std::memory_order_acquire) != next;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the index of the next slot the consumer will read.
+//! @return The index, counting from the creation of the ring.
+//-----------------------------------------------------------------------------
+uint64_t SharedRing::position() {
+	return next;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of slots published since the ring was created.
+//! @return The head index.
+//-----------------------------------------------------------------------------
+uint64_t SharedRing::published() {
+	return header->head.load(std::memory_order_acquire);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Builds the name of the ring standing in for a destination, from its
+//! address and port, within the session namespace.
+//! @param address The destination.
+//! @param out Receives the name.
+//! @param len The capacity of out, in characters, at least SHARED_NAME_LEN.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SharedRing::name(const sockaddr_in& address, wchar_t* out, size_t len) {
+
+	// Declare all relevant variables.
+	const unsigned char* octets;
+
+	octets = (const unsigned char*)&address.sin_addr;
+	swprintf_s(out, len, L"Local\\eGRIM.%u.%u.%u.%u.%u", octets[0],
+		octets[1], octets[2], octets[3], ntohs(address.sin_port));
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns whether a process is still running. A process which cannot
+//! be opened for want of access is taken to run, and one whose identifier has
+//! been reused is mistaken for running, so that a cursor is only ever 
+//! reclaimed late, never early.
+//! @param pid The identifier of the process.
+//! @return A true value, if the process runs, false if it has ended.
+//-----------------------------------------------------------------------------
+bool SharedRing::alive(uint32_t pid) {
+
+	// Declare all relevant variables.
+	HANDLE process;
+	bool running;
+
+	process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+	if (process == NULL) {
+		return GetLastError() == ERROR_ACCESS_DENIED;
+	}
+	running = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+	CloseHandle(process);
+	return running;
+}
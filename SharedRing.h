@@ -0,0 +1,230 @@
+#pragma once
+
+#include "stdafx.h"
+#include <WS2tcpip.h>
+#include <winsock2.h>
+#include <string.h>
+#include <atomic>
+#include "PacketRing.h"
+
+// Establish the globally accessible macros.
+#define SHARED_MAGIC "eGRIMSHM"
+#define SHARED_VERSION 2
+#define SHARED_SLOTS (1u << 16)
+#define SHARED_CONSUMERS 16
+#define SHARED_NAME_LEN 64
+
+//=============================================================================
+//! @struct SharedCursor
+//!
+//! @brief The read position of one consumer of a shared ring, on a cache line
+//! of its own, so that consumers never contend with each other or with the
+//! producer.
+//=============================================================================
+struct SharedCursor {
+
+	//! The index of the next slot the consumer will read.
+	std::atomic<uint64_t> cursor;
+
+	//! A flag signifying that a consumer holds this cursor.
+	std::atomic<uint32_t> attached;
+
+	//! A flag signifying that the consumer is about to wait on its event.
+	std::atomic<uint32_t> waiting;
+
+	//! The identifier of the consumer's process, by which a cursor left held
+	//! by a process that has since ended is reclaimed, or zero while the 
+	//! cursor is free or being claimed.
+	std::atomic<uint32_t> pid;
+
+	//! Padding to fill the cache line.
+	char pad[CACHE_LINE - sizeof(std::atomic<uint64_t>) - 3 * sizeof(
+		std::atomic<uint32_t>)];
+};
+
+//=============================================================================
+//! @struct SharedHeader
+//!
+//! @brief The header opening a shared ring, which the slots follow. The
+//! layout fields are written once by the producer, and checked by each
+//! consumer as it attaches.
+//=============================================================================
+struct SharedHeader {
+
+	//! The characters identifying a shared ring, SHARED_MAGIC.
+	char magic[8];
+
+	//! The version of the ring layout.
+	uint32_t version;
+
+	//! The size of each slot, in bytes.
+	uint32_t slot_bytes;
+
+	//! The number of slots, a power of two.
+	uint32_t slots;
+
+	//! The number of consumer cursors.
+	uint32_t consumers;
+
+	//! Padding to keep the layout fields away from the producer indices.
+	char header_pad[CACHE_LINE - 8 - 4 * sizeof(uint32_t)];
+
+	//! The index of the next slot to be published.
+	std::atomic<uint64_t> head;
+
+	//! The index up to which slots are being written, ahead of the head while
+	//! the producer copies into them.
+	std::atomic<uint64_t> writing;
+
+	//! Padding to keep the producer indices away from the cursors.
+	char head_pad[CACHE_LINE - 2 * sizeof(std::atomic<uint64_t>)];
+
+	//! The read position of each consumer.
+	SharedCursor cursors[SHARED_CONSUMERS];
+};
+
+//=============================================================================
+//! @class SharedRing
+//!
+//! @brief A ring of encoded packets in named shared memory, written by one
+//! producer and read in place by up to SHARED_CONSUMERS consumers, each in any
+//! process on the same machine. A named mutex held by the producer shuts out
+//! any other, and the cursor of a consumer whose process ended without
+//! detaching is reclaimed by the next to attach. The producer never waits upon
+//! the consumers: each keeps its own cursor, and one which falls a whole ring
+//! behind is moved forward, counting the packets it missed. A consumer reads
+//! the slots directly from the mapping, and release tells it whether the
+//! producer overwrote them while it read. A consumer with nothing to read may
+//! sleep on a named event of its own, which the producer sets only when the
+//! consumer has flagged that it waits.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class SharedRing {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn SharedRing
+	//!
+	//! @brief Constructs a SharedRing instance.
+	//-------------------------------------------------------------------------
+	SharedRing();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~SharedRing
+	//!
+	//! @brief Destroys a SharedRing instance.
+	//-------------------------------------------------------------------------
+	~SharedRing();
+
+	//-------------------------------------------------------------------------
+	//! @fn create
+	//!
+	//! @brief Creates the named ring as its producer.
+	//-------------------------------------------------------------------------
+	int create(const wchar_t* name, uint32_t slots);
+
+	//-------------------------------------------------------------------------
+	//! @fn open
+	//!
+	//! @brief Attaches to the named ring as a consumer.
+	//-------------------------------------------------------------------------
+	int open(const wchar_t* name);
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Detaches from the ring and unmaps it.
+	//-------------------------------------------------------------------------
+	void close();
+
+	//-------------------------------------------------------------------------
+	//! @fn publish
+	//!
+	//! @brief Copies packets from the front of a transmit ring into the
+	//! shared ring and wakes any waiting consumer.
+	//-------------------------------------------------------------------------
+	void publish(PacketRing* ring, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn acquire
+	//!
+	//! @brief Returns the contiguous published slots from the consumer's
+	//! cursor, for reading in place.
+	//-------------------------------------------------------------------------
+	const uint32_t* acquire(uint32_t want, uint32_t* granted);
+
+	//-------------------------------------------------------------------------
+	//! @fn release
+	//!
+	//! @brief Advances the consumer's cursor past slots it has read.
+	//-------------------------------------------------------------------------
+	bool release(uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn wait
+	//!
+	//! @brief Sleeps until a slot is published beyond the consumer's cursor.
+	//-------------------------------------------------------------------------
+	bool wait(uint32_t timeout_ms);
+
+	//-------------------------------------------------------------------------
+	//! @fn position
+	//!
+	//! @brief Returns the index of the next slot the consumer will read.
+	//-------------------------------------------------------------------------
+	uint64_t position();
+
+	//-------------------------------------------------------------------------
+	//! @fn published
+	//!
+	//! @brief Returns the number of slots published since the ring was
+	//! created.
+	//-------------------------------------------------------------------------
+	uint64_t published();
+
+	//-------------------------------------------------------------------------
+	//! @fn name
+	//!
+	//! @brief Builds the name of the ring standing in for a destination.
+	//-------------------------------------------------------------------------
+	static void name(const sockaddr_in& address, wchar_t* out, size_t len);
+
+	//-------------------------------------------------------------------------
+	//! @fn alive
+	//!
+	//! @brief Returns whether a process is still running.
+	//-------------------------------------------------------------------------
+	static bool alive(uint32_t pid);
+
+	//! The number of packets the consumer missed, whether by falling a whole
+	//! ring behind or by having slots overwritten as it read them.
+	uint64_t dropped;
+private:
+
+	//! The handle of the shared memory.
+	HANDLE mapping;
+
+	//! The named mutex whose existence marks the ring as having a producer,
+	//! held only by the producer.
+	HANDLE producer;
+
+	//! The mapped header, which the slots follow.
+	SharedHeader* header;
+
+	//! The mapped slots, each holding the wire words of one packet.
+	uint32_t (*slots)[PACKET_WORDS];
+
+	//! A mask mapping the free-running indices onto the slot array.
+	uint64_t mask;
+
+	//! The wake event of each consumer, all held by the producer, or only
+	//! that of its own cursor by a consumer.
+	HANDLE events[SHARED_CONSUMERS];
+
+	//! The cursor held by the consumer, or -1 for the producer.
+	int32_t consumer;
+
+	//! The index of the next slot the consumer will read.
+	uint64_t next;
+};
@@ -0,0 +1,194 @@
+#include "SocketBackend.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a SocketBackend instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+SocketBackend::SocketBackend() : sock(INVALID_SOCKET), destinations(NULL),
+	destination_count(0), skew(NULL), ns_per_tick(0.0), 
+	transmit_packets(NULL), batch_elements(NULL), aggregate(1), 
+	segmented(0), burst(NULL) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a SocketBackend instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+SocketBackend::~SocketBackend() {
+	close();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Prepares the backend to send to a list of destinations. Should a 
+//! batch span several frames, segmentation offload is enabled with the frame
+//! as its segment. Otherwise, when batching single packets to a single 
+//! destination, the socket is connected to it and the TransmitPackets 
+//! extension is retrieved. Should any step fail, batches fall back to 
+//! individual sends.
+//! @param sock The socket over which the packets are sent.
+//! @param destinations The destinations to which the packets are sent.
+//! @param destination_count The number of destinations.
+//! @param batch_size The greatest number of packets sent in a single batch.
+//! @param aggregate The greatest number of packets in each datagram, from 1
+//! to FRAME_PACKETS.
+//! @param skew The histogram of the send skew between destinations, or NULL.
+//! @return A zero value, as a socket is always available.
+//-----------------------------------------------------------------------------
+int SocketBackend::open(SOCKET sock, Destination* destinations, uint32_t 
+	destination_count, uint32_t batch_size, uint32_t aggregate, 
+	LatencyHistogram* skew) {
+
+	// Declare all relevant variables.
+	GUID guid = WSAID_TRANSMITPACKETS;
+	LARGE_INTEGER freq;
+	DWORD segment;
+	uint32_t frames;
+	DWORD bytes;
+
+	this->sock = sock;
+	this->destinations = destinations;
+	this->destination_count = destination_count;
+	this->skew = skew;
+	this->aggregate = aggregate < 1 ? 1 : aggregate > FRAME_PACKETS ? 
+		FRAME_PACKETS : aggregate;
+	QueryPerformanceFrequency(&freq);
+	ns_per_tick = 1e9 / (double)freq.QuadPart;
+	burst = new char[batch_size * PACKET_BYTES]();
+
+	// Have the stack divide a batch into frames, whenever it holds several, 
+	// handing it as many whole frames at once as the offload accepts.
+	segmented = 0;
+	if (batch_size > this->aggregate) {
+		segment = this->aggregate * PACKET_BYTES;
+		frames = USO_BYTES / segment < USO_SEGMENTS ? USO_BYTES / segment : 
+			USO_SEGMENTS;
+		if (setsockopt(sock, IPPROTO_UDP, UDP_SEND_MSG_SIZE, (char*)&segment,
+			sizeof(segment)) == 0) {
+			segmented = frames * this->aggregate;
+		}
+	}
+
+	// Otherwise, batches of single packets to one destination may still go
+	// to the system in a single call.
+	if (batch_size > 1 && destination_count == 1 && this->aggregate == 1 &&
+		segmented == 0) {
+		batch_elements = new TRANSMIT_PACKETS_ELEMENT[batch_size]();
+		if (connect(sock, (SOCKADDR*)&destinations[0].address, 
+			sizeof(destinations[0].address)) == SOCKET_ERROR || WSAIoctl(sock,
+			SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid), 
+			&transmit_packets, sizeof(transmit_packets), &bytes, NULL, NULL) 
+			== SOCKET_ERROR) {
+			transmit_packets = NULL;
+		}
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Sends packets from the front of the ring. A batch of single packets
+//! goes in a single call whenever the extension is available. Otherwise each
+//! datagram, or each run of segments, is sent to every destination before 
+//! the next is sent to any, keeping the skew between destinations to a 
+//! handful of system calls. Packed datagrams are first copied out of the 
+//! ring, whose slots are contiguous only until it wraps.
+//! @param ring The ring holding the packets.
+//! @param count The number of packets to send.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SocketBackend::send(PacketRing* ring, uint32_t count) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER first;
+	LARGE_INTEGER last;
+	const char* data;
+	uint32_t unit;
+	uint32_t n;
+	uint32_t i;
+	uint32_t d;
+
+	// Hand a batch of single packets to the extension as memory elements, 
+	// each closing its own datagram.
+	if (count > 1 && transmit_packets != NULL) {
+		for (i = 0; i < count; ++i) {
+			batch_elements[i].dwElFlags = TP_ELEMENT_MEMORY | TP_ELEMENT_EOP;
+			batch_elements[i].cLength = PACKET_BYTES;
+			batch_elements[i].pBuffer = (PVOID)ring->at(i);
+		}
+		if (!transmit_packets(sock, batch_elements, count, 0, NULL, 
+			TF_USE_KERNEL_APC)) {
+			destinations[0].errors.fetch_add(count, 
+				std::memory_order_relaxed);
+		}
+		else {
+			destinations[0].sent.fetch_add(count, std::memory_order_relaxed);
+		}
+		return;
+	}
+
+	// Pack the batch contiguously, should any send carry several packets.
+	unit = segmented > 0 ? segmented : aggregate;
+	if (unit > 1) {
+		for (i = 0; i < count; ++i) {
+			memcpy(burst + i * PACKET_BYTES, ring->at(i), PACKET_BYTES);
+		}
+	}
+
+	// Send each unit to every destination, measuring the time between the 
+	// first and last sends.
+	for (i = 0; i < count; i += n) {
+		n = count - i < unit ? count - i : unit;
+		data = unit > 1 ? burst + i * PACKET_BYTES : (const char*)ring->at(i);
+		for (d = 0; d < destination_count; ++d) {
+			if (d == 0) {
+				QueryPerformanceCounter(&first);
+			}
+			else if (d == destination_count - 1) {
+				QueryPerformanceCounter(&last);
+			}
+			if (sendto(sock, data, n * PACKET_BYTES, 0, 
+				(SOCKADDR*)&destinations[d].address, 
+				sizeof(struct sockaddr_in)) < 0) {
+				destinations[d].errors.fetch_add(n, 
+					std::memory_order_relaxed);
+			}
+			else {
+				destinations[d].sent.fetch_add(n, std::memory_order_relaxed);
+			}
+		}
+		if (destination_count > 1 && skew != NULL) {
+			skew->record((uint64_t)((last.QuadPart - first.QuadPart) * 
+				ns_per_tick));
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Frees the batch elements and the packing buffer, and disables the 
+//! segmentation offload. The socket is otherwise left to its owner.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void SocketBackend::close() {
+
+	// Declare all relevant variables.
+	DWORD segment;
+
+	if (segmented > 0) {
+		segment = 0;
+		setsockopt(sock, IPPROTO_UDP, UDP_SEND_MSG_SIZE, (char*)&segment, 
+			sizeof(segment));
+		segmented = 0;
+	}
+	delete[] batch_elements;
+	batch_elements = NULL;
+	transmit_packets = NULL;
+	delete[] burst;
+	burst = NULL;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the kind of the backend.
+//! @return BACKEND_SOCKET.
+//-----------------------------------------------------------------------------
+uint32_t SocketBackend::kind() {
+	return BACKEND_SOCKET;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "stdafx.h"
+#include <WS2tcpip.h>
+#include <mswsock.h>
+#include "TransmitBackend.h"
+
+// Establish the globally accessible macros.
+#define USO_SEGMENTS 64
+#define USO_BYTES 65507
+
+// The send option for UDP segmentation offload, absent from older SDKs.
+#ifndef UDP_SEND_MSG_SIZE
+#define UDP_SEND_MSG_SIZE 2
+#endif
+
+//=============================================================================
+//! @class SocketBackend
+//!
+//! @brief Sends each packet or frame through the socket with its own call, 
+//! or, when batching, hands a whole batch to the system at once. Where UDP
+//! segmentation offload is available, a batch is copied into one buffer and
+//! sent in a single call, which the stack divides into datagrams. Otherwise,
+//! a batch of unpacked packets to one receiver goes to the TransmitPackets 
+//! extension, which sends each buffer as a separate datagram in one call.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class SocketBackend : public TransmitBackend {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn SocketBackend
+	//!
+	//! @brief Constructs a SocketBackend instance.
+	//-------------------------------------------------------------------------
+	SocketBackend();
+
+	//-------------------------------------------------------------------------
+	//! @fn ~SocketBackend
+	//!
+	//! @brief Destroys a SocketBackend instance.
+	//-------------------------------------------------------------------------
+	~SocketBackend();
+
+	//-------------------------------------------------------------------------
+	//! @fn open
+	//!
+	//! @brief Prepares the backend to send to a list of destinations.
+	//-------------------------------------------------------------------------
+	int open(SOCKET sock, Destination* destinations, uint32_t 
+		destination_count, uint32_t batch_size, uint32_t aggregate, 
+		LatencyHistogram* skew);
+
+	//-------------------------------------------------------------------------
+	//! @fn send
+	//!
+	//! @brief Sends packets from the front of the ring.
+	//-------------------------------------------------------------------------
+	void send(PacketRing* ring, uint32_t count);
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Frees the batch elements and the packing buffer.
+	//-------------------------------------------------------------------------
+	void close();
+
+	//-------------------------------------------------------------------------
+	//! @fn kind
+	//!
+	//! @brief Returns the kind of the backend.
+	//-------------------------------------------------------------------------
+	uint32_t kind();
+private:
+
+	//! The socket over which the packets are sent, owned by the caller.
+	SOCKET sock;
+
+	//! The destinations to which the packets are sent, owned by the caller.
+	Destination* destinations;
+
+	//! The number of destinations.
+	uint32_t destination_count;
+
+	//! The histogram of the time between the sends of a packet to the first 
+	//! and last destinations, in nanoseconds, or NULL if it is not measured.
+	LatencyHistogram* skew;
+
+	//! The number of nanoseconds per performance counter tick.
+	double ns_per_tick;
+
+	//! The extension function sending an array of datagrams in one call, or
+	//! NULL if it is unavailable or there are several destinations.
+	LPFN_TRANSMITPACKETS transmit_packets;
+
+	//! The preallocated elements describing a batch to transmit_packets.
+	TRANSMIT_PACKETS_ELEMENT* batch_elements;
+
+	//! The greatest number of packets packed into each datagram.
+	uint32_t aggregate;
+
+	//! The greatest number of packets handed to the socket in one call when
+	//! segmentation offload is enabled, or zero if it is not.
+	uint32_t segmented;
+
+	//! The batch packed contiguously, for sending in frames or segments.
+	char* burst;
+};
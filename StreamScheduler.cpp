@@ -0,0 +1,651 @@
+#include "StreamScheduler.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a StreamScheduler instance.
+//! @param shards The number of shard threads, between one and 
+//! STREAM_SHARDS_MAX.
+//! @param cores A mask of the processors to which the shards are pinned, each
+//! shard taking the next set bit in turn, or zero to leave them unpinned.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+StreamScheduler::StreamScheduler(uint32_t shards, uint64_t cores) : 
+	active_process(false), streams(NULL), addresses(NULL), stream_sent(NULL),
+	stream_errors(NULL), stream_count(0), shard_list(NULL), shard_count(0), 
+	moved(0), clock(), timestamp(), ns_per_tick(0) {
+
+	// Declare all relevant variables.
+	uint32_t bit;
+	uint32_t i;
+
+	// Allocate the state of every stream, and the heap and mailbox of every
+	// shard at the full stream count, up front, so that neither the shard 
+	// threads nor a moving stream touch the heap.
+	shard_count = shards < 1 ? 1 : shards > STREAM_SHARDS_MAX ? 
+		STREAM_SHARDS_MAX : shards;
+	streams = new StreamState[STREAM_MAX]();
+	addresses = new sockaddr_in[STREAM_MAX]();
+	stream_sent = new std::atomic<uint64_t>[STREAM_MAX]();
+	stream_errors = new std::atomic<uint64_t>[STREAM_MAX]();
+	shard_list = new StreamShard[shard_count];
+	bit = 0;
+	for (i = 0; i < shard_count; ++i) {
+		shard_list[i].heap = new uint32_t[STREAM_MAX]();
+		shard_list[i].inbox = new uint32_t[STREAM_MAX]();
+		shard_list[i].owned = 0;
+		shard_list[i].sock = INVALID_SOCKET;
+		shard_list[i].thread = NULL;
+		shard_list[i].behind = 0;
+		shard_list[i].steal_to = -1;
+		shard_list[i].steal_from = -1;
+		shard_list[i].settled = 0;
+		shard_list[i].inbox_len = 0;
+		shard_list[i].pacer.setClock(&clock);
+
+		// Take the next processor of the mask, wrapping around it.
+		shard_list[i].affinity = 0;
+		if (cores != 0) {
+			while (((cores >> bit) & 1) == 0) {
+				bit = (bit + 1) & 63;
+			}
+			shard_list[i].affinity = (uint64_t)1 << bit;
+			bit = (bit + 1) & 63;
+		}
+	}
+	ns_per_tick = 1e9 / clock.frequency();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a StreamScheduler instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+StreamScheduler::~StreamScheduler() {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	// Finish the threads, should they still be running, and free the streams
+	// and shards.
+	if (active_process) {
+		uninit();
+	}
+	for (i = 0; i < shard_count; ++i) {
+		delete[] shard_list[i].heap;
+		delete[] shard_list[i].inbox;
+	}
+	delete[] shard_list;
+	delete[] streams;
+	delete[] addresses;
+	delete[] stream_sent;
+	delete[] stream_errors;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Adds a stream, which must precede init.
+//! @param smpl The sample whose constant fields every packet of the stream
+//! carries, such as its system ID.
+//! @param addr The receiver address of the stream.
+//! @param port The receiver port of the stream.
+//! @param packet_rate The delay period between packet transmissions.
+//! @param rotate_start The initial angle of the antenna.
+//! @param rotate_rate The angle of antenna rotation for a duration of one 
+//! second.
+//! @return The index of the stream, or -1 should the streams be full, the 
+//! threads be running, the address be invalid, or the period not advance 
+//! the deadline. Unlike the generator, the scheduler has no unpaced mode, 
+//! so a period of zero is refused.
+//-----------------------------------------------------------------------------
+int StreamScheduler::add(Packet smpl, const char* addr, int port, double 
+	packet_rate, double rotate_start, double rotate_rate) {
+
+	// Declare all relevant variables.
+	StreamState* state;
+	sockaddr_in* address;
+	double ticks;
+	uint32_t i;
+
+	// Refuse a period too short to move the deadline by a fractional tick,
+	// on which the shard would release the stream forever.
+	if (active_process || stream_count == STREAM_MAX || !(packet_rate * 
+		clock.frequency() * 4294967296.0 >= 1.0)) {
+		return -1;
+	}
+	state = &streams[stream_count];
+	address = &addresses[stream_count];
+
+	// Resolve the destination.
+	memset((char*)address, 0, sizeof(*address));
+	address->sin_family = AF_INET;
+	address->sin_port = htons(port);
+	if (inet_pton(AF_INET, addr, &address->sin_addr.s_addr) != 1) {
+		return -1;
+	}
+
+	// Take the rotation as a phase accumulator, exactly as a single 
+	// generator would advance it.
+	smpl.setAntPos(rotate_start);
+	smpl.setAntRate(rotate_rate, packet_rate);
+	state->phase = smpl.getAntPhase();
+	state->step = smpl.getAntStep();
+	state->number = 0;
+
+	// Encode the sample once, and clear the fields set at each release.
+	smpl.convert(state->words);
+	for (i = 0; i < PACKET_WORDS; ++i) {
+		state->words[i] = PacketLayout::fromWire(state->words[i]);
+	}
+	PacketLayout::clear<FIELD_PACKET_NUMBER>(state->words);
+	PacketLayout::clear<FIELD_IRIG_TIME>(state->words);
+	PacketLayout::clear<FIELD_ANTENNA_POSITION>(state->words);
+
+	// Split the period into whole and 32-bit fractional ticks, as the Pacer
+	// does, so that the deadlines accumulate exactly.
+	ticks = packet_rate * clock.frequency();
+	state->period_ticks = (int64_t)ticks;
+	state->period_frac = (uint32_t)((ticks - state->period_ticks) * 
+		4294967296.0);
+	stream_sent[stream_count] = 0;
+	stream_errors[stream_count] = 0;
+	return (int)stream_count++;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Opens the sockets and starts the shard threads. The streams are 
+//! split into contiguous runs, one per shard, and the first deadline of each
+//! stream is offset by its share of its own period, so that streams of equal
+//! rate do not fall due together.
+//! @return A zero value, if successful, or the socket error otherwise.
+//-----------------------------------------------------------------------------
+int StreamScheduler::init() {
+
+	// Declare all relevant variables.
+	WSADATA wsadata;
+	StreamShard* shard;
+	int64_t origin;
+	double offset;
+	uint32_t i;
+	int err;
+
+	// Establish a socket for each shard.
+	err = WSAStartup(MAKEWORD(2, 2), &wsadata);
+	if (err != NO_ERROR) {
+		return err;
+	}
+	for (i = 0; i < shard_count; ++i) {
+		shard_list[i].sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (shard_list[i].sock == INVALID_SOCKET) {
+			err = WSAGetLastError();
+			while (i > 0) {
+				closesocket(shard_list[--i].sock);
+				shard_list[i].sock = INVALID_SOCKET;
+			}
+			WSACleanup();
+			return err;
+		}
+	}
+
+	// Anchor the timestamps, and spread the first deadlines across one 
+	// period from the present. The offsets increase with the index, so the
+	// order of each contiguous run is already a valid heap.
+	timestamp.anchor(clock);
+	origin = clock.now();
+	for (i = 0; i < shard_count; ++i) {
+		shard_list[i].owned = 0;
+	}
+	for (i = 0; i < stream_count; ++i) {
+		offset = ((double)streams[i].period_ticks + streams[i].period_frac / 
+			4294967296.0) * i / stream_count;
+		streams[i].deadline = origin + (int64_t)offset;
+		streams[i].deadline_frac = (uint32_t)((offset - (int64_t)offset) * 
+			4294967296.0);
+		shard = &shard_list[(uint64_t)i * shard_count / stream_count];
+		shard->heap[shard->owned] = i;
+		shard->owned = shard->owned + 1;
+	}
+
+	// Start each shard thread, pinned to its core.
+	active_process = true;
+	for (i = 0; i < shard_count; ++i) {
+		shard_list[i].thread = new std::thread(&StreamScheduler::schedule, 
+			this, i);
+		if (shard_list[i].affinity != 0) {
+			SetThreadAffinityMask(shard_list[i].thread->native_handle(), 
+				(DWORD_PTR)shard_list[i].affinity);
+		}
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Finishes the shard threads and closes the sockets.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void StreamScheduler::uninit() {
+
+	// Declare all relevant variables.
+	uint32_t i;
+
+	// Toggle the active process flag, and join the threads, which observe it
+	// within one poll interval.
+	active_process = false;
+	for (i = 0; i < shard_count; ++i) {
+		shard_list[i].thread->join();
+		delete shard_list[i].thread;
+		shard_list[i].thread = NULL;
+		closesocket(shard_list[i].sock);
+		shard_list[i].sock = INVALID_SOCKET;
+	}
+
+	// Perform the socket cleanup operations.
+	WSACleanup();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Releases each stream of a shard at its deadlines. The thread waits
+//! for the earliest deadline at the top of its heap, reads the counter once,
+//! and releases every stream due by that reading, so that a burst of 
+//! coincident deadlines costs a single wait. Between waits, it adopts any 
+//! stream handed to it, answers any request for one of its own, and, should
+//! it have slack, asks the shard furthest behind for a stream.
+//! @param index The index of the shard.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void StreamScheduler::schedule(uint32_t index) {
+
+	// Declare all relevant variables.
+	StreamShard* shard;
+	int64_t poll;
+	int64_t slack;
+	int64_t target;
+	int64_t current;
+	int64_t late;
+	int64_t average;
+	uint32_t irig_ms;
+
+	// Raise the timer resolution, and wake at least once per poll interval
+	// to observe the active process flag and the other shards.
+	shard = &shard_list[index];
+	shard->pacer.start(0);
+	poll = clock.frequency() * STREAM_POLL_MS / 1000;
+	slack = clock.frequency() * STREAM_SLACK_US / 1000000;
+	average = 0;
+	while (active_process) {
+
+		// Exchange streams with the other shards.
+		adopt(index);
+		handOff(index);
+		current = shard->pacer.now();
+		if (shard->owned == 0 || streams[shard->heap[0]].deadline - current >
+			slack) {
+			steal(index);
+		}
+		if (shard->owned == 0) {
+			shard->pacer.until(current + poll);
+			continue;
+		}
+
+		// Wait for the earliest deadline.
+		target = streams[shard->heap[0]].deadline;
+		if (target - current > poll) {
+			shard->pacer.until(current + poll);
+			continue;
+		}
+		current = shard->pacer.until(target);
+
+		// Release every stream which has fallen due, each advancing its own
+		// deadline and sinking to its place in the heap, and publish the 
+		// moving average of their lateness.
+		irig_ms = timestamp.irig(current);
+		while (streams[shard->heap[0]].deadline <= current) {
+			late = release(shard, shard->heap[0], current, irig_ms);
+			average += (late - average) / 16;
+			siftDown(shard, 0);
+		}
+		shard->behind.store(average, std::memory_order_relaxed);
+	}
+	shard->pacer.stop();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Encodes and sends the next packet of a stream, and advances its 
+//! deadline by exactly one period.
+//! @param owner The shard owning the stream.
+//! @param stream The index of the stream.
+//! @param current The counter reading at the release.
+//! @param irig_ms The IRIG time of the release.
+//! @return The lateness of the packet, in nanoseconds.
+//-----------------------------------------------------------------------------
+int64_t StreamScheduler::release(StreamShard* owner, uint32_t stream, 
+	int64_t current, uint32_t irig_ms) {
+
+	// Declare all relevant variables.
+	StreamState* state;
+	uint32_t words[PACKET_WORDS];
+	uint32_t frac;
+	int64_t late;
+
+	// Advance the antenna, and fill the changing fields into the constant
+	// words.
+	state = &streams[stream];
+	state->phase += state->step;
+	memcpy(words, state->words, PACKET_BYTES);
+	PacketLayout::set<FIELD_PACKET_NUMBER>(words, state->number);
+	PacketLayout::set<FIELD_IRIG_TIME>(words, irig_ms);
+	PacketLayout::set<FIELD_ANTENNA_POSITION>(words, (uint32_t)(state->phase
+		>> PHASE_SHIFT));
+	PacketLayout::toWire(words, PACKET_WORDS);
+	state->number = (state->number + 1) & PACKET_NUMBER_MASK;
+
+	// Send the packet to the stream's destination, counting it as sent or
+	// failed. Only the owning shard writes the counts, so neither needs a 
+	// locked increment.
+	if (sendto(owner->sock, (const char*)words, PACKET_BYTES, 0, 
+		(SOCKADDR*)&addresses[stream], sizeof(struct sockaddr_in)) < 0) {
+		stream_errors[stream].store(stream_errors[stream].load(
+			std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	else {
+		stream_sent[stream].store(stream_sent[stream].load(
+			std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	// Record the lateness, and step the deadline forward, carrying the 
+	// fractional overflow into the whole ticks.
+	late = (int64_t)((current - state->deadline) * ns_per_tick);
+	owner->late_ns.record((uint64_t)late);
+	frac = state->deadline_frac + state->period_frac;
+	state->deadline += state->period_ticks + (frac < state->deadline_frac ? 
+		1 : 0);
+	state->deadline_frac = frac;
+	return late;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Asks the shard furthest behind for one of its streams, unless a 
+//! request is already outstanding. Only a shard whose average lateness 
+//! exceeds that of the asking shard by STREAM_BEHIND_NS, and which owns more
+//! than one stream, is asked, and neither may still be settling from a move,
+//! so that the stream moves only for a clear gain.
+//! @param index The index of the asking shard.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void StreamScheduler::steal(uint32_t index) {
+
+	// Declare all relevant variables.
+	StreamShard* shard;
+	int64_t current;
+	int64_t worst;
+	int64_t behind;
+	int32_t victim;
+	int32_t expected;
+	uint32_t i;
+
+	// An outstanding request lapses once the other shard has answered it.
+	shard = &shard_list[index];
+	if (shard->steal_from >= 0) {
+		if (shard_list[shard->steal_from].steal_to.load(
+			std::memory_order_acquire) == (int32_t)index) {
+			return;
+		}
+		shard->steal_from = -1;
+	}
+
+	// Find the shard furthest behind.
+	current = clock.now();
+	if (current < shard->settled.load(std::memory_order_relaxed)) {
+		return;
+	}
+	worst = shard->behind.load(std::memory_order_relaxed) + STREAM_BEHIND_NS;
+	victim = -1;
+	for (i = 0; i < shard_count; ++i) {
+		behind = shard_list[i].behind.load(std::memory_order_relaxed);
+		if (i != index && behind > worst && shard_list[i].owned > 1 && 
+			current >= shard_list[i].settled.load(std::memory_order_relaxed)) {
+			worst = behind;
+			victim = (int32_t)i;
+		}
+	}
+
+	// Post the request, unless another shard has asked first.
+	expected = -1;
+	if (victim >= 0 && shard_list[victim].steal_to.compare_exchange_strong(
+		expected, (int32_t)index, std::memory_order_acq_rel)) {
+		shard->steal_from = victim;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Answers a request for one of a shard's streams, handing over the 
+//! stream at the bottom of the heap, which may be removed without disturbing
+//! the order of the rest. The stream keeps its deadline, phase and sequence,
+//! so that it continues without a gap on the other shard. The shard then 
+//! settles for STREAM_SETTLE_MS.
+//! @param index The index of the asked shard.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void StreamScheduler::handOff(uint32_t index) {
+
+	// Declare all relevant variables.
+	StreamShard* shard;
+	StreamShard* thief;
+	int32_t to;
+	uint32_t stream;
+
+	shard = &shard_list[index];
+	to = shard->steal_to.load(std::memory_order_acquire);
+	if (to < 0) {
+		return;
+	}
+
+	// Move the stream into the other shard's mailbox. The lock orders every
+	// write this shard made to the stream before the other shard's reads.
+	if (shard->owned > 1) {
+		thief = &shard_list[to];
+		stream = shard->heap[shard->owned - 1];
+		shard->owned = shard->owned - 1;
+		thief->inbox_lock.lock();
+		thief->inbox[thief->inbox_len] = stream;
+		thief->inbox_len = thief->inbox_len + 1;
+		thief->inbox_lock.unlock();
+		shard->settled.store(clock.now() + clock.frequency() * 
+			STREAM_SETTLE_MS / 1000, std::memory_order_relaxed);
+		++moved;
+	}
+	shard->steal_to.store(-1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Moves the streams handed to a shard into its heap, after which the
+//! shard settles for STREAM_SETTLE_MS. The mailbox is only locked when its
+//! length shows a stream waiting.
+//! @param index The index of the shard.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void StreamScheduler::adopt(uint32_t index) {
+
+	// Declare all relevant variables.
+	StreamShard* shard;
+	uint32_t i;
+
+	shard = &shard_list[index];
+	if (shard->inbox_len.load(std::memory_order_acquire) == 0) {
+		return;
+	}
+	shard->inbox_lock.lock();
+	for (i = 0; i < shard->inbox_len; ++i) {
+		shard->heap[shard->owned] = shard->inbox[i];
+		shard->owned = shard->owned + 1;
+		siftUp(shard, shard->owned - 1);
+	}
+	shard->inbox_len = 0;
+	shard->inbox_lock.unlock();
+	shard->settled.store(clock.now() + clock.frequency() * STREAM_SETTLE_MS /
+		1000, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Restores the heap order above an entry added at the bottom.
+//! @param owner The shard owning the heap.
+//! @param pos The position of the entry within the heap.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void StreamScheduler::siftUp(StreamShard* owner, uint32_t pos) {
+
+	// Declare all relevant variables.
+	uint32_t entry;
+	uint32_t parent;
+	int64_t deadline;
+
+	// Move the later parent down until the entry follows its parent.
+	entry = owner->heap[pos];
+	deadline = streams[entry].deadline;
+	while (pos > 0) {
+		parent = (pos - 1) / 2;
+		if (streams[owner->heap[parent]].deadline <= deadline) {
+			break;
+		}
+		owner->heap[pos] = owner->heap[parent];
+		pos = parent;
+	}
+	owner->heap[pos] = entry;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Restores the heap order below an entry whose deadline has advanced.
+//! @param owner The shard owning the heap.
+//! @param pos The position of the entry within the heap.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void StreamScheduler::siftDown(StreamShard* owner, uint32_t pos) {
+
+	// Declare all relevant variables.
+	uint32_t* heap;
+	uint32_t count;
+	uint32_t entry;
+	uint32_t child;
+	int64_t deadline;
+
+	// Move the earlier child up until the entry precedes both children.
+	heap = owner->heap;
+	count = owner->owned.load(std::memory_order_relaxed);
+	entry = heap[pos];
+	deadline = streams[entry].deadline;
+	for (child = 2 * pos + 1; child < count; child = 2 * pos + 1) {
+		if (child + 1 < count && streams[heap[child + 1]].deadline <
+			streams[heap[child]].deadline) {
+			++child;
+		}
+		if (deadline <= streams[heap[child]].deadline) {
+			break;
+		}
+		heap[pos] = heap[child];
+		pos = child;
+	}
+	heap[pos] = entry;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of streams.
+//! @return The number of streams added.
+//-----------------------------------------------------------------------------
+uint32_t StreamScheduler::count() {
+	return stream_count;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of packets sent by one stream.
+//! @param stream The index of the stream.
+//! @return The number of packets sent.
+//-----------------------------------------------------------------------------
+uint64_t StreamScheduler::sent(uint32_t stream) {
+	return stream_sent[stream].load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of packets sent by every stream.
+//! @return The sum of the packets sent by each stream.
+//-----------------------------------------------------------------------------
+uint64_t StreamScheduler::sent() {
+
+	// Declare all relevant variables.
+	uint64_t total;
+	uint32_t i;
+
+	total = 0;
+	for (i = 0; i < stream_count; ++i) {
+		total += sent(i);
+	}
+	return total;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of packets one stream failed to send.
+//! @param stream The index of the stream.
+//! @return The number of failed sends.
+//-----------------------------------------------------------------------------
+uint64_t StreamScheduler::errors(uint32_t stream) {
+	return stream_errors[stream].load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of packets every stream failed to send.
+//! @return The sum of the failed sends of each stream.
+//-----------------------------------------------------------------------------
+uint64_t StreamScheduler::errors() {
+
+	// Declare all relevant variables.
+	uint64_t total;
+	uint32_t i;
+
+	total = 0;
+	for (i = 0; i < stream_count; ++i) {
+		total += errors(i);
+	}
+	return total;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Takes a snapshot of the nanoseconds by which each packet missed its
+//! deadline, across every shard, which may be taken while the threads run.
+//! @param snap The snapshot to populate.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void StreamScheduler::lateness(HistogramSnapshot* snap) {
+
+	// Declare all relevant variables.
+	HistogramSnapshot* part;
+	uint32_t i;
+
+	// Sum the histograms of every shard, each recorded by its own thread.
+	part = new HistogramSnapshot();
+	shard_list[0].late_ns.snapshot(snap);
+	for (i = 1; i < shard_count; ++i) {
+		shard_list[i].late_ns.snapshot(part);
+		snap->add(*part);
+	}
+	delete part;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of shards.
+//! @return The number of shard threads.
+//-----------------------------------------------------------------------------
+uint32_t StreamScheduler::shards() {
+	return shard_count;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of streams owned by a shard.
+//! @param shard The index of the shard.
+//! @return The number of streams in the shard's heap.
+//-----------------------------------------------------------------------------
+uint32_t StreamScheduler::owned(uint32_t shard) {
+	return shard_list[shard].owned.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the number of streams moved between shards.
+//! @return The number of streams handed from one shard to another.
+//-----------------------------------------------------------------------------
+uint64_t StreamScheduler::migrations() {
+	return moved.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,324 @@
+#pragma once
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <WS2tcpip.h>
+#include <winsock2.h>
+#include "Packet.h"
+#include "Pacer.h"
+#include "Clock.h"
+#include "Timestamp.h"
+#include "LatencyHistogram.h"
+
+// Establish the globally accessible macros.
+#define STREAM_MAX 4096
+#define STREAM_POLL_MS 10
+#define STREAM_SHARDS_MAX 64
+#define STREAM_BEHIND_NS 50000
+#define STREAM_SLACK_US 200
+#define STREAM_SETTLE_MS 100
+
+//=============================================================================
+//! @struct StreamState
+//!
+//! @brief The state of one stream touched at each of its packets, kept 
+//! compact so that many streams share few cache lines. The address and the 
+//! statistics of each stream are kept apart.
+//=============================================================================
+struct StreamState {
+
+	//! The whole ticks of the next deadline.
+	int64_t deadline;
+
+	//! The whole ticks of the period.
+	int64_t period_ticks;
+
+	//! The fractional ticks of the next deadline, in units of 2^-32.
+	uint32_t deadline_frac;
+
+	//! The fractional ticks of the period, in units of 2^-32.
+	uint32_t period_frac;
+
+	//! The phase accumulator of the antenna, whose upper bits are the 
+	//! position.
+	uint64_t phase;
+
+	//! The phase increment of the antenna per period.
+	uint64_t step;
+
+	//! The sequence number of the next packet, wrapping at 24 bits.
+	uint32_t number;
+
+	//! The host words of every field which never changes, with the packet
+	//! number, IRIG time and antenna position cleared.
+	uint32_t words[PACKET_WORDS];
+};
+
+//=============================================================================
+//! @struct StreamShard
+//!
+//! @brief One worker of the scheduler, with its own thread, socket and heap
+//! of deadlines, along with the mailbox through which streams are moved to it
+//! from another shard.
+//=============================================================================
+struct StreamShard {
+
+	//! The indices of the streams owned by the shard, ordered as a binary 
+	//! min-heap on their deadlines.
+	uint32_t* heap;
+
+	//! The number of streams owned by the shard.
+	std::atomic<uint32_t> owned;
+
+	//! The socket over which the shard's streams are sent.
+	SOCKET sock;
+
+	//! A pointer to the shard's thread.
+	std::thread* thread;
+
+	//! The processor affinity of the thread, or zero to leave it unpinned.
+	uint64_t affinity;
+
+	//! The pacer sleeping until the shard's earliest deadline.
+	Pacer pacer;
+
+	//! The nanoseconds by which each packet of the shard missed its deadline.
+	LatencyHistogram late_ns;
+
+	//! A moving average of the lateness of the shard's recent packets, in
+	//! nanoseconds, by which other shards judge that it has fallen behind.
+	std::atomic<int64_t> behind;
+
+	//! The index of a shard asking to take one of this shard's streams, or 
+	//! -1 if none.
+	std::atomic<int32_t> steal_to;
+
+	//! The shard from which this shard has asked to take a stream, or -1 if
+	//! no request is outstanding.
+	int32_t steal_from;
+
+	//! The counter reading until which a stream moved to or from the shard 
+	//! is still settling, before which the shard neither asks for a stream
+	//! nor is asked for one.
+	std::atomic<int64_t> settled;
+
+	//! Guards the mailbox, which is touched only when a stream moves.
+	std::mutex inbox_lock;
+
+	//! The streams handed to this shard, awaiting adoption into its heap.
+	uint32_t* inbox;
+
+	//! The number of streams awaiting adoption.
+	std::atomic<uint32_t> inbox_len;
+};
+
+//=============================================================================
+//! @class StreamScheduler
+//!
+//! @brief Drives many simulated radars from a few threads. Each stream has
+//! its own sample, destination, period and rotation. The streams are split
+//! across shards, each a thread pinned to its own core, and each shard keeps
+//! the next deadline of its streams in a binary min-heap, so that it sleeps
+//! only until the earliest and releases every stream which has fallen due. 
+//! The deadlines are absolute, t0 + n * period, as in the Pacer. A shard with
+//! slack before its next deadline takes a stream from whichever shard has 
+//! fallen furthest behind, so that the load rebalances while it runs. Each
+//! move is followed by STREAM_SETTLE_MS in which neither shard takes part in
+//! another, so that a stream does not swing back and forth between them.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class StreamScheduler {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn StreamScheduler
+	//!
+	//! @brief Constructs a StreamScheduler instance.
+	//-------------------------------------------------------------------------
+	StreamScheduler(uint32_t shards = 1, uint64_t cores = 0);
+
+	//-------------------------------------------------------------------------
+	//! @fn ~StreamScheduler
+	//!
+	//! @brief Destroys a StreamScheduler instance.
+	//-------------------------------------------------------------------------
+	~StreamScheduler();
+
+	//-------------------------------------------------------------------------
+	//! @fn add
+	//!
+	//! @brief Adds a stream, which must precede init.
+	//-------------------------------------------------------------------------
+	int add(Packet smpl, const char* addr, int port, double packet_rate, 
+		double rotate_start, double rotate_rate);
+
+	//-------------------------------------------------------------------------
+	//! @fn init
+	//!
+	//! @brief Opens the sockets and starts the shard threads.
+	//-------------------------------------------------------------------------
+	int init();
+
+	//-------------------------------------------------------------------------
+	//! @fn uninit
+	//!
+	//! @brief Finishes the shard threads and closes the sockets.
+	//-------------------------------------------------------------------------
+	void uninit();
+
+	//-------------------------------------------------------------------------
+	//! @fn count
+	//!
+	//! @brief Returns the number of streams.
+	//-------------------------------------------------------------------------
+	uint32_t count();
+
+	//-------------------------------------------------------------------------
+	//! @fn sent
+	//!
+	//! @brief Returns the number of packets sent by one stream.
+	//-------------------------------------------------------------------------
+	uint64_t sent(uint32_t stream);
+
+	//-------------------------------------------------------------------------
+	//! @fn sent
+	//!
+	//! @brief Returns the number of packets sent by every stream.
+	//-------------------------------------------------------------------------
+	uint64_t sent();
+
+	//-------------------------------------------------------------------------
+	//! @fn errors
+	//!
+	//! @brief Returns the number of packets one stream failed to send.
+	//-------------------------------------------------------------------------
+	uint64_t errors(uint32_t stream);
+
+	//-------------------------------------------------------------------------
+	//! @fn errors
+	//!
+	//! @brief Returns the number of packets every stream failed to send.
+	//-------------------------------------------------------------------------
+	uint64_t errors();
+
+	//-------------------------------------------------------------------------
+	//! @fn lateness
+	//!
+	//! @brief Takes a snapshot of the nanoseconds by which each packet missed
+	//! its deadline, across every shard.
+	//-------------------------------------------------------------------------
+	void lateness(HistogramSnapshot* snap);
+
+	//-------------------------------------------------------------------------
+	//! @fn shards
+	//!
+	//! @brief Returns the number of shards.
+	//-------------------------------------------------------------------------
+	uint32_t shards();
+
+	//-------------------------------------------------------------------------
+	//! @fn owned
+	//!
+	//! @brief Returns the number of streams owned by a shard.
+	//-------------------------------------------------------------------------
+	uint32_t owned(uint32_t shard);
+
+	//-------------------------------------------------------------------------
+	//! @fn migrations
+	//!
+	//! @brief Returns the number of streams moved between shards.
+	//-------------------------------------------------------------------------
+	uint64_t migrations();
+private:
+
+	//-------------------------------------------------------------------------
+	//! @fn schedule
+	//!
+	//! @brief Releases each stream of a shard at its deadlines.
+	//-------------------------------------------------------------------------
+	void schedule(uint32_t shard);
+
+	//-------------------------------------------------------------------------
+	//! @fn release
+	//!
+	//! @brief Encodes and sends the next packet of a stream, and advances its
+	//! deadline.
+	//-------------------------------------------------------------------------
+	int64_t release(StreamShard* owner, uint32_t stream, int64_t current, 
+		uint32_t irig_ms);
+
+	//-------------------------------------------------------------------------
+	//! @fn steal
+	//!
+	//! @brief Asks the shard furthest behind for one of its streams.
+	//-------------------------------------------------------------------------
+	void steal(uint32_t shard);
+
+	//-------------------------------------------------------------------------
+	//! @fn handOff
+	//!
+	//! @brief Answers a request for one of a shard's streams.
+	//-------------------------------------------------------------------------
+	void handOff(uint32_t shard);
+
+	//-------------------------------------------------------------------------
+	//! @fn adopt
+	//!
+	//! @brief Moves the streams handed to a shard into its heap.
+	//-------------------------------------------------------------------------
+	void adopt(uint32_t shard);
+
+	//-------------------------------------------------------------------------
+	//! @fn siftUp
+	//!
+	//! @brief Restores the heap order above an entry added at the bottom.
+	//-------------------------------------------------------------------------
+	void siftUp(StreamShard* owner, uint32_t pos);
+
+	//-------------------------------------------------------------------------
+	//! @fn siftDown
+	//!
+	//! @brief Restores the heap order below an entry whose deadline has
+	//! advanced.
+	//-------------------------------------------------------------------------
+	void siftDown(StreamShard* owner, uint32_t pos);
+
+	//! A flag to restrict the operation of the shard threads.
+	std::atomic<bool> active_process;
+
+	//! The hot state of each stream, indexed by stream.
+	StreamState* streams;
+
+	//! The destination of each stream.
+	sockaddr_in* addresses;
+
+	//! The number of packets sent by each stream.
+	std::atomic<uint64_t>* stream_sent;
+
+	//! The number of packets each stream failed to send.
+	std::atomic<uint64_t>* stream_errors;
+
+	//! The number of streams.
+	uint32_t stream_count;
+
+	//! The workers among which the streams are split.
+	StreamShard* shard_list;
+
+	//! The number of shards.
+	uint32_t shard_count;
+
+	//! The number of streams moved between shards.
+	std::atomic<uint64_t> moved;
+
+	//! The clock by which the streams are paced and stamped.
+	Clock clock;
+
+	//! The IRIG time of each release.
+	Timestamp timestamp;
+
+	//! The nanoseconds elapsed per counter tick.
+	double ns_per_tick;
+};
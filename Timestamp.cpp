@@ -0,0 +1,147 @@
+#include "Timestamp.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Constructs a Timestamp instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+Timestamp::Timestamp() : uncertainty_ms(0), anchor_ticks(0), anchor_ms(0),
+	frequency(0), next_number(0) {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Anchors the performance counter to the wall clock, and restarts the
+//! sequence at the given number.
+//! @param first_number The sequence number of the first packet stamped.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Timestamp::anchor(uint32_t first_number) {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER freq;
+	LARGE_INTEGER before;
+	LARGE_INTEGER after;
+	FILETIME wall;
+	ULARGE_INTEGER hns;
+	int64_t best;
+	int i;
+
+	// Retrieve the counter frequency, which is fixed at boot.
+	QueryPerformanceFrequency(&freq);
+	frequency = freq.QuadPart;
+
+	// Bracket the wall clock between two counter readings, keeping the
+	// tightest of several attempts, so that a preemption between the reads
+	// cannot skew the anchor. The wall clock counts hundreds of nanoseconds
+	// since 1601, which began at midnight UTC.
+	best = INT64_MAX;
+	for (i = 0; i < TIMESTAMP_ANCHOR_TRIES; ++i) {
+		QueryPerformanceCounter(&before);
+		GetSystemTimePreciseAsFileTime(&wall);
+		QueryPerformanceCounter(&after);
+		if (after.QuadPart - before.QuadPart < best) {
+			best = after.QuadPart - before.QuadPart;
+			hns.LowPart = wall.dwLowDateTime;
+			hns.HighPart = wall.dwHighDateTime;
+			anchor_ticks = before.QuadPart + best / 2;
+			anchor_ms = (hns.QuadPart % ((uint64_t)IRIG_DAY_MS * 10000)) /
+				10000.0;
+		}
+	}
+	uncertainty_ms = best * 1000.0 / frequency;
+	next_number = first_number & PACKET_NUMBER_MASK;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Anchors a clock to the wall clock, and restarts the sequence at the
+//! given number. A simulated clock is anchored exactly, at its own IRIG time.
+//! @param clock The clock whose readings are to be stamped.
+//! @param first_number The sequence number of the first packet stamped.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Timestamp::anchor(Clock& clock, uint32_t first_number) {
+
+	// The performance counter is anchored by bracketing the wall clock.
+	if (!clock.simulated()) {
+		anchor(first_number);
+		return;
+	}
+
+	// The simulated counter carries its own IRIG time, without error.
+	frequency = clock.frequency();
+	anchor_ticks = clock.now();
+	anchor_ms = clock.wall(anchor_ticks);
+	uncertainty_ms = 0;
+	next_number = first_number & PACKET_NUMBER_MASK;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the IRIG time of the present instant.
+//! @return The UTC millisecond of the day.
+//-----------------------------------------------------------------------------
+uint32_t Timestamp::irig() {
+
+	// Declare all relevant variables.
+	LARGE_INTEGER counter;
+
+	QueryPerformanceCounter(&counter);
+	return irig(counter.QuadPart);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the IRIG time of a performance counter reading.
+//! @param ticks A performance counter reading taken after the anchor.
+//! @return The UTC millisecond of the day.
+//-----------------------------------------------------------------------------
+uint32_t Timestamp::irig(int64_t ticks) {
+
+	// Declare all relevant variables.
+	double ms;
+
+	// Extend the anchor by the elapsed ticks. A double holds a day of ticks
+	// to well under a microsecond, and the modulo by a constant reduces to a
+	// multiplication. The elapsed ticks are divided by the frequency rather
+	// than multiplied by its rounded reciprocal, so that a whole number of
+	// milliseconds never falls a hair short of itself.
+	ms = anchor_ms + (ticks - anchor_ticks) * 1000.0 / frequency;
+	if (ms < 0) {
+		ms = 0;
+	}
+	return (uint32_t)((uint64_t)ms % IRIG_DAY_MS);
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Writes the IRIG time and the next sequence number into the wire
+//! words of a packet.
+//! @param arr A pointer to the wire words of the packet.
+//! @param irig_ms The IRIG time of the packet, in milliseconds of the day.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void Timestamp::stamp(uint32_t* arr, uint32_t irig_ms) {
+
+	// Declare all relevant variables.
+	const uint32_t n = PACKET_LAYOUT[FIELD_PACKET_NUMBER].word;
+	const uint32_t t = PACKET_LAYOUT[FIELD_IRIG_TIME].word;
+	uint32_t words[PACKET_WORDS];
+
+	// Restore the host order of the two words, replace both fields, and
+	// return the words to the wire order.
+	words[n] = PacketLayout::fromWire(arr[n]);
+	words[t] = PacketLayout::fromWire(arr[t]);
+	PacketLayout::clear<FIELD_PACKET_NUMBER>(words);
+	PacketLayout::clear<FIELD_IRIG_TIME>(words);
+	PacketLayout::set<FIELD_PACKET_NUMBER>(words, next_number);
+	PacketLayout::set<FIELD_IRIG_TIME>(words, irig_ms);
+	arr[n] = PacketLayout::toWire(words[n]);
+	arr[t] = PacketLayout::toWire(words[t]);
+
+	// Advance the sequence, wrapping at the width of the field.
+	next_number = (next_number + 1) & PACKET_NUMBER_MASK;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the sequence number of the next packet to be stamped.
+//! @return The sequence number.
+//-----------------------------------------------------------------------------
+uint32_t Timestamp::sequence() {
+	return next_number;
+}
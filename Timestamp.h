@@ -0,0 +1,91 @@
+#pragma once
+
+#include "stdafx.h"
+#include "PacketLayout.h"
+#include "Clock.h"
+
+// Establish the globally accessible macros.
+#define TIMESTAMP_ANCHOR_TRIES 16
+
+//=============================================================================
+//! @class Timestamp
+//!
+//! @brief Stamps each packet with its IRIG time and sequence number at the
+//! moment of transmission. The time is read from the performance counter,
+//! which is anchored to the UTC wall clock once, so that no packet calls into
+//! the system clock.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class Timestamp {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn Timestamp
+	//!
+	//! @brief Constructs a Timestamp instance.
+	//-------------------------------------------------------------------------
+	Timestamp();
+
+	//-------------------------------------------------------------------------
+	//! @fn anchor
+	//!
+	//! @brief Anchors the performance counter to the wall clock, and restarts
+	//! the sequence at the given number.
+	//-------------------------------------------------------------------------
+	void anchor(uint32_t first_number = 0);
+
+	//-------------------------------------------------------------------------
+	//! @fn anchor
+	//!
+	//! @brief Anchors a clock to the wall clock, and restarts the sequence at
+	//! the given number.
+	//-------------------------------------------------------------------------
+	void anchor(Clock& clock, uint32_t first_number = 0);
+
+	//-------------------------------------------------------------------------
+	//! @fn irig
+	//!
+	//! @brief Returns the IRIG time of the present instant.
+	//-------------------------------------------------------------------------
+	uint32_t irig();
+
+	//-------------------------------------------------------------------------
+	//! @fn irig
+	//!
+	//! @brief Returns the IRIG time of a performance counter reading.
+	//-------------------------------------------------------------------------
+	uint32_t irig(int64_t ticks);
+
+	//-------------------------------------------------------------------------
+	//! @fn stamp
+	//!
+	//! @brief Writes the IRIG time and the next sequence number into the wire
+	//! words of a packet.
+	//-------------------------------------------------------------------------
+	void stamp(uint32_t* arr, uint32_t irig_ms);
+
+	//-------------------------------------------------------------------------
+	//! @fn sequence
+	//!
+	//! @brief Returns the sequence number of the next packet to be stamped.
+	//-------------------------------------------------------------------------
+	uint32_t sequence();
+
+	//! The width of the tightest bracket about the wall clock reading, in
+	//! milliseconds, bounding the error of the anchor.
+	double uncertainty_ms;
+private:
+
+	//! The performance counter reading at the anchor.
+	int64_t anchor_ticks;
+
+	//! The UTC millisecond of the day at the anchor, with its fraction.
+	double anchor_ms;
+
+	//! The frequency of the counter, in ticks per second.
+	int64_t frequency;
+
+	//! The sequence number of the next packet, wrapping at 24 bits.
+	uint32_t next_number;
+};
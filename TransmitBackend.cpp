@@ -0,0 +1,42 @@
+#include "TransmitBackend.h"
+#include "SocketBackend.h"
+#include "RioBackend.h"
+#include "SharedBackend.h"
+
+//-----------------------------------------------------------------------------
+//! @brief Destroys a TransmitBackend instance.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+TransmitBackend::~TransmitBackend() {
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Creates a backend of the requested kind.
+//! @param kind The kind of backend, BACKEND_SOCKET, BACKEND_RIO or 
+//! BACKEND_SHARED.
+//! @return The unopened backend, or a socket backend for an unknown kind.
+//-----------------------------------------------------------------------------
+TransmitBackend* TransmitBackend::create(uint32_t kind) {
+	if (kind == BACKEND_RIO) {
+		return new RioBackend();
+	}
+	if (kind == BACKEND_SHARED) {
+		return new SharedBackend();
+	}
+	return new SocketBackend();
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Returns the name of a kind of backend.
+//! @param kind The kind of backend.
+//! @return The name, as reported by the benchmarks.
+//-----------------------------------------------------------------------------
+const char* TransmitBackend::name(uint32_t kind) {
+	if (kind == BACKEND_RIO) {
+		return "rio";
+	}
+	if (kind == BACKEND_SHARED) {
+		return "shared";
+	}
+	return "socket";
+}
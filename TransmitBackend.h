@@ -0,0 +1,103 @@
+#pragma once
+
+#include "stdafx.h"
+#include <WS2tcpip.h>
+#include <winsock2.h>
+#include <atomic>
+#include "PacketRing.h"
+#include "LatencyHistogram.h"
+
+// Establish the globally accessible macros.
+#define BACKEND_SOCKET 0
+#define BACKEND_RIO 1
+#define BACKEND_SHARED 2
+#define BACKEND_COUNT 3
+#define DEST_MAX 64
+
+//=============================================================================
+//! @struct Destination
+//!
+//! @brief One receiver of the transmitted packets, with the counts of the 
+//! packets sent to it and of those whose send failed.
+//=============================================================================
+struct Destination {
+
+	//! The address of the receiver.
+	sockaddr_in address;
+
+	//! The number of packets sent to the receiver.
+	std::atomic<uint64_t> sent;
+
+	//! The number of packets whose send to the receiver failed.
+	std::atomic<uint64_t> errors;
+};
+
+//=============================================================================
+//! @class TransmitBackend
+//!
+//! @brief The means by which the transmitter hands its packets to the 
+//! network. Each batch released by the Pacer is passed to send as a run of
+//! published slots at the front of the ring, which the transmitter releases
+//! once send returns, so a backend sending asynchronously must copy the 
+//! packets out first. Every packet is sent to each destination in turn, 
+//! encoded only once, and the backend counts the packets sent to each and
+//! those whose send failed. Consecutive packets may be packed together into
+//! frames of up to FRAME_PACKETS. Backends are selected at run time by kind.
+//!
+//! @addToGroup eGRIM
+//=============================================================================
+class TransmitBackend {
+public:
+
+	//-------------------------------------------------------------------------
+	//! @fn ~TransmitBackend
+	//!
+	//! @brief Destroys a TransmitBackend instance.
+	//-------------------------------------------------------------------------
+	virtual ~TransmitBackend();
+
+	//-------------------------------------------------------------------------
+	//! @fn open
+	//!
+	//! @brief Prepares the backend to send to a list of destinations.
+	//-------------------------------------------------------------------------
+	virtual int open(SOCKET sock, Destination* destinations, uint32_t 
+		destination_count, uint32_t batch_size, uint32_t aggregate, 
+		LatencyHistogram* skew) = 0;
+
+	//-------------------------------------------------------------------------
+	//! @fn send
+	//!
+	//! @brief Sends packets from the front of the ring.
+	//-------------------------------------------------------------------------
+	virtual void send(PacketRing* ring, uint32_t count) = 0;
+
+	//-------------------------------------------------------------------------
+	//! @fn close
+	//!
+	//! @brief Finishes any outstanding sends and frees the backend's 
+	//! resources.
+	//-------------------------------------------------------------------------
+	virtual void close() = 0;
+
+	//-------------------------------------------------------------------------
+	//! @fn kind
+	//!
+	//! @brief Returns the kind of the backend.
+	//-------------------------------------------------------------------------
+	virtual uint32_t kind() = 0;
+
+	//-------------------------------------------------------------------------
+	//! @fn create
+	//!
+	//! @brief Creates a backend of the requested kind.
+	//-------------------------------------------------------------------------
+	static TransmitBackend* create(uint32_t kind);
+
+	//-------------------------------------------------------------------------
+	//! @fn name
+	//!
+	//! @brief Returns the name of a kind of backend.
+	//-------------------------------------------------------------------------
+	static const char* name(uint32_t kind);
+};
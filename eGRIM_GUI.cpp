@@ -1,6 +1,9 @@
 ﻿#include "stdafx.h"
 #include "eGRIM_GUI.h"
 #include "SampleGenerator.h"
+#include "Benchmark.h"
+#include "PacketReceiver.h"
+#include "RateCalibrator.h"
 
 //=============================================================================
 //! @subsection Global Macros
@@ -12,6 +15,15 @@
 //! Define the largest size for the load string value.
 #define MAX_LOADSTRING 100
 
+//! Define the file into which packets are recorded, and replayed from.
+#define EGRIM_RECORDING L"eGRIM_recording.egr"
+
+//! Define the file to which each calibration curve is appended.
+#define EGRIM_CALIBRATION L"eGRIM_calibration.jsonl"
+
+//! Define the script of field changes followed by the generator, if present.
+#define EGRIM_TIMELINE L"eGRIM_timeline.txt"
+
 //=============================================================================
 //! @subsection Global Variables
 //!
@@ -25,6 +37,18 @@ HINSTANCE hInst;
 //! A pointer to the sample generation and transmission object.
 SampleGenerator* generator = NULL;
 
+//! A pointer to the loopback receiving and validation object.
+PacketReceiver* receiver = NULL;
+
+//! A pointer to the generator replaying a recording.
+SampleGenerator* replayer = NULL;
+
+//! The file to which the generator metrics are dumped while it runs.
+FILE* metric_file = NULL;
+
+//! A pointer to the search for the highest loss-free rate.
+RateCalibrator* calibrator = NULL;
+
 //! A character string representing the title bars.
 WCHAR szTitle[MAX_LOADSTRING];
 
@@ -42,6 +66,12 @@ BOOL InitInstance(HINSTANCE, int);
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK About(HWND, UINT, WPARAM, LPARAM);
 LRESULT CALLBACK eGrimProc(HWND);
+LRESULT CALLBACK eGrimListen(HWND);
+LRESULT CALLBACK eGrimReplay(HWND);
+LRESULT CALLBACK eGrimApply(HWND);
+LRESULT CALLBACK eGrimCalibrate(HWND);
+void eGrimCalibrated(HWND);
+void eGrimStats(HWND);
 
 //=============================================================================
 //! @fn wWinMain
@@ -67,7 +97,14 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE
 
 	// Establish the unreferenced parameters.
 	UNREFERENCED_PARAMETER(hPrevInstance);
-	UNREFERENCED_PARAMETER(lpCmdLine);
+
+	// Run the benchmarks in place of the interface if requested on the 
+	// command line, as "/bench [output.json]".
+	if (!wcsncmp(lpCmdLine, L"/bench", 6)) {
+		Benchmark bench;
+		return bench.report(lpCmdLine[6] == L' ' ? lpCmdLine + 7 :
+			L"eGRIM_bench.json");
+	}
 
 	// Initialize the global strings within the application.
 	LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
@@ -142,13 +179,19 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow) {
 	HWND ipad;
 	HWND port;
 	HWND bttn;
+	HWND lstn;
+	HWND stat;
+	HWND rcrd;
+	HWND rply;
+	HWND aply;
+	HWND clbr;
 
 	// Establish a global handle to the object instance.
 	hInst = hInstance;
 
 	// Create the main window object, returning false if nothing exists.
 	hwnd = CreateWindowW(szWindowClass, szTitle, WS_OVERLAPPEDWINDOW,
-		CW_USEDEFAULT, 0, 230, 225, NULL, NULL, hInstance, NULL);
+		CW_USEDEFAULT, 0, 230, 410, NULL, NULL, hInstance, NULL);
 	if (!hwnd) {
 		return FALSE;
 	}
@@ -188,7 +231,26 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow) {
 	bttn = CreateWindow(TEXT("button"), TEXT("Generate"), WS_VISIBLE |
 		WS_CHILD, 110, 140, 95, 20, hwnd, (HMENU) IDC_GEN_BUTTON, hInstance, 
 		NULL);
-	if (!qlen || !txrt || !rtrt || !ipad || !port || !bttn) {
+	lstn = CreateWindow(TEXT("button"), TEXT("Listen"), WS_VISIBLE | 
+		WS_CHILD, 10, 140, 95, 20, hwnd, (HMENU) IDC_RECV_BUTTON, hInstance,
+		NULL);
+	stat = CreateWindow(TEXT("static"), TEXT(""), WS_CHILD | WS_VISIBLE | 
+		SS_LEFT | WS_BORDER, 10, 170, 195, 120, hwnd, (HMENU) IDC_RECV_STATS,
+		hInstance, NULL);
+	rcrd = CreateWindow(TEXT("button"), TEXT("Record"), WS_VISIBLE | WS_CHILD
+		| BS_AUTOCHECKBOX, 10, 300, 95, 20, hwnd, (HMENU) IDC_RECORD_CHECK, 
+		hInstance, NULL);
+	rply = CreateWindow(TEXT("button"), TEXT("Replay"), WS_VISIBLE | 
+		WS_CHILD, 110, 300, 95, 20, hwnd, (HMENU) IDC_REPLAY_BUTTON, 
+		hInstance, NULL);
+	aply = CreateWindow(TEXT("button"), TEXT("Apply"), WS_VISIBLE | 
+		WS_CHILD, 110, 325, 95, 20, hwnd, (HMENU) IDC_APPLY_BUTTON, 
+		hInstance, NULL);
+	clbr = CreateWindow(TEXT("button"), TEXT("Calibrate"), WS_VISIBLE | 
+		WS_CHILD, 10, 325, 95, 20, hwnd, (HMENU) IDC_CALIB_BUTTON, 
+		hInstance, NULL);
+	if (!qlen || !txrt || !rtrt || !ipad || !port || !bttn || !lstn || 
+		!stat || !rcrd || !rply || !aply || !clbr) {
 		return false;
 	}
 
@@ -227,6 +289,14 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM
 			break;
 		case IDC_GEN_BUTTON:
 			return eGrimProc(hwnd);
+		case IDC_RECV_BUTTON:
+			return eGrimListen(hwnd);
+		case IDC_REPLAY_BUTTON:
+			return eGrimReplay(hwnd);
+		case IDC_APPLY_BUTTON:
+			return eGrimApply(hwnd);
+		case IDC_CALIB_BUTTON:
+			return eGrimCalibrate(hwnd);
 		case IDM_EXIT:
 			DestroyWindow(hwnd);
 			break;
@@ -244,8 +314,45 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM
 		break;
 	}
 
-	// Process a message to close the window and its children.
+	// Process a timer message to refresh the receiver statistics, to dump
+	// the generator metrics, or to collect a finished calibration.
+	case WM_TIMER: {
+		if (wParam == IDT_RECV_TIMER) {
+			eGrimStats(hwnd);
+		}
+		else if (wParam == IDT_METRIC_TIMER && metric_file != NULL) {
+			generator->dump(metric_file);
+		}
+		else if (wParam == IDT_CALIB_TIMER && calibrator != NULL && 
+			calibrator->finished()) {
+			eGrimCalibrated(hwnd);
+		}
+		break;
+	}
+
+	// Process a message to close the window and its children, stopping the
+	// receiver, replay and calibration should any still be running, and 
+	// closing the metric file.
 	case WM_DESTROY: {
+		if (receiver != NULL) {
+			KillTimer(hwnd, IDT_RECV_TIMER);
+			delete receiver;
+			receiver = NULL;
+		}
+		if (metric_file != NULL) {
+			KillTimer(hwnd, IDT_METRIC_TIMER);
+			fclose(metric_file);
+			metric_file = NULL;
+		}
+		if (replayer != NULL) {
+			delete replayer;
+			replayer = NULL;
+		}
+		if (calibrator != NULL) {
+			KillTimer(hwnd, IDT_CALIB_TIMER);
+			delete calibrator;
+			calibrator = NULL;
+		}
 		PostQuitMessage(0);
 		break;
 	}
@@ -309,6 +416,7 @@ LRESULT CALLBACK eGrimProc(HWND hwnd) {
 	TCHAR* ip_tchar;
 	char* ip_addr;
 	uint32_t comm_port;
+	int err;
 
 	// Initialize various character arrays.
 	message = new TCHAR[32];
@@ -385,29 +493,411 @@ LRESULT CALLBACK eGrimProc(HWND hwnd) {
 		// address and communication port.
 		generator = new SampleGenerator(ip_addr, comm_port);
 
+		// Record the transmitted packets, if requested, warning should the 
+		// recording be unavailable rather than withholding the packets.
+		if (IsDlgButtonChecked(hwnd, IDC_RECORD_CHECK) == BST_CHECKED) {
+			err = generator->setRecording(EGRIM_RECORDING);
+			if (err != 0) {
+				_stprintf_s(message, 32, TEXT("File Error: %d"), err);
+				MessageBox(NULL, message, TEXT("Recording: Unavailable!"), 
+					MB_OK | MB_ICONEXCLAMATION);
+			}
+		}
+
+		// Follow the script of field changes, should one be present, warning
+		// of the line at fault should it not be understood.
+		err = generator->setTimeline(EGRIM_TIMELINE);
+		if (err == ERROR_BAD_FORMAT) {
+			_stprintf_s(message, 32, TEXT("Line: %u"), 
+				generator->script().error_line);
+			MessageBox(NULL, message, TEXT("Timeline: Not Understood!"), 
+				MB_OK | MB_ICONEXCLAMATION);
+		}
+
 		// Initialize the packet generation and transfer threads.
 		generator->init(queue_len, trx_rate, rot_start, rot_rate);
 
+		// Dump the generator metrics once a second, appending to any earlier
+		// runs. The generator runs regardless should the file be unavailable.
+		if (_wfopen_s(&metric_file, L"eGRIM_metrics.jsonl", L"a") != 0) {
+			metric_file = NULL;
+		}
+		SetTimer(hwnd, IDT_METRIC_TIMER, 1000, NULL);
+
 		// Change the text on the pushbutton to signify process termination.
 		SetDlgItemText(hwnd, IDC_GEN_BUTTON, TEXT("Terminate"));
 	}
 	else {
 
-		// Terminate the packet generation and transfer threads.
+		// Terminate the packet generation and transfer threads, then dump the
+		// final metrics of the run.
+		KillTimer(hwnd, IDT_METRIC_TIMER);
 		generator->uninit();
+		if (metric_file != NULL) {
+			generator->dump(metric_file);
+			fclose(metric_file);
+			metric_file = NULL;
+		}
 
 		// Free the existing generator object.
-		free(generator);
+		delete generator;
+		generator = NULL;
 
 		// Change the text on the pushbutton to signify starting the process.
 		SetDlgItemText(hwnd, IDC_GEN_BUTTON, TEXT("Generate"));
 	}
 
 	// Free the arrays of values
-	free(message);
-	free(ip_tchar);
-	free(ip_addr);
+	delete[] message;
+	delete[] ip_tchar;
+	delete[] ip_addr;
+
+	// Return successful.
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Processes the listen pushbutton, starting or stopping a receiver
+//! which validates the packets arriving at the address and port given for
+//! the generator.
+//! @param hwnd A handle to the main window object.
+//! @return A zero value, if successful, negative otherwise.
+//-----------------------------------------------------------------------------
+LRESULT CALLBACK eGrimListen(HWND hwnd) {
+
+	// Declare all relevant variables.
+	TCHAR message[32];
+	TCHAR ip_tchar[32];
+	char ip_addr[32];
+	uint32_t comm_port;
+	int err;
+
+	// Retrieve the pushbutton text, establishing whether the button prompt
+	// requests the receiver be started or stopped.
+	GetDlgItemText(hwnd, IDC_RECV_BUTTON, message, 32);
+	if (!_tcscmp(message, TEXT("Listen"))) {
+
+		// Retrieve the IP address from the figure, converting it to a 
+		// standard character array.
+		GetDlgItemText(hwnd, IDC_IP_ADDR, ip_tchar, 32);
+		if (sizeof(TCHAR) != sizeof(char)) {
+			wcstombs_s(NULL, ip_addr, 32, (wchar_t*)ip_tchar, 32);
+		}
+		else {
+			strcpy_s(ip_addr, 32, (char*)ip_tchar);
+		}
+
+		// Retrieve the communication port from the figure, checking that it 
+		// is within range.
+		GetDlgItemText(hwnd, IDC_PORT, message, 32);
+		comm_port = _ttoi(message);
+		if (comm_port < 1024 || comm_port > 49151) {
+			MessageBox(NULL, TEXT("Acceptable Range: [1024, 49151]"),
+				TEXT("Communication Port: Out of Bounds!"), MB_OK |
+				MB_ICONEXCLAMATION);
+			return -1;
+		}
+
+		// Create and start the receiver, reporting any socket error.
+		receiver = new PacketReceiver(ip_addr, comm_port);
+		err = receiver->init();
+		if (err != 0) {
+			delete receiver;
+			receiver = NULL;
+			_stprintf_s(message, 32, TEXT("Socket Error: %d"), err);
+			MessageBox(NULL, message, TEXT("Receiver: Unable to Listen!"), 
+				MB_OK | MB_ICONEXCLAMATION);
+			return -1;
+		}
+
+		// Refresh the statistics twice each second, and change the text on 
+		// the pushbutton to signify stopping the receiver.
+		SetTimer(hwnd, IDT_RECV_TIMER, 500, NULL);
+		SetDlgItemText(hwnd, IDC_RECV_BUTTON, TEXT("Stop"));
+	}
+	else {
+
+		// Stop the refresh, present the final statistics, and free the 
+		// receiver.
+		KillTimer(hwnd, IDT_RECV_TIMER);
+		receiver->uninit();
+		eGrimStats(hwnd);
+		delete receiver;
+		receiver = NULL;
+
+		// Change the text on the pushbutton to signify starting the receiver.
+		SetDlgItemText(hwnd, IDC_RECV_BUTTON, TEXT("Listen"));
+	}
+
+	// Return successful.
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Processes the replay pushbutton, starting or stopping a replay of
+//! the recorded packets, at their recorded timing, to the address and port 
+//! given for the generator.
+//! @param hwnd A handle to the main window object.
+//! @return A zero value, if successful, negative otherwise.
+//-----------------------------------------------------------------------------
+LRESULT CALLBACK eGrimReplay(HWND hwnd) {
+
+	// Declare all relevant variables.
+	TCHAR message[32];
+	TCHAR ip_tchar[32];
+	char ip_addr[32];
+	uint32_t comm_port;
+	int err;
+
+	// Retrieve the pushbutton text, establishing whether the button prompt
+	// requests the replay be started or stopped.
+	GetDlgItemText(hwnd, IDC_REPLAY_BUTTON, message, 32);
+	if (!_tcscmp(message, TEXT("Replay"))) {
+
+		// Retrieve the IP address from the figure, converting it to a 
+		// standard character array.
+		GetDlgItemText(hwnd, IDC_IP_ADDR, ip_tchar, 32);
+		if (sizeof(TCHAR) != sizeof(char)) {
+			wcstombs_s(NULL, ip_addr, 32, (wchar_t*)ip_tchar, 32);
+		}
+		else {
+			strcpy_s(ip_addr, 32, (char*)ip_tchar);
+		}
+
+		// Retrieve the communication port from the figure, checking that it 
+		// is within range.
+		GetDlgItemText(hwnd, IDC_PORT, message, 32);
+		comm_port = _ttoi(message);
+		if (comm_port < 1024 || comm_port > 49151) {
+			MessageBox(NULL, TEXT("Acceptable Range: [1024, 49151]"),
+				TEXT("Communication Port: Out of Bounds!"), MB_OK |
+				MB_ICONEXCLAMATION);
+			return -1;
+		}
+
+		// Create a generator and start the replay, reporting any file error.
+		replayer = new SampleGenerator(ip_addr, comm_port);
+		err = replayer->replay(EGRIM_RECORDING, true);
+		if (err != 0) {
+			delete replayer;
+			replayer = NULL;
+			_stprintf_s(message, 32, TEXT("File Error: %d"), err);
+			MessageBox(NULL, message, TEXT("Replay: Unable to Open!"), 
+				MB_OK | MB_ICONEXCLAMATION);
+			return -1;
+		}
+
+		// Change the text on the pushbutton to signify stopping the replay.
+		SetDlgItemText(hwnd, IDC_REPLAY_BUTTON, TEXT("Stop"));
+	}
+	else {
+
+		// Stop the replay, should it not have finished, and free it.
+		replayer->uninit();
+		delete replayer;
+		replayer = NULL;
+
+		// Change the text on the pushbutton to signify starting the replay.
+		SetDlgItemText(hwnd, IDC_REPLAY_BUTTON, TEXT("Replay"));
+	}
+
+	// Return successful.
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Processes the apply pushbutton, changing the transmission and 
+//! rotation rates of the running generator without stopping it.
+//! @param hwnd A handle to the main window object.
+//! @return A zero value, if successful, negative otherwise.
+//-----------------------------------------------------------------------------
+LRESULT CALLBACK eGrimApply(HWND hwnd) {
+
+	// Declare all relevant variables.
+	TCHAR message[32];
+	double trx_rate;
+	double rot_rate;
+
+	// Only a running generator may be changed.
+	if (generator == NULL) {
+		return -1;
+	}
+
+	// Retrieve the transmission rate from the figure, checking that it is 
+	// within range.
+	GetDlgItemText(hwnd, IDC_TRX_RATE, message, 32);
+	trx_rate = _ttof(message);
+	if (trx_rate < 0 || trx_rate > 10) {
+		MessageBox(NULL, TEXT("Acceptable Range: [0, 10]"), TEXT("Transmission "
+			"Rate: Out of Bounds!"), MB_OK | MB_ICONEXCLAMATION);
+		return -1;
+	}
+
+	// Retrieve the rotation rate from the figure, checking that it is within
+	// range.
+	GetDlgItemText(hwnd, IDC_ROT_RATE, message, 32);
+	rot_rate = _ttof(message);
+	if (rot_rate < 0 || rot_rate > 60) {
+		MessageBox(NULL, TEXT("Acceptable Range: [0, 60]"), TEXT("Rotation "
+			"Rate: Out of Bounds!"), MB_OK | MB_ICONEXCLAMATION);
+		return -1;
+	}
+
+	// Hand the new rates to the generator, which adopts them at its next 
+	// packet.
+	generator->reconfigure(trx_rate, rot_rate);
+
+	// Return successful.
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Processes the calibrate pushbutton, starting or cancelling a search
+//! for the highest rate which the link carries back to a receiver at the 
+//! address and port given for the generator without loss. The search runs on
+//! its own thread, and is collected by a timer once finished. Neither the 
+//! generator nor the receiver may be running, since the probes use the same
+//! address and port.
+//! @param hwnd A handle to the main window object.
+//! @return A zero value, if successful, negative otherwise.
+//-----------------------------------------------------------------------------
+LRESULT CALLBACK eGrimCalibrate(HWND hwnd) {
+
+	// Declare all relevant variables.
+	TCHAR message[32];
+	TCHAR ip_tchar[32];
+	char ip_addr[32];
+	uint32_t queue_len;
+	uint32_t comm_port;
+
+	// Retrieve the pushbutton text, establishing whether the button prompt
+	// requests the calibration be started or cancelled.
+	GetDlgItemText(hwnd, IDC_CALIB_BUTTON, message, 32);
+	if (!_tcscmp(message, TEXT("Calibrate"))) {
+
+		// The probes would contend with a running generator or receiver.
+		if (generator != NULL || receiver != NULL || replayer != NULL) {
+			MessageBox(NULL, TEXT("Stop the generator, receiver and replay "
+				"first."), TEXT("Calibration: Link Busy!"), MB_OK | 
+				MB_ICONEXCLAMATION);
+			return -1;
+		}
+
+		// Retrieve the queue length from the figure, checking that it is 
+		// within range.
+		GetDlgItemText(hwnd, IDC_QUEUE_LEN, message, 32);
+		queue_len = _ttoi(message);
+		if (queue_len < 1 || queue_len > 100) {
+			MessageBox(NULL, TEXT("Acceptable Range: [1, 100]"), TEXT("Queue "
+				"Length: Out of Bounds!"), MB_OK | MB_ICONEXCLAMATION);
+			return -1;
+		}
+
+		// Retrieve the IP address from the figure, converting it to a 
+		// standard character array.
+		GetDlgItemText(hwnd, IDC_IP_ADDR, ip_tchar, 32);
+		if (sizeof(TCHAR) != sizeof(char)) {
+			wcstombs_s(NULL, ip_addr, 32, (wchar_t*)ip_tchar, 32);
+		}
+		else {
+			strcpy_s(ip_addr, 32, (char*)ip_tchar);
+		}
+
+		// Retrieve the communication port from the figure, checking that it 
+		// is within range.
+		GetDlgItemText(hwnd, IDC_PORT, message, 32);
+		comm_port = _ttoi(message);
+		if (comm_port < 1024 || comm_port > 49151) {
+			MessageBox(NULL, TEXT("Acceptable Range: [1024, 49151]"),
+				TEXT("Communication Port: Out of Bounds!"), MB_OK |
+				MB_ICONEXCLAMATION);
+			return -1;
+		}
+
+		// Start the search, checking twice each second whether it finished,
+		// and change the text on the pushbutton to signify cancelling it.
+		calibrator = new RateCalibrator(ip_addr, comm_port, comm_port);
+		calibrator->start(queue_len);
+		SetTimer(hwnd, IDT_CALIB_TIMER, 500, NULL);
+		SetDlgItemText(hwnd, IDC_CALIB_BUTTON, TEXT("Cancel"));
+	}
+	else {
+
+		// Cancel the search, keeping the probes already complete.
+		eGrimCalibrated(hwnd);
+	}
 
 	// Return successful.
 	return 0;
 }
+
+//-----------------------------------------------------------------------------
+//! @brief Collects a finished or cancelled calibration, appending its curve 
+//! to the calibration file, and presents the highest loss-free rate, whose 
+//! period is placed into the transmission rate figure.
+//! @param hwnd A handle to the main window object.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void eGrimCalibrated(HWND hwnd) {
+
+	// Declare all relevant variables.
+	TCHAR text[128];
+	FILE* curve_file;
+	double best;
+
+	// Join the calibration thread, and append the curve as a single line.
+	KillTimer(hwnd, IDT_CALIB_TIMER);
+	calibrator->stop();
+	if (_wfopen_s(&curve_file, EGRIM_CALIBRATION, L"a") == 0) {
+		calibrator->write(curve_file, "calibration");
+		fprintf(curve_file, "\n");
+		fclose(curve_file);
+	}
+
+	// Present the result, offering its period for the next run.
+	best = calibrator->best();
+	if (best > 0) {
+		_stprintf_s(text, 32, TEXT("%.9f"), 1.0 / best);
+		SetDlgItemText(hwnd, IDC_TRX_RATE, text);
+	}
+	_stprintf_s(text, 128, TEXT("Highest Loss-Free Rate: %.0f pps\nProbes: "
+		"%u"), best, calibrator->points());
+	MessageBox(NULL, text, TEXT("Calibration: Complete"), MB_OK | 
+		MB_ICONINFORMATION);
+	delete calibrator;
+	calibrator = NULL;
+
+	// Change the text on the pushbutton to signify starting a calibration.
+	SetDlgItemText(hwnd, IDC_CALIB_BUTTON, TEXT("Calibrate"));
+}
+
+//-----------------------------------------------------------------------------
+//! @brief Presents the statistics of the running receiver.
+//! @param hwnd A handle to the main window object.
+//! @return Nothing.
+//-----------------------------------------------------------------------------
+void eGrimStats(HWND hwnd) {
+
+	// Declare all relevant variables.
+	TCHAR text[256];
+	uint32_t mode;
+	uint32_t i;
+
+	// Find the most populated inter-arrival bucket.
+	mode = 0;
+	for (i = 1; i < RECV_BUCKETS; ++i) {
+		if (receiver->histogram(i) > receiver->histogram(mode)) {
+			mode = i;
+		}
+	}
+
+	// Format each statistic on its own line.
+	_stprintf_s(text, 256, TEXT("Received: %llu\nLost: %llu\nReordered: "
+		"%llu\nPosition Jumps: %llu\nJitter: %.1f us\nLatency Max: %lld ms\n"
+		"Typical Gap: < %u us"), (unsigned long long)receiver->received.load(),
+		(unsigned long long)receiver->lost.load(), (unsigned long long)
+		receiver->reordered.load(), (unsigned long long)
+		receiver->position_jumps.load(), receiver->jitter_ns.load() / 1000.0,
+		(long long)receiver->latency_max_ms.load(), 1u << mode);
+	SetDlgItemText(hwnd, IDC_RECV_STATS, text);
+}